@@ -1,15 +1,53 @@
 #version 450 core
 
 uniform vec3 diffColor;
+uniform sampler1D transferFunction;
 in vec4 passWorldPos;
 in vec4 passPos;
 in vec4 tangent;
 in vec2 passUV;
 
-out vec4 frag_Color;
+flat in uvec2 passID;
+flat in float passScalar;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
 float pi = 3.1415926535897;
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
+
 void main()  
 {
+	frag_ID = passID;
+	//the mapped scalar of the instance replaces the color of the structure
+	vec3 instanceColor = passScalar < 0.0f ? diffColor : texture(transferFunction, passScalar).rgb;
 	vec3 lightDir = vec3(0.577f, 0.577f, 0.577f);
 	vec3 lightColor = vec3(1.0f,1.0f,1.0f);
 	vec3 baseColor = vec3(0.1f,0.1f,0.1f);
@@ -29,9 +67,18 @@ void main()
 	float cos_psi_n = pow(max(dot(reflection, eye), 0.0f), 15);
 	float diffuseShade = max(0.0f, dot(passNormal, normalize(lightDir)));
 
+	//light blocked by other structures, the helix normal is not a surface normal, offset towards the light instead
+	float shadow = shadowFactor(passPos.xyz, lightDirection);
+	diffuseShade *= shadow;
+	cos_psi_n *= shadow;
+
 	//sum up colors
 	frag_Color.rgb = baseColor;
-	frag_Color.rgb += diffColor * vec3(diffuseShade, diffuseShade, diffuseShade) * lightColor;
+	frag_Color.rgb += instanceColor * vec3(diffuseShade, diffuseShade, diffuseShade) * lightColor;
 	frag_Color.rgb += specColor * cos_psi_n * lightColor;
 	frag_Color.a  =1.0f;
+	if(shadingMode == 1)
+	{
+		frag_Color.rgb = toneShade(instanceColor * 0.25f, diffuseShade + cos_psi_n, gl_FragCoord.xy / toneScale);
+	}
 }
\ No newline at end of file
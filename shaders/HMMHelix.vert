@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout (location = 0) in vec4 Position;
 uniform mat4 viewMatrix;
@@ -7,8 +8,18 @@ uniform mat4 rotationMatrix;
 uniform mat4 secondHalfRotationMatrix;
 uniform int numLineSegments;
 uniform float radius;
+//first instance of this structure in the mapped scalars, -1 = colored by diffColor
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
+//0 = the points are expanded every frame, 1 = expanded and stored in the cache, 2 = read from the cache
+uniform int cacheMode;
+//first vertex of this helix in the cache
+uniform int cacheOffset;
 out vec4 passPos_G;
 flat out float passRadius_G;
+flat out uvec2 passID_G;
+flat out float passScalar_G;
 
 layout (std430, binding = 2) readonly buffer mRod_ssbo
 {
@@ -20,34 +31,90 @@ layout (std430, binding = 8) readonly buffer HMMOffsetPositions_ssbo
 	vec4 pieceOffset[];
 };
 
-layout (std430, binding = 9) readonly buffer HMMyRotation_ssbo
+//cos and sin of the angle around the rod, cos and sin of the tilt away from the rod
+layout (std430, binding = 9) readonly buffer HMMRotation_ssbo
 {
-	mat4 yRotation[];
+	vec4 pieceRotation[];
 };
 
-layout (std430, binding = 10) readonly buffer HMMzRotation_ssbo
+layout (std430, binding = 20) readonly buffer scalar_ssbo
 {
-	mat4 zRotation[];
+	float scalar[];
 };
 
-layout (std430, binding = 11) readonly buffer HMMyRotation2_ssbo
+//visible children of all filaments, the range of a filament starts at gl_BaseInstanceARB
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
 {
-	mat4 yRotation2[];
+	uint visibleInstances[];
 };
 
+//indirect command of one filament followed by its record
+struct FilamentDraw
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	int filament;
+	int firstInstance;
+	int numChildren;
+	int padding;
+};
+
+layout (std430, binding = 23) readonly buffer filamentDraw_ssbo
+{
+	FilamentDraw filamentDraws[];
+};
+
+//world space points of the visible helices, stored by the first draw after a culling pass
+layout (std430, binding = 25) buffer ribbonCache_ssbo
+{
+	vec4 cachedPositions[];
+};
+
+//tilts a point away from the rod, rotation around the -z axis
+vec3 tilt(vec4 rotation, vec3 p)
+{
+	return vec3(rotation.z * p.x + rotation.w * p.y, -rotation.w * p.x + rotation.z * p.y, p.z);
+}
+
+//turns a point around the rod, rotation around the y axis
+vec3 turn(vec4 rotation, vec3 p)
+{
+	return vec3(rotation.x * p.x + rotation.y * p.z, p.y, -rotation.y * p.x + rotation.x * p.z);
+}
 
 void main(){
     //line segments per actin filament
-    int filamentID = int(gl_InstanceID / numLineSegments);
-    int linepieceID = gl_InstanceID % numLineSegments;
+    //one draw per filament, the child is stored relative to the first instance of the filament
+    FilamentDraw draw = filamentDraws[gl_DrawIDARB];
+    int linepieceID = int(visibleInstances[gl_BaseInstanceARB + gl_InstanceID]);
+    int filamentID = draw.filament;
+    int instanceID = draw.firstInstance + linepieceID;
     passRadius_G = radius;
-    if(linepieceID < numLineSegments / 2){
-        passPos_G = rotationMatrix * vec4((yRotation[linepieceID] * yRotation2[linepieceID] * (secondHalfRotationMatrix * zRotation[linepieceID] * Position) + filamentOffset[filamentID] + pieceOffset[linepieceID]).xyz,1.0f);
+    //structure type 8 = HMM
+    passID_G = uvec2((8u << 24) | uint(filamentID), uint(linepieceID));
+    passScalar_G = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + instanceID] - scalarMin) / scalarRange, 0.0f, 1.0f);
+    //indexed by instance, so sorting the filament commands keeps the cached points valid
+    int cacheIndex = cacheOffset + instanceID * int(draw.count) + gl_VertexID;
+    if(cacheMode == 2)
+    {
+        passPos_G = cachedPositions[cacheIndex];
         gl_Position = projectionMatrix * viewMatrix * passPos_G;
+        return;
     }
-    else
+    //both myosin halfs share the rotations of the first half
+    int halfSegments = numLineSegments / 2;
+    vec4 rotation = pieceRotation[linepieceID < halfSegments ? linepieceID : linepieceID - halfSegments];
+    vec3 position = tilt(rotation, Position.xyz);
+    if(linepieceID < halfSegments){
+        position = mat3(secondHalfRotationMatrix) * position;
+    }
+    position = turn(rotation, position);
+    passPos_G = rotationMatrix * vec4(position + filamentOffset[filamentID].xyz + pieceOffset[linepieceID].xyz, 1.0f);
+    gl_Position = projectionMatrix * viewMatrix * passPos_G;
+    if(cacheMode == 1)
     {
-        passPos_G = rotationMatrix * vec4((yRotation[linepieceID - numLineSegments / 2] * yRotation2[linepieceID - numLineSegments / 2] * (zRotation[linepieceID - numLineSegments / 2] * Position) + filamentOffset[filamentID] + pieceOffset[linepieceID]).xyz,1.0f);
-        gl_Position = projectionMatrix * viewMatrix * passPos_G;
+        cachedPositions[cacheIndex] = passPos_G;
     }
 }
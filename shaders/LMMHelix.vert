@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout (location = 0) in vec4 Position;
 uniform mat4 viewMatrix;
@@ -10,8 +11,18 @@ uniform float myosinLength;
 uniform int numLineSegments;
 uniform float radius;
 uniform float yOffset;
+//first instance of this structure in the mapped scalars, -1 = colored by diffColor
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
+//0 = the points are expanded every frame, 1 = expanded and stored in the cache, 2 = read from the cache
+uniform int cacheMode;
+//first vertex of this helix in the cache
+uniform int cacheOffset;
 out vec4 passPos_G;
 flat out float passRadius_G;
+flat out uvec2 passID_G;
+flat out float passScalar_G;
 
 layout (std430, binding = 2) readonly buffer mRod_ssbo
 {
@@ -23,11 +34,61 @@ layout (std430, binding = 7) readonly buffer LMMOffsetPositions_ssbo
 	vec4 pieceOffset[];
 };
 
+layout (std430, binding = 20) readonly buffer scalar_ssbo
+{
+	float scalar[];
+};
+
+//visible children of all filaments, the range of a filament starts at gl_BaseInstanceARB
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
+{
+	uint visibleInstances[];
+};
+
+//indirect command of one filament followed by its record
+struct FilamentDraw
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	int filament;
+	int firstInstance;
+	int numChildren;
+	int padding;
+};
+
+layout (std430, binding = 23) readonly buffer filamentDraw_ssbo
+{
+	FilamentDraw filamentDraws[];
+};
+
+//world space points of the visible helices, stored by the first draw after a culling pass
+layout (std430, binding = 25) buffer ribbonCache_ssbo
+{
+	vec4 cachedPositions[];
+};
+
 void main(){
     //line segments per actin filament
-    int filamentID = int(gl_InstanceID / numLineSegments);
-    int linepieceID = gl_InstanceID % numLineSegments;
+    //one draw per filament, the child is stored relative to the first instance of the filament
+    FilamentDraw draw = filamentDraws[gl_DrawIDARB];
+    int linepieceID = int(visibleInstances[gl_BaseInstanceARB + gl_InstanceID]);
+    int filamentID = draw.filament;
+    int instanceID = draw.firstInstance + linepieceID;
     passRadius_G = radius;
+    //structure type 7 = LMM
+    passID_G = uvec2((7u << 24) | uint(filamentID), uint(linepieceID));
+    passScalar_G = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + instanceID] - scalarMin) / scalarRange, 0.0f, 1.0f);
+
+    //indexed by instance, so sorting the filament commands keeps the cached points valid
+    int cacheIndex = cacheOffset + instanceID * int(draw.count) + gl_VertexID;
+    if(cacheMode == 2)
+    {
+        passPos_G = cachedPositions[cacheIndex];
+        gl_Position = projectionMatrix * viewMatrix * passPos_G;
+        return;
+    }
 
     if(linepieceID < numLineSegments / 2){
         passPos_G = rotationMatrix * vec4(((secondHalfRotationMatrix * Position) + filamentOffset[filamentID] + pieceOffset[linepieceID]).xyz,1.0f);
@@ -38,4 +99,8 @@ void main(){
         passPos_G = rotationMatrix * vec4((Position + filamentOffset[filamentID] + pieceOffset[linepieceID]).xyz,1.0f);
         gl_Position = projectionMatrix * viewMatrix * passPos_G;
     }
+    if(cacheMode == 1)
+    {
+        cachedPositions[cacheIndex] = passPos_G;
+    }
 }
@@ -0,0 +1,112 @@
+#version 450 core
+
+//section plane position, x = sarcomere x, y = sarcomere z
+in vec2 passPosition;
+uniform float pixelSize;
+uniform vec2 gridOrigin;
+uniform vec2 gridSize;
+uniform float cellSize;
+uniform int numFilaments;
+//1 if the section lies within the filaments of the structure
+uniform int myosinCut;
+uniform int firstActinCut;
+uniform int secondActinCut;
+uniform float actinRadius;
+uniform float myosinRadius;
+uniform vec3 actinColor;
+uniform vec3 myosinColor;
+//the central myosin filament, the primitive cell spans 2 * d11 along x and d10 along z
+uniform vec2 latticeCenter;
+uniform float d10;
+uniform int showUnitCells;
+uniform int showSpacings;
+layout(location = 0) out vec4 frag_Color;
+
+//first filament of every cell, the entry after the last cell holds the total
+layout (std430, binding = 26) readonly buffer crossSectionCells_ssbo
+{
+	int cellStart[];
+};
+
+//xy = position, z = 0 for myosin, 1 for the actin of the first half, 2 for the second half
+layout (std430, binding = 27) readonly buffer crossSectionDiscs_ssbo
+{
+	vec4 discs[];
+};
+
+//coverage of a line of width pixels at the given distance
+float lineCoverage(float distance, float width)
+{
+	return clamp(width * 0.5f - distance / pixelSize + 0.5f, 0.0f, 1.0f);
+}
+
+void main()
+{
+	vec3 color = vec3(0.08f);
+
+	//closest cut filament whose disc contains the pixel, relative to its radius
+	float closest = 2.0f;
+	vec2 closestOffset = vec2(0.0f);
+	float closestRadius = 0.0f;
+	int closestType = -1;
+	ivec2 cell = ivec2(floor((passPosition - gridOrigin) / cellSize));
+	for(int y = cell.y - 1; y <= cell.y + 1 && numFilaments > 0; y++)
+	{
+		for(int x = cell.x - 1; x <= cell.x + 1; x++)
+		{
+			if(x < 0 || y < 0 || x >= int(gridSize.x) || y >= int(gridSize.y))
+			{
+				continue;
+			}
+			int index = y * int(gridSize.x) + x;
+			for(int i = cellStart[index]; i < cellStart[index + 1]; i++)
+			{
+				vec4 disc = discs[i];
+				int type = int(disc.z);
+				bool cut = type == 0 ? myosinCut != 0 : (type == 1 ? firstActinCut != 0 : secondActinCut != 0);
+				float radius = type == 0 ? myosinRadius : actinRadius;
+				vec2 offset = passPosition - disc.xy;
+				float distance = length(offset) / radius;
+				if(cut && length(offset) < radius + pixelSize && distance < closest)
+				{
+					closest = distance;
+					closestOffset = offset;
+					closestRadius = radius;
+					closestType = type;
+				}
+			}
+		}
+	}
+	if(closestType >= 0)
+	{
+		//the cut face of a cylinder lit from the upper left, with an antialiased rim
+		vec2 normal = closestOffset / closestRadius;
+		float shade = 0.75f + 0.25f * dot(normal, normalize(vec2(-1.0f, 1.0f)));
+		vec3 filamentColor = (closestType == 0 ? myosinColor : actinColor) * shade;
+		float coverage = clamp((closestRadius - length(closestOffset)) / pixelSize + 0.5f, 0.0f, 1.0f);
+		color = mix(color, filamentColor, coverage);
+	}
+
+	vec2 local = passPosition - latticeCenter;
+	float d11 = d10 / sqrt(3.0f);
+	if(showSpacings != 0)
+	{
+		//(10) planes run along the rows of myosin filaments, the (11) planes across them
+		float distance10 = abs(fract(local.y / d10 + 0.5f) - 0.5f) * d10;
+		float distance11 = abs(fract(local.x / d11 + 0.5f) - 0.5f) * d11;
+		color = mix(color, vec3(1.0f, 0.8f, 0.2f), 0.6f * lineCoverage(distance10, 1.5f));
+		color = mix(color, vec3(0.2f, 0.8f, 1.0f), 0.6f * lineCoverage(distance11, 1.5f));
+	}
+	if(showUnitCells != 0)
+	{
+		//lattice coordinates along a1 = (2 * d11, 0) and a2 = (d11, d10)
+		float v = local.y / d10;
+		float u = (local.x - v * d11) / (2.0f * d11);
+		//distance between the lines of constant u measured perpendicular to them
+		float spacingU = 2.0f * d11 * d10 / length(vec2(d11, d10));
+		float distance = min(abs(u - round(u)) * spacingU, abs(v - round(v)) * d10);
+		bool central = u > -0.01f && u < 1.01f && v > -0.01f && v < 1.01f;
+		color = mix(color, vec3(1.0f), central ? lineCoverage(distance, 3.0f) : 0.35f * lineCoverage(distance, 1.0f));
+	}
+	frag_Color = vec4(color, 1.0f);
+}
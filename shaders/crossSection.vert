@@ -0,0 +1,14 @@
+#version 450 core
+
+//center and size of the visible part of the section plane in sarcomere units
+uniform vec2 viewCenter;
+uniform vec2 viewExtent;
+out vec2 passPosition;
+
+//one triangle covering the whole framebuffer
+void main()
+{
+	vec2 position = vec2(gl_VertexID == 1 ? 3.0f : -1.0f, gl_VertexID == 2 ? 3.0f : -1.0f);
+	passPosition = viewCenter + 0.5f * position * viewExtent;
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
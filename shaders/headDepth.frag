@@ -0,0 +1,18 @@
+#version 450 core
+
+//depth only variant of the myosin heads for the shadow map and the depth pre-pass, keeps the outline of the full shader
+void main()  
+{
+	float radiusX = 2.0f;
+	float radiusY = 1.0f;
+
+	vec2 skewedPointCoord = gl_PointCoord * vec2(radiusX, -radiusX) + vec2(-radiusY, radiusY);
+	skewedPointCoord *= vec2(radiusX, radiusY);
+	skewedPointCoord -= vec2(-radiusY, radiusY);
+	skewedPointCoord /= vec2(radiusX, -radiusX);
+
+	if(length(skewedPointCoord * 2.0f - 1.0f) > 1.0f || length(skewedPointCoord * 2.0f - 1.0f) <= 0.9f)
+	{
+		discard;
+	}
+}
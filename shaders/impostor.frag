@@ -0,0 +1,144 @@
+#version 450 core
+
+//the quad is placed on the front of the bounding sphere, every fragment lies behind it, which keeps the early depth test
+layout (depth_greater) out float gl_FragDepth;
+
+uniform mat4 projectionMatrix;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+//rg = local normal, b = depth in units of the bounding radius, a = slot of the structure + 1, one layer per segment
+uniform sampler2DArray atlas;
+uniform int gridSize;
+uniform float segmentRadius;
+//colors of the baked structures by slot
+uniform vec4 groupColors[3];
+uniform sampler1D transferFunction;
+in vec3 passPosition;
+in vec2 passUV[4];
+flat in vec2 passCells[4];
+flat in vec4 passWeights;
+flat in int passLayer;
+flat in mat3 passNormalMatrix;
+flat in uvec2 passID;
+flat in float passScalar;
+flat in int passSlotMask;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec3 octDecode(vec2 f)
+{
+	f = f * 2.0f - 1.0f;
+	vec3 n = vec3(f.x, f.y, 1.0f - abs(f.x) - abs(f.y));
+	if(n.z < 0.0f)
+	{
+		n.xy = (1.0f - abs(n.yx)) * signNotZero(n.xy);
+	}
+	return normalize(n);
+}
+
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
+
+void main()
+{
+	frag_ID = passID;
+	//blend the four closest views, the structure is the one of the strongest view that sees something
+	vec3 normal = vec3(0.0f);
+	float depth = 0.0f;
+	float coverage = 0.0f;
+	int slot = -1;
+	float slotWeight = 0.0f;
+	for(int i = 0; i < 4; i++)
+	{
+		if(any(lessThan(passUV[i], vec2(0.0f))) || any(greaterThan(passUV[i], vec2(1.0f))) || passWeights[i] <= 0.0f)
+		{
+			continue;
+		}
+		vec4 texel = texture(atlas, vec3((passCells[i] + passUV[i]) / float(gridSize), float(passLayer)));
+		int texelSlot = int(round(texel.a * 4.0f)) - 1;
+		//structures hidden by the selection leave a hole like in the detail
+		if(texelSlot < 0 || (passSlotMask & (1 << texelSlot)) == 0)
+		{
+			continue;
+		}
+		normal += passWeights[i] * octDecode(texel.rg);
+		depth += passWeights[i] * (texel.b * 2.0f - 1.0f);
+		coverage += passWeights[i];
+		if(passWeights[i] > slotWeight)
+		{
+			slot = texelSlot;
+			slotWeight = passWeights[i];
+		}
+	}
+	if(coverage < 0.5f)
+	{
+		discard;
+	}
+	normal = normalize(passNormalMatrix * normal);
+	vec3 position = passPosition + vec3(0.0f, 0.0f, depth / coverage * segmentRadius);
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		if(dot(clipPlanes[i].xyz, position) + clipPlanes[i].w < 0.0f)
+		{
+			discard;
+		}
+	}
+	vec4 clipSpacePos = projectionMatrix * vec4(position, 1.0f);
+	gl_FragDepth = (clipSpacePos.z / clipSpacePos.w) * 0.5f + 0.5f;
+
+	vec3 instanceColor = passScalar < 0.0f ? groupColors[slot].rgb : texture(transferFunction, passScalar).rgb;
+	vec3 lightColor = vec3(1.0f, 1.0f, 1.0f);
+	vec3 baseColor = vec3(0.1f, 0.1f, 0.1f);
+	vec3 specColor = vec3(1.0f, 1.0f, 1.0f);
+	float diffuseShade = max(0.0f, dot(normal, normalize(lightDirection)));
+	vec3 eye = normalize(-position);
+	vec3 reflection = normalize(reflect(-lightDirection, normal));
+	float cos_psi_n = pow(max(dot(reflection, eye), 0.0f), 15);
+
+	//light blocked by other structures
+	float shadow = shadowFactor(position, normal);
+	diffuseShade *= shadow;
+	cos_psi_n *= shadow;
+
+	frag_Color.rgb = baseColor;
+	frag_Color.rgb += instanceColor * diffuseShade * lightColor;
+	frag_Color.rgb += specColor * cos_psi_n * lightColor;
+	frag_Color.a = 1.0f;
+	if(shadingMode == 1)
+	{
+		frag_Color.rgb = toneShade(instanceColor * 0.25f, diffuseShade + cos_psi_n, passUV[0]);
+	}
+}
@@ -0,0 +1,170 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform mat4 rotationMatrix;
+uniform mat4 secondHalfRotationMatrix;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+//0 = thin filaments (binding 3), 1 = thick filaments (binding 2)
+uniform int filamentType;
+uniform int secondHalfStart;
+//segments along the local y axis of a filament, the quad covers the bounding sphere of a segment
+uniform float segmentStart;
+uniform float segmentLength;
+uniform vec2 segmentAxis;
+uniform float segmentRadius;
+//views per side of the octahedral atlas
+uniform int gridSize;
+//first scalar of the impostors in the mapped scalars, -1 = colored by the baked structures
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
+//first bit of the impostors in the selection mask and the bits per impostor, one per baked structure,
+//-1 = every structure is shown
+uniform int selectionOffset;
+uniform int selectionSlots;
+out vec3 passPosition;
+//position of the pixel in the four views closest to the view direction
+out vec2 passUV[4];
+flat out vec2 passCells[4];
+flat out vec4 passWeights;
+flat out int passLayer;
+flat out mat3 passNormalMatrix;
+flat out uvec2 passID;
+flat out float passScalar;
+//bit per slot of the baked structures that are not hidden by the selection
+flat out int passSlotMask;
+out float gl_ClipDistance[4];
+
+layout (std430, binding = 2) readonly buffer mRod_ssbo
+{
+	vec4 myosinOffset[];
+};
+
+layout (std430, binding = 3) readonly buffer aRod_ssbo
+{
+	vec4 actinOffset[];
+};
+
+//visible segments of all filaments, the range of a filament starts at gl_BaseInstanceARB
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
+{
+	uint visibleInstances[];
+};
+
+//indirect command of one filament followed by its record
+struct FilamentDraw
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	int filament;
+	int firstInstance;
+	int numChildren;
+	int padding;
+};
+
+layout (std430, binding = 23) readonly buffer filamentDraw_ssbo
+{
+	FilamentDraw filamentDraws[];
+};
+
+layout (std430, binding = 20) readonly buffer scalar_ssbo
+{
+	float scalar[];
+};
+
+layout (std430, binding = 21) readonly buffer selection_ssbo
+{
+	uint selectionBits[];
+};
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+//same octahedral map as the baking in FilamentImpostors.cpp
+vec2 octEncode(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.z >= 0.0f ? n.xy : (1.0f - abs(n.yx)) * signNotZero(n.xy);
+	return e * 0.5f + 0.5f;
+}
+
+vec3 octDecode(vec2 f)
+{
+	f = f * 2.0f - 1.0f;
+	vec3 n = vec3(f.x, f.y, 1.0f - abs(f.x) - abs(f.y));
+	if(n.z < 0.0f)
+	{
+		n.xy = (1.0f - abs(n.yx)) * signNotZero(n.xy);
+	}
+	return normalize(n);
+}
+
+void main()
+{
+	//one draw per filament, the segment is stored relative to the first instance of the filament
+	FilamentDraw draw = filamentDraws[gl_DrawIDARB];
+	int segment = int(visibleInstances[gl_BaseInstanceARB + gl_InstanceID]);
+	int filamentID = draw.filament;
+	int instance = draw.firstInstance + segment;
+	vec3 filament = filamentType == 1 ? myosinOffset[filamentID].xyz : actinOffset[filamentID].xyz;
+	mat4 instanceRotation = filamentID >= secondHalfStart ? rotationMatrix * secondHalfRotationMatrix : rotationMatrix;
+	vec3 localCenter = filament + vec3(segmentAxis.x, segmentStart + (float(segment) + 0.5f) * segmentLength, segmentAxis.y);
+	vec4 center = viewMatrix * instanceRotation * vec4(localCenter, 1.0f);
+	mat3 localToView = mat3(viewMatrix) * mat3(instanceRotation);
+
+	//direction towards the eye in the local space of the filament, orthographic views look along -z
+	vec3 toEye = projectionMatrix[3][3] == 1.0f ? vec3(0.0f, 0.0f, 1.0f) : -center.xyz;
+	vec3 viewDirection = normalize(transpose(localToView) * toEye);
+	vec2 grid = octEncode(viewDirection) * float(gridSize) - 0.5f;
+	vec2 base = floor(grid);
+	vec2 f = grid - base;
+	passWeights = vec4((1.0f - f.x) * (1.0f - f.y), f.x * (1.0f - f.y), (1.0f - f.x) * f.y, f.x * f.y);
+
+	//corner of the camera facing quad and its offset in the local space
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0f - 1.0f;
+	vec3 viewOffset = vec3(corner * segmentRadius, 0.0f);
+	vec3 localOffset = transpose(localToView) * viewOffset;
+	for(int i = 0; i < 4; i++)
+	{
+		vec2 cell = clamp(base + vec2(float(i & 1), float(i >> 1)), vec2(0.0f), vec2(float(gridSize - 1)));
+		vec3 direction = octDecode((cell + 0.5f) / float(gridSize));
+		vec3 reference = abs(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+		vec3 right = normalize(cross(reference, direction));
+		vec3 up = cross(direction, right);
+		passCells[i] = cell;
+		passUV[i] = vec2(dot(localOffset, right), dot(localOffset, up)) / (2.0f * segmentRadius) + 0.5f;
+	}
+
+	passPosition = center.xyz + viewOffset;
+	passLayer = segment;
+	passNormalMatrix = localToView;
+	//the filament rod of the segment is picked, structure type 2 = myosin rod, 3 = actin rod
+	passID = uvec2(((filamentType == 1 ? 2u : 3u) << 24) | uint(filamentID), 0u);
+	passScalar = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + instance] - scalarMin) / scalarRange, 0.0f, 1.0f);
+	passSlotMask = -1;
+	if(selectionOffset >= 0)
+	{
+		passSlotMask = 0;
+		for(int slot = 0; slot < selectionSlots; slot++)
+		{
+			uint bit = uint(selectionOffset + instance * selectionSlots + slot);
+			passSlotMask |= (selectionBits[bit >> 5u] & (1u << (bit & 31u))) != 0u ? 1 << slot : 0;
+		}
+	}
+	//only drop the quad if the whole segment is outside, the fragment shader cuts the rest
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		gl_ClipDistance[i] = dot(clipPlanes[i], vec4(passPosition, 1.0f)) + segmentRadius;
+	}
+	gl_Position = projectionMatrix * vec4(passPosition, 1.0f);
+	//move the quad to the front of the bounding sphere, the fragments only add depth to it (depth_greater)
+	vec4 front = projectionMatrix * vec4(passPosition.xy, passPosition.z + segmentRadius, 1.0f);
+	gl_Position.z = (front.w > 0.0f ? max(front.z / front.w, -1.0f) : -1.0f) * gl_Position.w;
+}
@@ -0,0 +1,52 @@
+#version 450 core
+
+layout (depth_greater) out float gl_FragDepth;
+
+uniform mat4 projectionMatrix;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+uniform sampler2DArray atlas;
+uniform int gridSize;
+uniform float segmentRadius;
+in vec3 passPosition;
+in vec2 passUV[4];
+flat in vec2 passCells[4];
+flat in vec4 passWeights;
+flat in int passLayer;
+flat in int passSlotMask;
+
+//depth only variant of the impostors for the shadow map, blends the baked depth like the full shader
+void main()
+{
+	float depth = 0.0f;
+	float coverage = 0.0f;
+	for(int i = 0; i < 4; i++)
+	{
+		if(any(lessThan(passUV[i], vec2(0.0f))) || any(greaterThan(passUV[i], vec2(1.0f))) || passWeights[i] <= 0.0f)
+		{
+			continue;
+		}
+		vec4 texel = texture(atlas, vec3((passCells[i] + passUV[i]) / float(gridSize), float(passLayer)));
+		int texelSlot = int(round(texel.a * 4.0f)) - 1;
+		if(texelSlot < 0 || (passSlotMask & (1 << texelSlot)) == 0)
+		{
+			continue;
+		}
+		depth += passWeights[i] * (texel.b * 2.0f - 1.0f);
+		coverage += passWeights[i];
+	}
+	if(coverage < 0.5f)
+	{
+		discard;
+	}
+	vec3 position = passPosition + vec3(0.0f, 0.0f, depth / coverage * segmentRadius);
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		if(dot(clipPlanes[i].xyz, position) + clipPlanes[i].w < 0.0f)
+		{
+			discard;
+		}
+	}
+	vec4 clipSpacePos = projectionMatrix * vec4(position, 1.0f);
+	gl_FragDepth = (clipSpacePos.z / clipSpacePos.w) * 0.5f + 0.5f;
+}
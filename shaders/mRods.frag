@@ -1,29 +1,103 @@
 #version 450 core
 
 uniform vec3 diffColor;
+uniform sampler1D transferFunction;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
 in vec3 passPosition;
 in vec3 passNormal;
-out vec4 frag_Color;
+in vec3 passLocalPosition;
+flat in uvec2 passID;
+flat in float passScalar;
+flat in float passOcclusion;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+
+float pi = 3.1415926535897;
+
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
 
 void main()  
 {       
-	vec3 lightDir = vec3(0.577f, 0.577f, 0.577f);
+	frag_ID = passID;
+	//the mapped scalar of the instance replaces the color of the structure
+	vec3 instanceColor = passScalar < 0.0f ? diffColor : texture(transferFunction, passScalar).rgb;
+	//back faces are only visible where a clipping plane cut the rod open, shade them as a solid cap
+	//the cap lies on the plane through which the view ray enters the kept half space last
+	vec3 normal = passNormal;
+	if(!gl_FrontFacing)
+	{
+		vec3 viewRay = normalize(passPosition);
+		float tCap = -1.0f;
+		normal = -passNormal;
+		for(int i = 0; i < numClipPlanes; i++)
+		{
+			float cosRay = dot(clipPlanes[i].xyz, viewRay);
+			if(cosRay > 0.0f && -clipPlanes[i].w / cosRay > tCap)
+			{
+				tCap = -clipPlanes[i].w / cosRay;
+				normal = -clipPlanes[i].xyz;
+			}
+		}
+	}
+	vec3 lightDir = lightDirection;
 	vec3 lightColor = vec3(1.0f,1.0f,1.0f);
 	vec3 baseColor = vec3(0.1f,0.1f,0.1f);
 	vec3 specColor = vec3(1.0f,1.0f,1.0f);
 
 	// Diffuse term
 	lightDir = normalize(lightDir);
-	float cos_phi = max(dot(passNormal, lightDir), 0.0f);
+	float cos_phi = max(dot(normal, lightDir), 0.0f);
 
 	// Specular term
 	vec3 eye = normalize(-passPosition);
-	vec3 reflection = normalize(reflect(-lightDir, passNormal));
+	vec3 reflection = normalize(reflect(-lightDir, normal));
 	float cos_psi_n = pow(max(dot(reflection, eye), 0.0f), 15);
 
+	//light blocked by other structures
+	float shadow = shadowFactor(passPosition, normal);
+	cos_phi *= shadow;
+	cos_psi_n *= shadow;
+
 	//sum up colors
 	frag_Color.rgb = baseColor;
-	frag_Color.rgb += diffColor * cos_phi * lightColor;
+	frag_Color.rgb += instanceColor * cos_phi * lightColor;
 	frag_Color.rgb += specColor * cos_psi_n * lightColor;
 	frag_Color.a= 1.0f;
+	frag_Color.rgb *= passOcclusion;
+	if(shadingMode == 1)
+	{
+		//wrap the tones around the rod, one repeat per circumference along the axis
+		vec2 rodUV = vec2(atan(passLocalPosition.z, passLocalPosition.x) / (2.0f * pi), passLocalPosition.y / (2.0f * pi * max(length(passLocalPosition.xz), 0.0001f)));
+		frag_Color.rgb = toneShade(instanceColor * 0.25f, (cos_phi + cos_psi_n) * passOcclusion, rodUV);
+	}
 }
\ No newline at end of file
@@ -11,21 +11,58 @@ uniform mat4 scaleWidthMatrix;
 uniform mat4 scaleHeightMatrix;
 uniform float sarcomereLength;
 uniform float myosinLength;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+//first instance of this structure in the baked occlusion, -1 = none
+uniform int occlusionOffset;
+//first instance of this structure in the mapped scalars, -1 = colored by diffColor
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
 out vec3 passPosition;
 out vec3 passNormal;
+out vec3 passLocalPosition;
+flat out uvec2 passID;
+flat out float passScalar;
+flat out float passOcclusion;
+out float gl_ClipDistance[4];
 
 layout (std430, binding = 2) readonly buffer mRod_ssbo
 {
 	vec4 offset[];
 };
 
+layout (std430, binding = 17) readonly buffer occlusion_ssbo
+{
+	float occlusion[];
+};
+
+layout (std430, binding = 20) readonly buffer scalar_ssbo
+{
+	float scalar[];
+};
+
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
+{
+	uint visibleInstances[];
+};
+
 void main() 
 {
-	int id = gl_InstanceID;
+	int id = int(visibleInstances[gl_InstanceID]);
 	vec4 pos = viewMatrix * vec4((rotationMatrix * ((scaleHeightMatrix * scaleWidthMatrix * Position) + offset[id] + vec4(0.0f, (-sarcomereLength - myosinLength) / 2.0f + sarcomereLength / 2.0f, 0.0f, 0.0f))).xyz,1.0f);
 	mat3 normalMatrix = mat3(transpose(inverse(viewMatrix * rotationMatrix)));
 	passPosition = pos.xyz;
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		gl_ClipDistance[i] = dot(clipPlanes[i], pos);
+	}
 	passNormal = normalize(normalMatrix * Normal);
+	passLocalPosition = (scaleHeightMatrix * scaleWidthMatrix * Position).xyz;
+	//structure type 2 = myosin rod
+	passID = uvec2((2u << 24) | uint(id), 0u);
+	passScalar = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + id] - scalarMin) / scalarRange, 0.0f, 1.0f);
+	passOcclusion = occlusionOffset < 0 ? 1.0f : occlusion[occlusionOffset + id];
 	gl_Position = projectionMatrix * pos; 
 }
 
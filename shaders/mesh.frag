@@ -0,0 +1,97 @@
+#version 450 core
+#extension GL_ARB_bindless_texture : require
+
+in vec3 passPosition;
+in vec3 passNormal;
+in vec2 passUV;
+flat in int passDrawID;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+
+struct Material
+{
+	vec3 color;
+	float kd;
+	float ks;
+	float shininess;
+	uvec2 textureAddress;
+};
+
+struct DrawRecord
+{
+	mat4 modelMatrix;
+	int materialIndex;
+};
+
+layout (std430, binding = 18) readonly buffer material_ssbo
+{
+	Material materials[];
+};
+
+layout (std430, binding = 19) readonly buffer drawRecord_ssbo
+{
+	DrawRecord drawRecords[];
+};
+
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
+
+void main()  
+{       
+	//structure type 10 = imported mesh
+	frag_ID = uvec2((10u << 24) | uint(passDrawID), uint(gl_PrimitiveID));
+	Material material = materials[drawRecords[passDrawID].materialIndex];
+	vec3 color = material.color;
+	//a zero handle marks an untextured material
+	if(material.textureAddress != uvec2(0u))
+	{
+		color *= texture(sampler2D(material.textureAddress), passUV).rgb;
+	}
+	vec3 normal = gl_FrontFacing ? normalize(passNormal) : -normalize(passNormal);
+	vec3 ambientLight = vec3(0.2, 0.2, 0.2);
+	//Diffuse
+	vec3 lightVector = lightDirection;
+	float cosPhi = max(dot(normal, lightVector), 0.0);
+	//specular
+	vec3 eye = normalize(-passPosition);
+	vec3 reflection = normalize(reflect(-lightVector, normal));
+	float cosPsi_n = pow(max(dot(reflection, eye), 0.0f), material.shininess);
+	//light blocked by other structures
+	float shadow = shadowFactor(passPosition, normal);
+	cosPhi *= shadow;
+	cosPsi_n *= shadow;
+	frag_Color.a = 1.0f;
+	frag_Color.rgb = color * ambientLight + color * material.kd * cosPhi + vec3(material.ks * cosPsi_n);
+	if(shadingMode == 1)
+	{
+		frag_Color.rgb = toneShade(color * 0.25f, material.kd * cosPhi + material.ks * cosPsi_n, passUV);
+	}
+}
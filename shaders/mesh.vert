@@ -0,0 +1,44 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec4 Position;
+layout (location = 1) in vec4 Normal;
+layout (location = 2) in vec2 UV;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+out vec3 passPosition;
+out vec3 passNormal;
+out vec2 passUV;
+flat out int passDrawID;
+out float gl_ClipDistance[4];
+
+struct DrawRecord
+{
+	mat4 modelMatrix;
+	int materialIndex;
+};
+
+layout (std430, binding = 19) readonly buffer drawRecord_ssbo
+{
+	DrawRecord drawRecords[];
+};
+
+void main() 
+{
+	//one draw of the multi draw call per object
+	int drawID = gl_DrawIDARB;
+	mat4 modelView = viewMatrix * drawRecords[drawID].modelMatrix;
+	vec4 pos = modelView * Position;
+	passPosition = pos.xyz;
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		gl_ClipDistance[i] = dot(clipPlanes[i], pos);
+	}
+	passNormal = normalize(mat3(transpose(inverse(modelView))) * Normal.xyz);
+	passUV = UV;
+	passDrawID = drawID;
+	gl_Position = projectionMatrix * pos;
+}
@@ -1,15 +1,20 @@
 #version 450 core
 
 uniform vec3 diffColor;
+uniform sampler1D transferFunction;
 uniform mat4 viewMatrix;
 in vec3 passPosition;
 in vec3 passNormal;
 in mat4 passProjMat;
 in float passPointSize;
-out vec4 frag_Color;
+flat in uvec2 passID;
+flat in float passScalar;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
 
 void main()  
 {
+	frag_ID = passID;
 	vec3 lightDir = vec3(0.577f, 0.577f, 0.577f);
 	vec3 lightColor = vec3(1.0f,1.0f,1.0f);
 	vec3 baseColor = vec3(0.1f,0.1f,0.1f);
@@ -27,7 +32,8 @@ void main()
 
 	if(length(skewedPointCoord * 2.0f - 1.0f) <= 1.0f && length(skewedPointCoord * 2.0f - 1.0f) > 0.9f)
 	{
-		frag_Color.rgb = baseColor;
+		//the outline takes the color of the mapped scalar
+		frag_Color.rgb = passScalar < 0.0f ? baseColor : texture(transferFunction, passScalar).rgb;
 	}
 	//discard pixel if gl_PointCoord is outside of the sphere
 	else
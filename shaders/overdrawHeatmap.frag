@@ -0,0 +1,10 @@
+#version 450 core
+
+//color of the overdraw level selected by the stencil test
+uniform vec3 levelColor;
+layout(location = 0) out vec4 frag_Color;
+
+void main()
+{
+	frag_Color = vec4(levelColor, 1.0f);
+}
@@ -0,0 +1,6 @@
+#version 450 core
+
+//depth only variant of the structure shaders for the shadow map, the rasterizer writes the depth
+void main()  
+{
+}
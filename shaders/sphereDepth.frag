@@ -0,0 +1,51 @@
+#version 450 core
+
+//the sprite is placed on the front of the sphere, every fragment lies behind it, which keeps the early depth test
+layout (depth_greater) out float gl_FragDepth;
+
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+in vec3 passPosition;
+in mat4 passProjMat;
+in float passPointSize;
+
+//depth only variant of the sphere sprites for the shadow map and the depth pre-pass,
+//computes the same depth as the full shader, so the color pass can test against it with GL_LEQUAL
+void main()  
+{
+	if(length(gl_PointCoord * 2.0f - 1.0f) > 1.0f)
+	{
+		discard;
+	}
+	precise vec3 sphereNormal;
+	sphereNormal.xy = gl_PointCoord * vec2(2.0f, -2.0f) + vec2(-1.0f, 1.0f);
+	float r2 = dot(sphereNormal.xy, sphereNormal.xy);
+	sphereNormal.z = sqrt(1.0f - r2);
+	sphereNormal = normalize(sphereNormal);
+	precise vec3 rayOrigin = passPosition + vec3(sphereNormal.xy * passPointSize, 0.0f);
+	precise float tNear = sphereNormal.z * passPointSize;
+	float tFar = -tNear;
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		float planeDistance = dot(clipPlanes[i].xyz, rayOrigin) + clipPlanes[i].w;
+		float t = -planeDistance / clipPlanes[i].z;
+		if(clipPlanes[i].z > 0.0f)
+		{
+			tFar = max(tFar, t);
+		}
+		else if(clipPlanes[i].z < 0.0f && t < tNear)
+		{
+			tNear = t;
+		}
+		else if(clipPlanes[i].z == 0.0f && planeDistance < 0.0f)
+		{
+			discard;
+		}
+	}
+	if(tNear < tFar)
+	{
+		discard;
+	}
+	precise vec4 clipSpacePos = passProjMat * vec4(rayOrigin + vec3(0.0f, 0.0f, tNear), 1.0f);
+	gl_FragDepth = (clipSpacePos.z / clipSpacePos.w) * 0.5f + 0.5f;
+}
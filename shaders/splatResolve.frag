@@ -0,0 +1,51 @@
+#version 450 core
+#extension GL_ARB_gpu_shader_int64 : require
+
+uniform int targetWidth;
+//actin monomers, troponin and myosin heads
+uniform vec4 groupColors[3];
+uniform int numElements[3];
+//first instance of every group in the mapped scalars, -1 = colored by its group
+uniform int scalarOffsets[3];
+uniform float scalarMin;
+uniform float scalarRange;
+uniform sampler1D transferFunction;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+
+layout (std430, binding = 20) readonly buffer scalar_ssbo
+{
+	float scalar[];
+};
+
+layout (std430, binding = 30) readonly buffer splatPixels_ssbo
+{
+	uint64_t splatPixels[];
+};
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	uint64_t splat = splatPixels[pixel.y * targetWidth + pixel.x];
+	uint depthBits = uint(splat >> 32);
+	//no splat in this pixel
+	if(depthBits == 0xFFFFFFFFu)
+	{
+		discard;
+	}
+	uint low = uint(splat & 0xFFFFFFFFul);
+	int group = int(low >> 30);
+	int instance = int(low & 0x3FFFFFFFu);
+	int filamentID = instance / numElements[group];
+	int id = instance % numElements[group];
+	vec3 color = groupColors[group].rgb;
+	if(scalarOffsets[group] >= 0)
+	{
+		color = texture(transferFunction, clamp((scalar[scalarOffsets[group] + instance] - scalarMin) / scalarRange, 0.0f, 1.0f)).rgb;
+	}
+	frag_Color = vec4(color, 1.0f);
+	//structure types 4 = actin monomer, 6 = troponin, 9 = myosin head, like the sprite shaders
+	const uint types[3] = uint[3](4u, 6u, 9u);
+	frag_ID = uvec2((types[group] << 24) | uint(filamentID), uint(id));
+	gl_FragDepth = uintBitsToFloat(depthBits);
+}
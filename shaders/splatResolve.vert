@@ -0,0 +1,8 @@
+#version 450 core
+
+//one triangle covering the whole framebuffer
+void main()
+{
+	vec2 position = vec2(gl_VertexID == 1 ? 3.0f : -1.0f, gl_VertexID == 2 ? 3.0f : -1.0f);
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout (location = 0) in vec4 Position;
 uniform mat4 viewMatrix;
@@ -7,35 +8,130 @@ uniform mat4 rotationMatrix;
 uniform mat4 translationMatrix;
 uniform mat4 secondHalfRotationMatrix;
 uniform float sarcomereLength;
+//tropomyosin molecules of both halves of a filament
 uniform int numLineSegments;
 uniform float radius;
 uniform float pointDist;
+//first instance of this structure in the mapped scalars, -1 = colored by diffColor
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
+//0 = the points are expanded every frame, 1 = expanded and stored in the cache, 2 = read from the cache
+uniform int cacheMode;
+//first vertex of this helix in the cache
+uniform int cacheOffset;
+//first bit of the molecules in the selection mask, -1 = nothing is hidden
+uniform int selectionOffset;
+//segments of the actin impostors, the pieces in far segments are drawn by the impostors, 0 = no impostors
+uniform int impostorSegments;
+uniform float impostorStart;
+uniform float impostorLength;
+uniform vec2 impostorAxis;
+uniform float impostorSize;
+uniform float impostorPixels;
+uniform vec3 lodEye;
+uniform float lodPixelScale;
 out vec4 passPos_G;
 flat out float passRadius_G;
+flat out uvec2 passID_G;
+flat out float passScalar_G;
+//0 = the piece to the next point is hidden by the selection or drawn by an impostor
+flat out int passVisible_G;
 
 layout (std430, binding = 3) readonly buffer aRod_ssbo
 {
 	vec4 filamentOffset[];
 };
 
-layout (std430, binding = 5) readonly buffer lineRotation_ssbo
+layout (std430, binding = 20) readonly buffer scalar_ssbo
 {
-	mat4 lineRotations[];
+	float scalar[];
+};
+
+layout (std430, binding = 21) readonly buffer selection_ssbo
+{
+	uint selectionBits[];
+};
+
+//visible children of all filaments, the range of a filament starts at gl_BaseInstanceARB
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
+{
+	uint visibleInstances[];
+};
+
+//indirect command of one filament followed by its record
+struct FilamentDraw
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	int filament;
+	int firstInstance;
+	int numChildren;
+	int padding;
+};
+
+layout (std430, binding = 23) readonly buffer filamentDraw_ssbo
+{
+	FilamentDraw filamentDraws[];
+};
+
+//world space points of the visible helices, stored by the first draw after a culling pass
+layout (std430, binding = 25) buffer ribbonCache_ssbo
+{
+	vec4 cachedPositions[];
 };
 
 void main(){
-    //line segments per actin filament
-    int filamentID = int(gl_InstanceID / numLineSegments);
-    int linepieceID = gl_InstanceID % numLineSegments;
+    //one strand per filament half, the second strand is mirrored by the second half rotation
+    //one draw per filament, the strand is stored relative to the first instance of the filament
+    FilamentDraw draw = filamentDraws[gl_DrawIDARB];
+    int strand = int(visibleInstances[gl_BaseInstanceARB + gl_InstanceID]);
+    int filamentID = draw.filament;
+    int instanceID = draw.firstInstance + strand;
+    //the piece to the next point lies on one molecule of seven monomers, the selection and the scalars are per molecule
+    int moleculesPerStrand = numLineSegments / 2;
+    int molecule = strand * moleculesPerStrand + clamp((gl_VertexID - 1) / 7, 0, moleculesPerStrand - 1);
+    int moleculeInstance = filamentID * numLineSegments + molecule;
     passRadius_G = radius;
+    //structure type 5 = tropomyosin
+    passID_G = uvec2((5u << 24) | uint(filamentID), uint(molecule));
+    passScalar_G = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + moleculeInstance] - scalarMin) / scalarRange, 0.0f, 1.0f);
+    passVisible_G = 1;
+    if(selectionOffset >= 0)
+    {
+        uint bit = uint(selectionOffset + moleculeInstance);
+        passVisible_G = (selectionBits[bit >> 5u] & (1u << (bit & 31u))) != 0u ? 1 : 0;
+    }
+    //the strand spans every impostor segment, so the pieces are tested against the impostor of their segment
+    //like the culling pass tests the instances of the other detail groups
+    if(impostorSegments > 0)
+    {
+        float pieceY = (strand == 0 ? 1.0f : -1.0f) * (Position.y + 0.5f * pointDist);
+        int segment = clamp(int(floor((pieceY - impostorStart) / impostorLength)), 0, impostorSegments - 1);
+        vec3 center = filamentOffset[filamentID].xyz + vec3(impostorAxis.x, impostorStart + (float(segment) + 0.5f) * impostorLength, impostorAxis.y);
+        center = (rotationMatrix * vec4(center, 1.0f)).xyz;
+        if(impostorSize * lodPixelScale < impostorPixels * length(center - lodEye))
+        {
+            passVisible_G = 0;
+        }
+    }
 
-    if(linepieceID < numLineSegments / 2){
-        passPos_G = rotationMatrix * vec4(((lineRotations[linepieceID] * Position) + filamentOffset[filamentID] + vec4(0.0f, 7.0f * pointDist * linepieceID, 0.0f, 0.0f)).xyz,1.0f);
+    //indexed by instance, so sorting the filament commands keeps the cached points valid
+    int cacheIndex = cacheOffset + instanceID * int(draw.count) + gl_VertexID;
+    if(cacheMode == 2)
+    {
+        passPos_G = cachedPositions[cacheIndex];
         gl_Position = projectionMatrix * viewMatrix * passPos_G;
+        return;
     }
-    else
+
+    vec4 localPosition = strand == 0 ? Position : secondHalfRotationMatrix * Position;
+    passPos_G = rotationMatrix * vec4(localPosition.xyz + filamentOffset[filamentID].xyz, 1.0f);
+    gl_Position = projectionMatrix * viewMatrix * passPos_G;
+    if(cacheMode == 1)
     {
-        passPos_G = rotationMatrix * vec4(((lineRotations[linepieceID] * secondHalfRotationMatrix * Position) + filamentOffset[filamentID] + vec4(0.0f, - (7.0f * pointDist * (linepieceID - int(numLineSegments) / 2)), 0.0f, 0.0f)).xyz,1.0f);
-        gl_Position = projectionMatrix * viewMatrix * passPos_G;
+        cachedPositions[cacheIndex] = passPos_G;
     }
 }
\ No newline at end of file
@@ -1,20 +1,65 @@
 #version 450 core
 
+//the sprite is placed on the front of the sphere, every fragment lies behind it, which keeps the early depth test
+layout (depth_greater) out float gl_FragDepth;
+
 uniform vec3 diffColor;
+uniform sampler1D transferFunction;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
 in vec3 passPosition;
 in vec3 passNormal;
 in mat4 passProjMat;
 in float passPointSize;
-out vec4 frag_Color;
+flat in uvec2 passID;
+flat in float passScalar;
+flat in float passOcclusion;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
 
 void main()  
 {
-	vec3 lightDir = vec3(0.577f, 0.577f, 0.577f);
+	frag_ID = passID;
+	//the mapped scalar of the instance replaces the color of the structure
+	vec3 instanceColor = passScalar < 0.0f ? diffColor : texture(transferFunction, passScalar).rgb;
+	vec3 lightDir = lightDirection;
 	vec3 lightColor = vec3(1.0f,1.0f,1.0f);
 	vec3 baseColor = vec3(0.1f,0.1f,0.1f);
 	vec3 specColor = vec3(1.0f,1.0f,1.0f);
 	//vec3 diffColor = vec3(0.0f,0.0f,0.5f);
-    vec3 sphereNormal;
+	//precise keeps the depth equal to the one of the depth pre-pass in sphereDepth.frag
+	precise vec3 sphereNormal;
 
 	//calculate shading for points to look like spheres if gl_PointCoord is inside the sphere
 	if(length(gl_PointCoord * 2.0f - 1.0f) <= 1.0f)
@@ -24,9 +69,42 @@ void main()
 		float r2 = dot(sphereNormal.xy, sphereNormal.xy);
    		sphereNormal.z = sqrt(1.0f - r2);
 		sphereNormal = normalize(sphereNormal);
+		// cut the sphere with the clipping planes, the view ray of this pixel runs along z
+		// and passes the sphere between t = tFar and t = tNear, keep the nearest point inside all planes
+		precise vec3 rayOrigin = passPosition + vec3(sphereNormal.xy * passPointSize, 0.0f);
+		precise float tNear = sphereNormal.z * passPointSize;
+		float tFar = -tNear;
+		int capPlane = -1;
+		for(int i = 0; i < numClipPlanes; i++)
+		{
+			float planeDistance = dot(clipPlanes[i].xyz, rayOrigin) + clipPlanes[i].w;
+			float t = -planeDistance / clipPlanes[i].z;
+			if(clipPlanes[i].z > 0.0f)
+			{
+				tFar = max(tFar, t);
+			}
+			else if(clipPlanes[i].z < 0.0f && t < tNear)
+			{
+				tNear = t;
+				capPlane = i;
+			}
+			else if(clipPlanes[i].z == 0.0f && planeDistance < 0.0f)
+			{
+				discard;
+			}
+		}
+		if(tNear < tFar)
+		{
+			discard;
+		}
+		// the sphere is cut open in front, shade the solid cap with the plane normal
+		if(capPlane >= 0)
+		{
+			sphereNormal = -clipPlanes[capPlane].xyz;
+		}
 		// calculate depth on sphere
-		vec4 viewSpacePos = vec4(passPosition + sphereNormal * passPointSize, 1.0f);   // position of this pixel on sphere in view space
-		vec4 clipSpacePos = passProjMat * viewSpacePos;
+		precise vec4 viewSpacePos = vec4(rayOrigin + vec3(0.0f, 0.0f, tNear), 1.0f);   // position of this pixel on sphere in view space
+		precise vec4 clipSpacePos = passProjMat * viewSpacePos;
 		gl_FragDepth = (clipSpacePos.z / clipSpacePos.w) * 0.5f + 0.5f;
 		// calculate grayscale color
 		float diffuseShade = max(0.0f, dot(sphereNormal, normalize(lightDir)));
@@ -36,11 +114,21 @@ void main()
 		vec3 reflection = normalize(reflect(-lightDir, sphereNormal));
 		float cos_psi_n = pow(max(dot(reflection, eye), 0.0f), 15);
 
+		//light blocked by other structures
+		float shadow = shadowFactor(viewSpacePos.xyz, sphereNormal);
+		diffuseShade *= shadow;
+		cos_psi_n *= shadow;
+
 		//sum up colors
 		frag_Color.rgb = baseColor;
-		frag_Color.rgb += diffColor * vec3(diffuseShade, diffuseShade, diffuseShade) * lightColor;
+		frag_Color.rgb += instanceColor * vec3(diffuseShade, diffuseShade, diffuseShade) * lightColor;
 		frag_Color.rgb += specColor * cos_psi_n * lightColor;
 		frag_Color.a;
+		frag_Color.rgb *= passOcclusion;
+		if(shadingMode == 1)
+		{
+			frag_Color.rgb = toneShade(instanceColor * 0.25f, (diffuseShade + cos_psi_n) * passOcclusion, gl_PointCoord);
+		}
 	}
 	//discard pixel if gl_PointCoord is outside of the sphere
 	else
@@ -1,4 +1,5 @@
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout (location = 0) in vec4 Position;
 layout (location = 1) in vec3 Normal;
@@ -7,13 +8,33 @@ uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 uniform mat4 rotationMatrix;
 uniform mat4 scaleWidthMatrix;
-uniform int numParticles;
 uniform int viewportY;
 uniform float basePointSize;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+//first instance of this structure in the baked occlusion, -1 = none
+uniform int occlusionOffset;
+//first instance of this structure in the mapped scalars, -1 = colored by diffColor
+uniform int scalarOffset;
+uniform float scalarMin;
+uniform float scalarRange;
+//stochastic level of detail, lodPointSize = 0 keeps every sprite at its size
+uniform float lodPointSize;
+uniform vec3 lodEye;
+uniform float lodPixelScale;
+uniform float lodTargetPixels;
+uniform float lodMinFraction;
+uniform float lodFadeWidth;
 out vec3 passPosition;
 out vec3 passNormal;
 out float passPointSize;
 out mat4 passProjMat;
+flat out uvec2 passID;
+flat out float passScalar;
+flat out float passOcclusion;
+out float gl_ClipDistance[4];
+//the depth pre-pass draws the same sprites with another fragment shader
+invariant gl_Position;
 
 layout (std430, binding = 3) readonly buffer aRod_ssbo
 {
@@ -25,25 +46,98 @@ layout (std430, binding = 6) readonly buffer troponin_ssbo
 	vec4 particleOffset[];
 };
 
+layout (std430, binding = 17) readonly buffer occlusion_ssbo
+{
+	float occlusion[];
+};
+
+layout (std430, binding = 20) readonly buffer scalar_ssbo
+{
+	float scalar[];
+};
+
+//visible children of all filaments, the range of a filament starts at gl_BaseInstanceARB
+layout (std430, binding = 13) readonly buffer visibleInstances_ssbo
+{
+	uint visibleInstances[];
+};
+
+//indirect command of one filament followed by its record
+struct FilamentDraw
+{
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+	int filament;
+	int firstInstance;
+	int numChildren;
+	int padding;
+};
+
+layout (std430, binding = 23) readonly buffer filamentDraw_ssbo
+{
+	FilamentDraw filamentDraws[];
+};
+
+//the same hash of the instance index as the culling pass
+float lodHash(uint x)
+{
+	x ^= x >> 16u;
+	x *= 0x7feb352du;
+	x ^= x >> 15u;
+	x *= 0x846ca68bu;
+	x ^= x >> 16u;
+	return float(x) / 4294967296.0f;
+}
+
+//scale of a sprite of the level of detail, the kept sprites cover the area of the dropped ones
+//and shrink to nothing as their hash approaches the kept fraction, 0 if the sprite is dropped
+float lodScale(int instance, vec3 worldPosition)
+{
+	if(lodPointSize <= 0.0f)
+	{
+		return 1.0f;
+	}
+	float pixels = lodPointSize * lodPixelScale / max(length(worldPosition - lodEye), 0.000001f);
+	float fraction = clamp((pixels * pixels) / (lodTargetPixels * lodTargetPixels), lodMinFraction, 1.0f);
+	float fade = clamp((fraction - lodHash(uint(instance))) / (lodFadeWidth * fraction), 0.0f, 1.0f);
+	return fade / sqrt(fraction);
+}
 
 void main() 
 {
-	int id = gl_InstanceID % numParticles;
-	int filamentID = gl_InstanceID / numParticles;
-	vec4 pos = Position;
-	//scale point radius
-	pos = scaleWidthMatrix * pos;
-	pos = pos + particleOffset[id];
-	pos = pos + filamentOffset[filamentID];
-	pos = rotationMatrix * pos;
-	pos = vec4(pos.xyz, 1.0f);
-	pos = viewMatrix * pos;
+	//one draw per filament, the child is stored relative to the first instance of the filament
+	FilamentDraw draw = filamentDraws[gl_DrawIDARB];
+	int id = int(visibleInstances[gl_BaseInstanceARB + gl_InstanceID]);
+	int filamentID = draw.filament;
+	int instanceID = draw.firstInstance + id;
+	vec3 worldPosition = (rotationMatrix * ((scaleWidthMatrix * Position) + filamentOffset[filamentID] + particleOffset[id])).xyz;
+	vec4 pos = viewMatrix * vec4(worldPosition, 1.0f);
+	float pointSize = basePointSize * lodScale(instanceID, worldPosition);
 	float pointScale = viewportY * 0.7f * projectionMatrix[1][1];
 	passPosition = pos.xyz;
 	passNormal = Normal;
+	//structure type 6 = troponin
+	passID = uvec2((6u << 24) | uint(filamentID), uint(id));
+	passScalar = scalarOffset < 0 ? -1.0f : clamp((scalar[scalarOffset + instanceID] - scalarMin) / scalarRange, 0.0f, 1.0f);
+	passOcclusion = occlusionOffset < 0 ? 1.0f : occlusion[occlusionOffset + instanceID];
 	passProjMat = projectionMatrix;
+	//only drop the sprite if the whole sphere is outside, the fragment shader cuts the rest
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		gl_ClipDistance[i] = dot(clipPlanes[i], pos) + pointSize;
+	}
 	gl_Position = projectionMatrix * pos; 
-	gl_PointSize = (basePointSize * pointScale) / gl_Position.w;
-	passPointSize = basePointSize;
+	gl_PointSize = (pointSize * pointScale) / gl_Position.w;
+	//move the sprite to the front of the sphere, the fragments only add depth to it (depth_greater)
+	vec4 front = projectionMatrix * vec4(pos.xy, pos.z + pointSize, 1.0f);
+	gl_Position.z = (front.w > 0.0f ? max(front.z / front.w, -1.0f) : -1.0f) * gl_Position.w;
+	passPointSize = pointSize;
+	//sprites the level of detail dropped since the last culling pass are moved outside of the view
+	if(pointSize <= 0.0f)
+	{
+		gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
+	}
 }
 
@@ -2,16 +2,70 @@
 
 in vec3 passPosition;
 in vec3 passNormal;
-out vec4 frag_Color;
+in vec3 passLocalPosition;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
+flat in uvec2 passID;
+uniform int shadingMode;
+uniform sampler2DArray toneArtMap;
+uniform int numToneLayers;
+uniform float toneScale;
+uniform int toneSpace;
+uniform vec3 lightDirection;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrix;
+uniform int shadowsEnabled;
+uniform float shadowNormalOffset;
+layout(location = 0) out vec4 frag_Color;
+layout(location = 1) out uvec2 frag_ID;
+//hatching and stippling, blends the two tones around the intensity which share one array layer
+vec3 toneShade(vec3 inkColor, float intensity, vec2 objectUV)
+{
+	vec2 uv = toneSpace == 0 ? gl_FragCoord.xy / toneScale : objectUV;
+	float tone = clamp(1.0f - intensity, 0.0f, 1.0f) * float(numToneLayers);
+	float layer = min(floor(tone), float(numToneLayers - 1));
+	vec2 tones = texture(toneArtMap, vec3(uv, layer)).rg;
+	return mix(inkColor, vec3(1.0f), mix(tones.r, tones.g, tone - layer));
+}
+
+//fraction of the light reaching a view space position, one hardware filtered lookup into the cached shadow map
+float shadowFactor(vec3 position, vec3 offsetDirection)
+{
+	if(shadowsEnabled == 0)
+	{
+		return 1.0f;
+	}
+	vec4 shadowPosition = shadowMatrix * vec4(position + offsetDirection * shadowNormalOffset, 1.0f);
+	return texture(shadowMap, shadowPosition.xyz);
+}
+
 void main()  
 {       
-	vec4 lightPosition = vec4(0.0, 100.0, 10.0, 1.0);
+	frag_ID = passID;
+	//back faces are only visible where a clipping plane cut the disc open, shade them as a solid cap
+	//the cap lies on the plane through which the view ray enters the kept half space last
+	vec3 normal = passNormal;
+	if(!gl_FrontFacing)
+	{
+		vec3 viewRay = normalize(passPosition);
+		float tCap = -1.0f;
+		normal = -passNormal;
+		for(int i = 0; i < numClipPlanes; i++)
+		{
+			float cosRay = dot(clipPlanes[i].xyz, viewRay);
+			if(cosRay > 0.0f && -clipPlanes[i].w / cosRay > tCap)
+			{
+				tCap = -clipPlanes[i].w / cosRay;
+				normal = -clipPlanes[i].xyz;
+			}
+		}
+	}
 	vec3 color = vec3(0.0, 0.0, 1.0);
 	vec3 ambientLight = vec3(0.2, 0.2, 0.2);
 	vec3 specularColor = vec3(0.5, 0.5, 0.3);
 	//Diffuse
-	vec3 lightVector = normalize(lightPosition.xyz - passPosition);
-	float cosPhi = max(dot(passNormal, lightVector), 0.0);
+	vec3 lightVector = lightDirection;
+	float cosPhi = max(dot(normal, lightVector), 0.0) * shadowFactor(passPosition, normal);
 	//specular 
 	//vec3 eye = normalize(-passPosition); 
 	//vec3 reflection = normalize(reflect(-lightVector, passNormal));
@@ -21,4 +75,8 @@ void main()
 	//frag_Color.rgb += color * cosPhi;  
 	//frag_Color.rgb += specularColor * cosPsi_n;  
 	frag_Color.rgb = color * ambientLight + color * cosPhi;
+	if(shadingMode == 1)
+	{
+		frag_Color.rgb = toneShade(color * 0.25f, cosPhi, passLocalPosition.xz * 4.0f);
+	}
 }
\ No newline at end of file
@@ -8,8 +8,13 @@ uniform mat4 projectionMatrix;
 uniform mat4 rotationMatrix;
 uniform mat4 sarcomereRadius;
 uniform float sarcomereLength;
+uniform vec4 clipPlanes[4];
+uniform int numClipPlanes;
 out vec3 passPosition;
 out vec3 passNormal;
+out vec3 passLocalPosition;
+flat out uvec2 passID;
+out float gl_ClipDistance[4];
 
 layout (std430, binding = 1) readonly buffer zDisc_ssbo
 {
@@ -29,7 +34,14 @@ void main()
 		pos = viewMatrix * vec4((rotationMatrix * ((sarcomereRadius * Position) + vec4(0.0f, -sarcomereLength / 2.0f, 0.0f, 0.0f) + offset[id])).xyz,1.0f);
 	}
 	passPosition = pos.xyz;
+	for(int i = 0; i < numClipPlanes; i++)
+	{
+		gl_ClipDistance[i] = dot(clipPlanes[i], pos);
+	}
 	passNormal = Normal;
+	passLocalPosition = Position.xyz;
+	//structure type 1 = z-disc
+	passID = uvec2((1u << 24) | uint(id), 0u);
 	gl_Position = projectionMatrix * pos; 
 }
 
@@ -0,0 +1,170 @@
+#include "AmbientOcclusion.h"
+#include <algorithm>
+
+AmbientOcclusion::AmbientOcclusion() : m_bakeShader(SHADERS_PATH "/bakeOcclusion.comp")
+{
+	m_offsets.fill(-1);
+}
+
+AmbientOcclusion::~AmbientOcclusion()
+{
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void AmbientOcclusion::setGroup(CullGroup group, const CullGroupDescription& description)
+{
+	for (int i = 0; i < NUM_RECEIVERS; i++)
+	{
+		if (RECEIVERS[i] == group && m_groups[i] != description)
+		{
+			m_groups[i] = description;
+			m_layoutChanged = true;
+		}
+	}
+}
+
+void AmbientOcclusion::setOccluders(const CullGroupDescription& actin, const CullGroupDescription& myosin, glm::mat4 secondHalfRotationMatrix)
+{
+	if (actin != m_actin || myosin != m_myosin || secondHalfRotationMatrix != m_secondHalfRotationMatrix)
+	{
+		m_actin = actin;
+		m_myosin = myosin;
+		m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+		invalidate();
+	}
+}
+
+void AmbientOcclusion::invalidate()
+{
+	m_nextInstance = 0;
+}
+
+void AmbientOcclusion::update(const AmbientOcclusionSettings& settings, float latticeSpacing)
+{
+	if (settings.enabled != m_settings.enabled || settings.range != m_settings.range || settings.strength != m_settings.strength || latticeSpacing != m_latticeSpacing)
+	{
+		m_settings = settings;
+		m_latticeSpacing = latticeSpacing;
+		invalidate();
+	}
+	if (!m_settings.enabled)
+	{
+		return;
+	}
+	if (m_layoutChanged)
+	{
+		layoutBuffer();
+	}
+	if (isComplete())
+	{
+		return;
+	}
+
+	int chunkEnd = std::min(m_nextInstance + INSTANCES_PER_FRAME, m_numInstances);
+	m_bakeShader.use();
+	m_bakeShader.updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_bakeShader.updateUniform("numActin", m_actin.enabled ? m_actin.numFilaments : 0);
+	m_bakeShader.updateUniform("actinAxisStart", m_actin.axisStart);
+	m_bakeShader.updateUniform("actinAxisEnd", m_actin.axisEnd);
+	m_bakeShader.updateUniform("actinRadius", m_actin.boundingRadius);
+	m_bakeShader.updateUniform("actinSecondHalfStart", m_actin.secondHalfStart);
+	m_bakeShader.updateUniform("numMyosin", m_myosin.enabled ? m_myosin.numFilaments : 0);
+	m_bakeShader.updateUniform("myosinAxisStart", m_myosin.axisStart);
+	m_bakeShader.updateUniform("myosinAxisEnd", m_myosin.axisEnd);
+	m_bakeShader.updateUniform("myosinRadius", m_myosin.boundingRadius);
+	m_bakeShader.updateUniform("range", m_settings.range * m_latticeSpacing);
+	m_bakeShader.updateUniform("strength", m_settings.strength);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, m_buffer);
+	for (int i = 0; i < NUM_RECEIVERS; i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		int groupStart = m_offsets[i];
+		int groupEnd = groupStart + group.numFilaments * group.numElements;
+		int first = std::max(m_nextInstance, groupStart);
+		int last = std::min(chunkEnd, groupEnd);
+		if (groupStart < 0 || first >= last)
+		{
+			continue;
+		}
+		//the bake reads the same offset buffers as the vertex shaders, copy them to the bindings of the culler
+		GLint filamentBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+		if (group.elementBinding != 0)
+		{
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.elementBinding, &elementBuffer);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, elementBuffer ? elementBuffer : filamentBuffer);
+
+		m_bakeShader.updateUniform("firstInstance", first - groupStart);
+		m_bakeShader.updateUniform("numInstances", last - first);
+		m_bakeShader.updateUniform("bufferOffset", groupStart);
+		m_bakeShader.updateUniform("numElements", group.numElements);
+		m_bakeShader.updateUniform("hasElements", group.elementBinding != 0 ? 1 : 0);
+		m_bakeShader.updateUniform("axisCenter", (group.axisStart + group.axisEnd) * 0.5f);
+		m_bakeShader.updateUniform("secondHalfStart", group.secondHalfStart);
+		//the own filament does not occlude its instances
+		m_bakeShader.updateUniform("ownFilaments", group.filamentBinding == 3 ? 0 : 1);
+		glDispatchCompute((last - first + 63) / 64, 1, 1);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	m_nextInstance = chunkEnd;
+}
+
+bool AmbientOcclusion::isComplete()
+{
+	return !m_settings.enabled || (!m_layoutChanged && m_nextInstance >= m_numInstances);
+}
+
+void AmbientOcclusion::bind()
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, m_buffer);
+}
+
+int AmbientOcclusion::getOffset(CullGroup group)
+{
+	for (int i = 0; i < NUM_RECEIVERS; i++)
+	{
+		if (RECEIVERS[i] == group && m_settings.enabled && !m_layoutChanged)
+		{
+			return m_offsets[i];
+		}
+	}
+	return -1;
+}
+
+void AmbientOcclusion::layoutBuffer()
+{
+	//one contiguous range per enabled group
+	std::array<int, NUM_RECEIVERS> offsets;
+	int numInstances = 0;
+	for (int i = 0; i < NUM_RECEIVERS; i++)
+	{
+		int groupInstances = m_groups[i].enabled ? m_groups[i].numFilaments * m_groups[i].numElements : 0;
+		offsets[i] = groupInstances > 0 ? numInstances : -1;
+		numInstances += groupInstances;
+	}
+	m_layoutChanged = false;
+	m_nextInstance = 0;
+	//the same layout keeps the previous values visible while they are baked again
+	if (offsets == m_offsets && numInstances == m_numInstances)
+	{
+		return;
+	}
+	m_offsets = offsets;
+	m_numInstances = numInstances;
+	if (numInstances > m_bufferSize)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		glCreateBuffers(1, &m_buffer);
+		glNamedBufferStorage(m_buffer, static_cast<GLsizeiptr>(numInstances) * sizeof(float), nullptr, 0);
+		m_bufferSize = numInstances;
+	}
+	//unbaked instances are unoccluded
+	if (m_buffer != 0)
+	{
+		float visible = 1.0f;
+		glClearNamedBufferData(m_buffer, GL_R32F, GL_RED, GL_FLOAT, &visible);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include "InstanceCuller.h"
+#include "shaderProgram.h"
+
+//parameters of the ambient occlusion window
+struct AmbientOcclusionSettings
+{
+	bool enabled = true;
+	//distance in lattice spacings d10 beyond which filaments do not occlude anymore
+	float range = 1.5f;
+	//exponent applied to the visibility, larger values darken the occluded instances more
+	float strength = 2.0f;
+};
+
+// Ambient occlusion baked once per instance of the filament rods, actin monomers and troponin.
+// The lattice does not change between parameter edits, so a compute pass estimates how much of
+// the surrounding directions the actin and myosin filaments block for the center of every instance
+// and stores one visibility per instance in an ssbo (binding 17). The filaments are treated as
+// cylinders along the sarcomere axis. The bake is spread over several frames with a fixed instance
+// budget per frame, the previous values stay visible until they are overwritten, so rendering only
+// reads one float per instance.
+class AmbientOcclusion
+{
+public:
+	AmbientOcclusion();
+	~AmbientOcclusion();
+	// Sets the instances which receive occlusion, uses the same descriptions as the culler
+	void setGroup(CullGroup group, const CullGroupDescription& description);
+	// Sets the filaments which occlude, disabled descriptions do not occlude
+	// * const CullGroupDescription& actin - actin rods, filament offsets from binding 3
+	// * const CullGroupDescription& myosin - myosin rods, filament offsets from binding 2
+	void setOccluders(const CullGroupDescription& actin, const CullGroupDescription& myosin, glm::mat4 secondHalfRotationMatrix);
+	// Restarts the bake, used when the offset buffers changed
+	void invalidate();
+	// Bakes the next instances within the budget, expects the sarcomere ssbos to be bound
+	// * float latticeSpacing - d10 of the sarcomere, the range of the settings is given in multiples of it
+	void update(const AmbientOcclusionSettings& settings, float latticeSpacing);
+	// Returns true if every instance has been baked with the current lattice
+	bool isComplete();
+	// Binds the visibility buffer to binding 17
+	void bind();
+	// Returns the index of the first instance of a group in the visibility buffer, -1 if the group has none
+	int getOffset(CullGroup group);
+private:
+	static constexpr int INSTANCES_PER_FRAME = 16384;
+	static constexpr int NUM_RECEIVERS = 4;
+	static constexpr std::array<CullGroup, NUM_RECEIVERS> RECEIVERS = { CullGroup::ACTIN_RODS, CullGroup::MYOSIN_RODS, CullGroup::ACTIN_MONOMERS, CullGroup::TROPONIN };
+	void layoutBuffer();
+	ShaderProgram m_bakeShader;
+	std::array<CullGroupDescription, NUM_RECEIVERS> m_groups;
+	std::array<int, NUM_RECEIVERS> m_offsets;
+	CullGroupDescription m_actin;
+	CullGroupDescription m_myosin;
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	AmbientOcclusionSettings m_settings;
+	float m_latticeSpacing = 0.0f;
+	GLuint m_buffer = 0;
+	int m_bufferSize = 0;
+	int m_numInstances = 0;
+	int m_nextInstance = 0;
+	bool m_layoutChanged = true;
+};
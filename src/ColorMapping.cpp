@@ -0,0 +1,286 @@
+#include "ColorMapping.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+bool TransferPoint::operator==(const TransferPoint& other) const
+{
+	return position == other.position && color == other.color;
+}
+
+bool TransferPoint::operator!=(const TransferPoint& other) const
+{
+	return !(*this == other);
+}
+
+ColorMapping::ColorMapping() : m_scalarShader(SHADERS_PATH "/computeScalars.comp")
+{
+	m_offsets.fill(-1);
+	glCreateTextures(GL_TEXTURE_1D, 1, &m_texture);
+	glTextureStorage1D(m_texture, 1, GL_RGBA8, TRANSFER_FUNCTION_SIZE);
+	glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	createTransferFunction(ColorMappingSettings().transferFunction);
+}
+
+ColorMapping::~ColorMapping()
+{
+	glDeleteBuffers(1, &m_buffer);
+	glDeleteTextures(1, &m_texture);
+}
+
+void ColorMapping::setGroup(CullGroup group, const CullGroupDescription& description)
+{
+	CullGroupDescription& current = m_groups[static_cast<int>(group)];
+	if (current != description)
+	{
+		current = description;
+		m_layoutChanged = true;
+	}
+}
+
+void ColorMapping::setLattice(const CullGroupDescription& actin, glm::mat4 secondHalfRotationMatrix, glm::vec3 latticeCenter, float latticeSpacing, float halfSarcomereLength)
+{
+	if (actin != m_actin || secondHalfRotationMatrix != m_secondHalfRotationMatrix || latticeCenter != m_latticeCenter ||
+		latticeSpacing != m_latticeSpacing || halfSarcomereLength != m_halfSarcomereLength)
+	{
+		m_actin = actin;
+		m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+		m_latticeCenter = latticeCenter;
+		m_latticeSpacing = latticeSpacing;
+		m_halfSarcomereLength = halfSarcomereLength;
+		invalidate();
+	}
+}
+
+void ColorMapping::invalidate()
+{
+	m_dirty = true;
+}
+
+bool ColorMapping::loadUserData(CullGroup group, const char* path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cout << "FAIL: Could not open scalar file " << path << std::endl;
+		return false;
+	}
+	std::vector<float> values;
+	float value;
+	while (file >> value)
+	{
+		values.push_back(value);
+	}
+	m_userData[static_cast<int>(group)] = values;
+	if (m_quantity == ColorMappingSettings::USER_DATA)
+	{
+		invalidate();
+	}
+	return true;
+}
+
+void ColorMapping::update(const ColorMappingSettings& settings)
+{
+	if (settings.transferFunction != m_transferPoints)
+	{
+		createTransferFunction(settings.transferFunction);
+	}
+	if (settings.quantity != m_quantity || settings.autoRange != m_autoRange)
+	{
+		m_quantity = settings.quantity;
+		m_autoRange = settings.autoRange;
+		invalidate();
+	}
+	if (!m_autoRange)
+	{
+		m_rangeMin = settings.rangeMin;
+		m_rangeMax = settings.rangeMax;
+	}
+	if (m_quantity == ColorMappingSettings::NONE)
+	{
+		return;
+	}
+	if (m_layoutChanged)
+	{
+		layoutBuffer();
+	}
+	if (m_dirty)
+	{
+		m_dirty = false;
+		computeScalars();
+		if (m_autoRange)
+		{
+			fitRange();
+		}
+	}
+}
+
+void ColorMapping::bind(GLuint unit)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 20, m_buffer);
+	glBindTextureUnit(unit, m_texture);
+}
+
+int ColorMapping::getOffset(CullGroup group)
+{
+	if (m_quantity == ColorMappingSettings::NONE || m_layoutChanged)
+	{
+		return -1;
+	}
+	return m_offsets[static_cast<int>(group)];
+}
+
+float ColorMapping::getRangeMin()
+{
+	return m_rangeMin;
+}
+
+float ColorMapping::getRangeMax()
+{
+	return m_rangeMax;
+}
+
+void ColorMapping::layoutBuffer()
+{
+	//one contiguous range per enabled group
+	int numInstances = 0;
+	for (int i = 0; i < NUM_GROUPS; i++)
+	{
+		int groupInstances = m_groups[i].enabled ? m_groups[i].numFilaments * m_groups[i].numElements : 0;
+		m_offsets[i] = groupInstances > 0 ? numInstances : -1;
+		numInstances += groupInstances;
+	}
+	m_numInstances = numInstances;
+	if (numInstances > m_bufferSize)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		glCreateBuffers(1, &m_buffer);
+		glNamedBufferStorage(m_buffer, static_cast<GLsizeiptr>(numInstances) * sizeof(float), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		m_bufferSize = numInstances;
+	}
+	m_layoutChanged = false;
+	m_dirty = true;
+}
+
+void ColorMapping::computeScalars()
+{
+	if (m_numInstances < 1)
+	{
+		return;
+	}
+	//user data is uploaded per group in instance order, missing values are 0
+	if (m_quantity == ColorMappingSettings::USER_DATA)
+	{
+		for (int i = 0; i < NUM_GROUPS; i++)
+		{
+			if (m_offsets[i] < 0)
+			{
+				continue;
+			}
+			std::vector<float> values = m_userData[i];
+			values.resize(m_groups[i].numFilaments * m_groups[i].numElements, 0.0f);
+			//an impostor stands for the detail of its filament and shows the value of the rod it picks
+			if (i == static_cast<int>(CullGroup::ACTIN_IMPOSTORS) || i == static_cast<int>(CullGroup::MYOSIN_IMPOSTORS))
+			{
+				const std::vector<float>& rodValues = m_userData[static_cast<int>(i == static_cast<int>(CullGroup::MYOSIN_IMPOSTORS) ? CullGroup::MYOSIN_RODS : CullGroup::ACTIN_RODS)];
+				for (size_t instance = 0; instance < values.size(); instance++)
+				{
+					size_t filament = instance / m_groups[i].numElements;
+					values[instance] = filament < rodValues.size() ? rodValues[filament] : 0.0f;
+				}
+			}
+			glNamedBufferSubData(m_buffer, static_cast<GLintptr>(m_offsets[i]) * sizeof(float), values.size() * sizeof(float), values.data());
+		}
+		return;
+	}
+
+	m_scalarShader.use();
+	m_scalarShader.updateUniform("quantity", m_quantity);
+	m_scalarShader.updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_scalarShader.updateUniform("latticeCenter", m_latticeCenter);
+	m_scalarShader.updateUniform("latticeSpacing", m_latticeSpacing);
+	m_scalarShader.updateUniform("halfSarcomereLength", m_halfSarcomereLength);
+	m_scalarShader.updateUniform("numActin", m_actin.enabled ? m_actin.numFilaments : 0);
+	m_scalarShader.updateUniform("actinSecondHalfStart", m_actin.secondHalfStart);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 20, m_buffer);
+	for (int i = 0; i < NUM_GROUPS; i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		if (m_offsets[i] < 0)
+		{
+			continue;
+		}
+		//the pass reads the same offset buffers as the vertex shaders, copy them to the bindings of the culler
+		GLint filamentBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+		if (group.elementBinding != 0 && group.elementBinding != 5)
+		{
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.elementBinding, &elementBuffer);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, elementBuffer ? elementBuffer : filamentBuffer);
+
+		int numInstances = group.numFilaments * group.numElements;
+		m_scalarShader.updateUniform("numInstances", numInstances);
+		m_scalarShader.updateUniform("bufferOffset", m_offsets[i]);
+		m_scalarShader.updateUniform("numFilaments", group.numFilaments);
+		m_scalarShader.updateUniform("numElements", group.numElements);
+		m_scalarShader.updateUniform("elementBinding", group.elementBinding);
+		m_scalarShader.updateUniform("elementSpacing", group.elementSpacing);
+		m_scalarShader.updateUniform("axisCenter", (group.axisStart + group.axisEnd) * 0.5f);
+		m_scalarShader.updateUniform("secondHalfStart", group.secondHalfStart);
+		int numGroups = (numInstances + 255) / 256;
+		int numGroupsX = std::min(numGroups, 65535);
+		int numGroupsY = (numGroups + numGroupsX - 1) / numGroupsX;
+		glDispatchCompute(numGroupsX, numGroupsY, 1);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void ColorMapping::fitRange()
+{
+	//only runs after a recomputation, so the stall of the readback does not matter
+	std::vector<float> values(m_numInstances);
+	if (values.empty())
+	{
+		return;
+	}
+	glGetNamedBufferSubData(m_buffer, 0, values.size() * sizeof(float), values.data());
+	auto range = std::minmax_element(values.begin(), values.end());
+	m_rangeMin = *range.first;
+	m_rangeMax = *range.second > *range.first ? *range.second : *range.first + 1.0f;
+}
+
+void ColorMapping::createTransferFunction(const std::vector<TransferPoint>& points)
+{
+	m_transferPoints = points;
+	std::vector<TransferPoint> sorted = points;
+	std::sort(sorted.begin(), sorted.end(), [](const TransferPoint& a, const TransferPoint& b) { return a.position < b.position; });
+	//piecewise linear between the control points, constant beyond the first and the last one
+	std::vector<GLubyte> texels(TRANSFER_FUNCTION_SIZE * 4, 255);
+	for (int i = 0; i < TRANSFER_FUNCTION_SIZE && !sorted.empty(); i++)
+	{
+		float t = i / static_cast<float>(TRANSFER_FUNCTION_SIZE - 1);
+		glm::vec3 color = sorted.front().color;
+		for (int k = 0; k < static_cast<int>(sorted.size()); k++)
+		{
+			if (t >= sorted[k].position)
+			{
+				color = sorted[k].color;
+				if (k + 1 < static_cast<int>(sorted.size()) && t < sorted[k + 1].position)
+				{
+					float blend = (t - sorted[k].position) / (sorted[k + 1].position - sorted[k].position);
+					color = glm::mix(sorted[k].color, sorted[k + 1].color, blend);
+				}
+			}
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			texels[i * 4 + c] = static_cast<GLubyte>(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+	glTextureSubImage1D(m_texture, 0, 0, TRANSFER_FUNCTION_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+}
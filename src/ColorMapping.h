@@ -0,0 +1,106 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include "InstanceCuller.h"
+#include "shaderProgram.h"
+
+//control point of a transfer function
+struct TransferPoint
+{
+	//scalar between 0 (range minimum) and 1 (range maximum)
+	float position;
+	glm::vec3 color;
+
+	bool operator==(const TransferPoint& other) const;
+	bool operator!=(const TransferPoint& other) const;
+};
+
+//parameters of the color mapping window
+struct ColorMappingSettings
+{
+	enum Quantity
+	{
+		NONE = 0,
+		//distance of the instance from the axis of the lattice in d10
+		RADIAL_DISTANCE = 1,
+		//distance from the M-line, 0 at the M-line and 1 at the Z-discs
+		M_LINE_DISTANCE = 2,
+		//distance to the closest actin filament in d10, small where myosin heads can attach
+		NEAREST_ACTIN = 3,
+		//filament of the instance, 0 for the first and 1 for the last
+		FILAMENT_INDEX = 4,
+		//values loaded from a file per structure
+		USER_DATA = 5
+	};
+	int quantity = NONE;
+	//fit the range to the smallest and largest value after every recomputation
+	bool autoRange = true;
+	float rangeMin = 0.0f;
+	float rangeMax = 1.0f;
+	std::vector<TransferPoint> transferFunction = {
+		{ 0.0f, glm::vec3(0.27f, 0.0f, 0.33f) },
+		{ 0.5f, glm::vec3(0.13f, 0.57f, 0.55f) },
+		{ 1.0f, glm::vec3(0.99f, 0.91f, 0.14f) } };
+};
+
+// Colors the instances of every structure by a scalar mapped through a transfer function.
+// One float per instance is kept in an ssbo (binding 20) with a contiguous range per structure, laid out
+// like the baked ambient occlusion. A compute pass derives the built in quantities from the same offset
+// buffers as the culling pass, loaded user data is uploaded as is. The vertex shaders read the scalar of
+// their instance, normalize it with the range and the fragment shaders look up the color in a 1D texture,
+// so any mapping costs one ssbo read per instance and no additional draw.
+class ColorMapping
+{
+public:
+	ColorMapping();
+	~ColorMapping();
+	// Sets the instances of a structure, uses the same descriptions as the culler
+	void setGroup(CullGroup group, const CullGroupDescription& description);
+	// Sets the actin filaments the nearest actin distance is measured to
+	// * glm::vec3 latticeCenter - sarcomere space center of the lattice, the M-line runs through it
+	void setLattice(const CullGroupDescription& actin, glm::mat4 secondHalfRotationMatrix, glm::vec3 latticeCenter, float latticeSpacing, float halfSarcomereLength);
+	// Recomputes the scalars, used when the offset buffers changed
+	void invalidate();
+	// Loads one value per line in the instance order of the structure (filament * elements + element)
+	// * const char* path - text file, missing values are 0
+	bool loadUserData(CullGroup group, const char* path);
+	// Updates the scalars and the transfer function texture if needed, expects the sarcomere ssbos to be bound
+	void update(const ColorMappingSettings& settings);
+	// Binds the scalars to binding 20 and the transfer function, the shaders read it as sampler1D transferFunction
+	void bind(GLuint unit);
+	// Returns the index of the first scalar of a group, -1 if the group is not mapped
+	int getOffset(CullGroup group);
+	// Returns the scalar mapped to the first and the last color of the transfer function
+	float getRangeMin();
+	float getRangeMax();
+private:
+	static constexpr int NUM_GROUPS = static_cast<int>(CullGroup::COUNT);
+	static constexpr int TRANSFER_FUNCTION_SIZE = 256;
+	void layoutBuffer();
+	void computeScalars();
+	void fitRange();
+	void createTransferFunction(const std::vector<TransferPoint>& points);
+	ShaderProgram m_scalarShader;
+	std::array<CullGroupDescription, NUM_GROUPS> m_groups;
+	std::array<int, NUM_GROUPS> m_offsets;
+	std::array<std::vector<float>, NUM_GROUPS> m_userData;
+	CullGroupDescription m_actin;
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	glm::vec3 m_latticeCenter = glm::vec3(0.0f);
+	float m_latticeSpacing = 1.0f;
+	float m_halfSarcomereLength = 1.0f;
+	int m_quantity = ColorMappingSettings::NONE;
+	bool m_autoRange = true;
+	float m_rangeMin = 0.0f;
+	float m_rangeMax = 1.0f;
+	std::vector<TransferPoint> m_transferPoints;
+	GLuint m_buffer = 0;
+	GLuint m_texture = 0;
+	int m_bufferSize = 0;
+	int m_numInstances = 0;
+	bool m_layoutChanged = true;
+	bool m_dirty = true;
+};
@@ -0,0 +1,192 @@
+#include "CrossSectionView.h"
+#include <algorithm>
+
+CrossSectionView::CrossSectionView() : m_sectionShader(SHADERS_PATH "/crossSection.vert", SHADERS_PATH "/crossSection.frag")
+{
+	glCreateVertexArrays(1, &m_vao);
+}
+
+CrossSectionView::~CrossSectionView()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_cellBuffer);
+	glDeleteBuffers(1, &m_discBuffer);
+}
+
+void CrossSectionView::setFilaments(const std::vector<glm::vec4>& actinRods, const std::vector<glm::vec4>& myosinRods, glm::mat4 secondHalfRotationMatrix)
+{
+	//xy = position in the section plane (sarcomere x and z), z = 0 for myosin, 1 and 2 for the actin of both halves
+	std::vector<glm::vec4> discs;
+	discs.reserve(actinRods.size() + myosinRods.size());
+	for (const glm::vec4& rod : myosinRods)
+	{
+		discs.push_back(glm::vec4(rod.x, rod.z, 0.0f, 0.0f));
+	}
+	int secondHalfStart = static_cast<int>(actinRods.size()) / 2;
+	for (int i = 0; i < static_cast<int>(actinRods.size()); i++)
+	{
+		glm::vec4 rod = i >= secondHalfStart ? secondHalfRotationMatrix * glm::vec4(glm::vec3(actinRods[i]), 1.0f) : actinRods[i];
+		discs.push_back(glm::vec4(rod.x, rod.z, i >= secondHalfStart ? 2.0f : 1.0f, 0.0f));
+	}
+	m_numFilaments = static_cast<int>(discs.size());
+	m_dirty = false;
+	if (discs.empty())
+	{
+		m_gridSize = glm::ivec2(0);
+		return;
+	}
+
+	//cells about d11 wide hold a few filaments each, a disc never reaches further than one cell
+	glm::vec2 minPosition = glm::vec2(discs[0]);
+	glm::vec2 maxPosition = minPosition;
+	for (const glm::vec4& disc : discs)
+	{
+		minPosition = glm::min(minPosition, glm::vec2(disc));
+		maxPosition = glm::max(maxPosition, glm::vec2(disc));
+	}
+	m_cellSize = std::max(m_d10 / glm::sqrt(3.0f), 2.0f * std::max(m_actinRadius, m_myosinRadius));
+	m_gridOrigin = minPosition - glm::vec2(m_cellSize);
+	m_gridSize = glm::ivec2((maxPosition - m_gridOrigin) / m_cellSize) + 2;
+
+	//counting sort of the filaments by cell
+	auto cellIndex = [&](const glm::vec4& disc)
+	{
+		glm::ivec2 cell = glm::ivec2((glm::vec2(disc) - m_gridOrigin) / m_cellSize);
+		return cell.y * m_gridSize.x + cell.x;
+	};
+	std::vector<GLint> cellStart(static_cast<size_t>(m_gridSize.x) * m_gridSize.y + 1, 0);
+	for (const glm::vec4& disc : discs)
+	{
+		cellStart[cellIndex(disc) + 1]++;
+	}
+	for (size_t i = 1; i < cellStart.size(); i++)
+	{
+		cellStart[i] += cellStart[i - 1];
+	}
+	std::vector<GLint> cellFill(cellStart.begin(), cellStart.end() - 1);
+	std::vector<glm::vec4> sortedDiscs(discs.size());
+	for (const glm::vec4& disc : discs)
+	{
+		sortedDiscs[cellFill[cellIndex(disc)]++] = disc;
+	}
+
+	glDeleteBuffers(1, &m_cellBuffer);
+	glCreateBuffers(1, &m_cellBuffer);
+	glNamedBufferStorage(m_cellBuffer, cellStart.size() * sizeof(GLint), cellStart.data(), 0);
+	glDeleteBuffers(1, &m_discBuffer);
+	glCreateBuffers(1, &m_discBuffer);
+	glNamedBufferStorage(m_discBuffer, sortedDiscs.size() * sizeof(glm::vec4), sortedDiscs.data(), 0);
+}
+
+void CrossSectionView::setDimensions(glm::vec3 midPoint, float d10, float sarcomereLength, float actinLength, float myosinLength, float actinRadius, float myosinRadius)
+{
+	//the grid is built for the spacing and the radii, a change moves the filaments as well
+	if (d10 != m_d10 || actinRadius != m_actinRadius || myosinRadius != m_myosinRadius)
+	{
+		m_dirty = true;
+	}
+	m_midPoint = midPoint;
+	m_d10 = d10;
+	m_sarcomereLength = sarcomereLength;
+	m_actinLength = actinLength;
+	m_myosinLength = myosinLength;
+	m_actinRadius = actinRadius;
+	m_myosinRadius = myosinRadius;
+}
+
+bool CrossSectionView::needsFilaments()
+{
+	return m_dirty;
+}
+
+void CrossSectionView::invalidate()
+{
+	m_dirty = true;
+}
+
+bool CrossSectionView::handleInput(GLFWwindow* window, CrossSectionSettings& settings, bool mouseCaptured)
+{
+	bool pan = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+	bool zoom = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+	glm::dvec2 cursor;
+	glfwGetCursorPos(window, &cursor.x, &cursor.y);
+	if (!(pan || zoom) || mouseCaptured)
+	{
+		m_dragging = false;
+		return false;
+	}
+	if (!m_dragging)
+	{
+		m_dragging = true;
+		m_lastCursor = cursor;
+		return false;
+	}
+	int windowWidth, windowHeight;
+	glfwGetWindowSize(window, &windowWidth, &windowHeight);
+	glm::vec2 delta = glm::vec2(cursor - m_lastCursor) / static_cast<float>(std::max(windowHeight, 1));
+	m_lastCursor = cursor;
+	if (delta == glm::vec2(0.0f))
+	{
+		return false;
+	}
+	if (pan)
+	{
+		//the view follows the cursor, z points down in window coordinates
+		settings.center -= glm::vec2(delta.x, -delta.y) * settings.zoom;
+	}
+	else
+	{
+		settings.zoom = glm::clamp(settings.zoom * std::exp(2.0f * delta.y), 1.0f, 10000.0f);
+	}
+	return true;
+}
+
+void CrossSectionView::render(const CrossSectionSettings& settings, int width, int height, glm::vec3 actinColor, glm::vec3 myosinColor)
+{
+	int last_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
+	glDisable(GL_DEPTH_TEST);
+	glColorMaski(1, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	//the view spans zoom d10 vertically and keeps the aspect ratio of the framebuffer
+	glm::vec2 extent = glm::vec2(settings.zoom * width / static_cast<float>(std::max(height, 1)), settings.zoom) * m_d10;
+	glm::vec2 latticeCenter = glm::vec2(m_midPoint.x, m_midPoint.z);
+	float sliceY = m_midPoint.y + settings.slicePosition;
+	float halfLength = m_sarcomereLength / 2.0f;
+	m_sectionShader.updateUniform("viewCenter", latticeCenter + settings.center * m_d10);
+	m_sectionShader.updateUniform("viewExtent", extent);
+	m_sectionShader.updateUniform("pixelSize", extent.y / std::max(height, 1));
+	m_sectionShader.updateUniform("gridOrigin", m_gridOrigin);
+	m_sectionShader.updateUniform("gridSize", glm::vec2(m_gridSize));
+	m_sectionShader.updateUniform("cellSize", m_cellSize);
+	//a filament is cut if the section lies within its extent along the axis
+	m_sectionShader.updateUniform("myosinCut", std::abs(settings.slicePosition) <= m_myosinLength / 2.0f ? 1 : 0);
+	m_sectionShader.updateUniform("firstActinCut", sliceY >= m_midPoint.y - halfLength && sliceY <= m_midPoint.y - halfLength + m_actinLength ? 1 : 0);
+	m_sectionShader.updateUniform("secondActinCut", sliceY <= m_midPoint.y + halfLength && sliceY >= m_midPoint.y + halfLength - m_actinLength ? 1 : 0);
+	m_sectionShader.updateUniform("actinRadius", std::min(m_actinRadius, m_cellSize));
+	m_sectionShader.updateUniform("myosinRadius", std::min(m_myosinRadius, m_cellSize));
+	m_sectionShader.updateUniform("actinColor", actinColor);
+	m_sectionShader.updateUniform("myosinColor", myosinColor);
+	m_sectionShader.updateUniform("latticeCenter", latticeCenter);
+	m_sectionShader.updateUniform("d10", m_d10);
+	m_sectionShader.updateUniform("showUnitCells", settings.showUnitCells ? 1 : 0);
+	m_sectionShader.updateUniform("showSpacings", settings.showSpacings ? 1 : 0);
+	m_sectionShader.updateUniform("numFilaments", m_gridSize.x > 0 ? m_numFilaments : 0);
+	if (m_gridSize.x > 0)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 26, m_cellBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 27, m_discBuffer);
+	}
+	m_sectionShader.use();
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glColorMaski(1, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glBindVertexArray(last_vao);
+}
+
+int CrossSectionView::getNumFilaments()
+{
+	return m_numFilaments;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "shaderProgram.h"
+
+//parameters of the cross section window
+struct CrossSectionSettings
+{
+	//replace the 3D scene by the cross section
+	bool enabled = false;
+	//position of the section along the filaments, measured from the M-line
+	float slicePosition = 0.0f;
+	//center of the view relative to the central myosin filament in d10
+	glm::vec2 center = glm::vec2(0.0f);
+	//visible height of the view in d10
+	float zoom = 12.0f;
+	//primitive cells of the myosin lattice, the one at the center is highlighted
+	bool showUnitCells = true;
+	//lattice planes with the spacings d10 and d11
+	bool showSpacings = false;
+};
+
+// Draws a transverse section of the lattice in 2D with one full screen pass.
+// The filament positions are sorted into a uniform grid of cells about d11 wide (bindings 26 and 27),
+// each pixel looks up the 3x3 cells around it and shades the closest filament disc it lies in.
+// Whether a filament is cut by the section follows from its extent along the axis, so the view shows
+// the A-band, the I-band and the overlap zone of a slice. The cost depends only on the resolution,
+// a lattice of millions of filaments pans and zooms as fast as a small one.
+class CrossSectionView
+{
+public:
+	CrossSectionView();
+	~CrossSectionView();
+	// Sorts the filaments into the grid again, only done while the view is enabled
+	// * std::vector<glm::vec4> actinRods - filament offsets, the second half is rotated by secondHalfRotationMatrix
+	void setFilaments(const std::vector<glm::vec4>& actinRods, const std::vector<glm::vec4>& myosinRods, glm::mat4 secondHalfRotationMatrix);
+	// Sets the extents and spacings of the lattice, cheap enough to be called every frame
+	// * glm::vec3 midPoint - sarcomere space mid point, the M-line and the central myosin filament run through it
+	void setDimensions(glm::vec3 midPoint, float d10, float sarcomereLength, float actinLength, float myosinLength, float actinRadius, float myosinRadius);
+	// Returns true if the filaments have to be set again
+	bool needsFilaments();
+	// Marks the filaments as outdated, used when the sarcomere was regenerated
+	void invalidate();
+	// Pans with the left and zooms with the right mouse button, returns true if the view changed
+	// * bool mouseCaptured - true while the gui uses the mouse, a drag then neither starts nor continues
+	bool handleInput(GLFWwindow* window, CrossSectionSettings& settings, bool mouseCaptured);
+	// Draws the section into the bound framebuffer, the picking IDs are left untouched
+	void render(const CrossSectionSettings& settings, int width, int height, glm::vec3 actinColor, glm::vec3 myosinColor);
+	int getNumFilaments();
+private:
+	ShaderProgram m_sectionShader;
+	GLuint m_vao = 0;
+	//first entry of every cell followed by the total, and the filaments sorted by cell
+	GLuint m_cellBuffer = 0;
+	GLuint m_discBuffer = 0;
+	glm::vec2 m_gridOrigin = glm::vec2(0.0f);
+	glm::ivec2 m_gridSize = glm::ivec2(0);
+	float m_cellSize = 1.0f;
+	int m_numFilaments = 0;
+	bool m_dirty = true;
+	glm::vec3 m_midPoint = glm::vec3(0.0f);
+	float m_d10 = 1.0f;
+	float m_sarcomereLength = 0.0f;
+	float m_actinLength = 0.0f;
+	float m_myosinLength = 0.0f;
+	float m_actinRadius = 0.0f;
+	float m_myosinRadius = 0.0f;
+	bool m_dragging = false;
+	glm::dvec2 m_lastCursor = glm::dvec2(0.0);
+};
@@ -0,0 +1,79 @@
+#include "DynamicResolution.h"
+#include <glm/glm.hpp>
+
+DynamicResolution::DynamicResolution()
+{
+	glCreateQueries(GL_TIME_ELAPSED, NUM_QUERIES, m_queries.data());
+	m_pending.fill(false);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteQueries(NUM_QUERIES, m_queries.data());
+}
+
+void DynamicResolution::beginFrame()
+{
+	//all queries are in flight, skip the measurement of this frame
+	if (m_pending[m_writeIndex])
+	{
+		return;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_writeIndex]);
+	m_active = true;
+}
+
+void DynamicResolution::endFrame(const DynamicResolutionSettings& settings)
+{
+	if (m_active)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_pending[m_writeIndex] = true;
+		m_writeIndex = (m_writeIndex + 1) % NUM_QUERIES;
+		m_active = false;
+	}
+	//consume every finished measurement
+	bool measured = false;
+	while (m_pending[m_readIndex])
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[m_readIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[m_readIndex], GL_QUERY_RESULT, &elapsed);
+		m_gpuTime = static_cast<float>(elapsed) / 1000000.0f;
+		m_pending[m_readIndex] = false;
+		m_readIndex = (m_readIndex + 1) % NUM_QUERIES;
+		measured = true;
+	}
+	if (!settings.enabled)
+	{
+		m_scale = 1.0f;
+		m_targetScale = 1.0f;
+		return;
+	}
+	if (measured && m_gpuTime > 0.0f)
+	{
+		//the cost grows with the pixel count, so the scale of each axis goes with the square root
+		float idealScale = m_scale * glm::sqrt(settings.targetFrameTime / m_gpuTime);
+		m_targetScale = glm::clamp(glm::mix(m_targetScale, idealScale, 0.1f), settings.minScale, 1.0f);
+	}
+	//only step the resolution once the target moved a whole step away
+	if (glm::abs(m_targetScale - m_scale) >= SCALE_STEP)
+	{
+		m_scale = glm::clamp(glm::round(m_targetScale / SCALE_STEP) * SCALE_STEP, settings.minScale, 1.0f);
+	}
+}
+
+float DynamicResolution::getScale()
+{
+	return m_scale;
+}
+
+float DynamicResolution::getGPUTime()
+{
+	return m_gpuTime;
+}
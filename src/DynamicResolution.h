@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <array>
+
+//parameters of the dynamic resolution window
+struct DynamicResolutionSettings
+{
+	bool enabled = false;
+	//gpu time of the scene in milliseconds the controller aims for
+	float targetFrameTime = 16.6f;
+	float minScale = 0.5f;
+};
+
+// Adjusts the render resolution of the scene to hold a target gpu frame time.
+// The scene passes are measured with timer queries, which are read a few frames later so the
+// cpu never waits for them. The scale follows the measured time with damping and is quantized,
+// so the scene framebuffer is only recreated when the resolution changes noticeably.
+class DynamicResolution
+{
+public:
+	DynamicResolution();
+	~DynamicResolution();
+	// Starts measuring the gpu time of the scene, has to be followed by endFrame()
+	void beginFrame();
+	// Stops measuring and updates the scale with the finished measurements
+	void endFrame(const DynamicResolutionSettings& settings);
+	// Returns the factor for width and height of the render resolution
+	float getScale();
+	// Returns the last measured gpu time of the scene in milliseconds
+	float getGPUTime();
+private:
+	static constexpr int NUM_QUERIES = 4;
+	static constexpr float SCALE_STEP = 0.05f;
+	std::array<GLuint, NUM_QUERIES> m_queries;
+	std::array<bool, NUM_QUERIES> m_pending;
+	int m_writeIndex = 0;
+	int m_readIndex = 0;
+	bool m_active = false;
+	float m_scale = 1.0f;
+	float m_targetScale = 1.0f;
+	float m_gpuTime = 0.0f;
+};
@@ -0,0 +1,300 @@
+#include "FilamentImpostors.h"
+#include "Sarcomere.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	glm::vec2 signNotZero(glm::vec2 v)
+	{
+		return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	//unit vector to [0, 1]^2, the lower half of the sphere is folded over the diagonals, same as impostor.vert
+	glm::vec2 octEncode(glm::vec3 n)
+	{
+		n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+		glm::vec2 e = n.z >= 0.0f ? glm::vec2(n) : (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n));
+		return e * 0.5f + 0.5f;
+	}
+
+	glm::vec3 octDecode(glm::vec2 f)
+	{
+		f = f * 2.0f - 1.0f;
+		glm::vec3 n(f.x, f.y, 1.0f - glm::abs(f.x) - glm::abs(f.y));
+		if (n.z < 0.0f)
+		{
+			glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n));
+			n.x = folded.x;
+			n.y = folded.y;
+		}
+		return glm::normalize(n);
+	}
+
+	//image axes of the view along a direction, the filament axis points up unless the view runs along it
+	void viewBasis(glm::vec3 direction, glm::vec3& right, glm::vec3& up)
+	{
+		glm::vec3 reference = glm::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		right = glm::normalize(glm::cross(reference, direction));
+		up = glm::cross(direction, right);
+	}
+
+	uint16_t toUnorm16(float value)
+	{
+		return static_cast<uint16_t>(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+}
+
+FilamentImpostors::FilamentImpostors()
+{
+	m_colors.fill(glm::vec3(1.0f));
+}
+
+FilamentImpostors::~FilamentImpostors()
+{
+	glDeleteTextures(NUM_KINDS, m_atlases.data());
+	glDeleteBuffers(NUM_KINDS, m_segmentBuffers.data());
+}
+
+void FilamentImpostors::setGroup(CullGroup group, const CullGroupDescription& description, glm::vec3 color)
+{
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		if (std::find(DETAIL_GROUPS[kind].begin(), DETAIL_GROUPS[kind].end(), group) == DETAIL_GROUPS[kind].end())
+		{
+			continue;
+		}
+		CullGroupDescription& current = m_groups[static_cast<int>(group)];
+		if (current != description)
+		{
+			current = description;
+			m_dirty[kind] = true;
+		}
+		m_colors[static_cast<int>(group)] = color;
+	}
+}
+
+void FilamentImpostors::setHelices(bool bothHelices)
+{
+	if (bothHelices != m_bothHelices)
+	{
+		m_bothHelices = bothHelices;
+		m_dirty[1] = true;
+	}
+}
+
+void FilamentImpostors::invalidate()
+{
+	m_dirty.fill(true);
+}
+
+void FilamentImpostors::update(Sarcomere& sarcomere)
+{
+	//the culler, the selection and the color mapping read the centers like the other element offsets
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_segmentBuffers[0]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, m_segmentBuffers[1]);
+	//a filament without detail keeps its dirty atlas until the detail is back
+	bool needsBake = false;
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		needsBake = needsBake || (m_dirty[kind] && hasDetail(kind));
+	}
+	if (!needsBake)
+	{
+		return;
+	}
+	//the baker only needs the templates, one instance per structure is enough
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		CullGroupDescription description = m_groups[i];
+		description.numFilaments = std::min(description.numFilaments, 1);
+		m_baker.setGroup(static_cast<CullGroup>(i), description);
+	}
+	m_baker.build(sarcomere, m_bothHelices);
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		if (m_dirty[kind] && hasDetail(kind))
+		{
+			bake(kind);
+			m_dirty[kind] = false;
+		}
+	}
+}
+
+CullGroupDescription FilamentImpostors::getDescription(CullGroup group)
+{
+	int kind = getKind(group);
+	const ImpostorLayout& layout = m_layouts[kind];
+	CullGroupDescription description;
+	description.filamentBinding = kind == 1 ? 2 : 3;
+	description.elementBinding = kind == 1 ? 11 : 10;
+	for (CullGroup detailGroup : DETAIL_GROUPS[kind])
+	{
+		const CullGroupDescription& detail = m_groups[static_cast<int>(detailGroup)];
+		if (detail.enabled)
+		{
+			description.enabled = m_atlases[kind] != 0;
+			description.numFilaments = std::max(description.numFilaments, detail.numFilaments);
+			description.secondHalfStart = detail.secondHalfStart;
+		}
+	}
+	description.numElements = std::max(layout.numSegments, 1);
+	description.boundingRadius = layout.size / 2.0f;
+	description.vertexCount = 4;
+	description.perFilamentDraws = true;
+	return description;
+}
+
+ImpostorLayout FilamentImpostors::getLayout(CullGroup group)
+{
+	return m_layouts[getKind(group)];
+}
+
+const std::array<CullGroup, FilamentImpostors::NUM_SLOTS>& FilamentImpostors::getSlots(CullGroup group)
+{
+	return DETAIL_GROUPS[getKind(group)];
+}
+
+bool FilamentImpostors::bind(CullGroup group, ShaderProgram& shader, GLuint unit)
+{
+	int kind = getKind(group);
+	const ImpostorLayout& layout = m_layouts[kind];
+	if (m_atlases[kind] == 0 || !hasDetail(kind))
+	{
+		return false;
+	}
+	glBindTextureUnit(unit, m_atlases[kind]);
+	std::array<glm::vec4, NUM_SLOTS> colors;
+	for (int slot = 0; slot < NUM_SLOTS; slot++)
+	{
+		colors[slot] = glm::vec4(m_colors[static_cast<int>(DETAIL_GROUPS[kind][slot])], 1.0f);
+	}
+	shader.updateUniform("atlas", static_cast<int>(unit));
+	shader.updateUniform("gridSize", GRID_SIZE);
+	shader.updateUniform("filamentType", kind);
+	shader.updateUniform("secondHalfStart", getDescription(group).secondHalfStart);
+	shader.updateUniform("segmentStart", layout.start);
+	shader.updateUniform("segmentLength", layout.length);
+	shader.updateUniform("segmentAxis", layout.axis);
+	shader.updateUniform("segmentRadius", layout.size / 2.0f);
+	shader.updateUniform("groupColors", colors.data(), NUM_SLOTS);
+	return true;
+}
+
+size_t FilamentImpostors::getMemoryUsage()
+{
+	size_t side = GRID_SIZE * CELL_SIZE;
+	size_t size = 0;
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		size += m_atlases[kind] != 0 ? side * side * m_layouts[kind].numSegments * 4 * sizeof(uint16_t) : 0;
+		size += m_segmentBuffers[kind] != 0 ? m_layouts[kind].numSegments * sizeof(glm::vec4) : 0;
+	}
+	return size;
+}
+
+int FilamentImpostors::getKind(CullGroup group)
+{
+	return group == CullGroup::MYOSIN_IMPOSTORS || group == CullGroup::LMM || group == CullGroup::HMM || group == CullGroup::MYOSIN_HEADS ? 1 : 0;
+}
+
+bool FilamentImpostors::hasDetail(int kind)
+{
+	for (CullGroup group : DETAIL_GROUPS[kind])
+	{
+		if (m_groups[static_cast<int>(group)].enabled)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FilamentImpostors::bake(int kind)
+{
+	glDeleteTextures(1, &m_atlases[kind]);
+	glDeleteBuffers(1, &m_segmentBuffers[kind]);
+	m_atlases[kind] = 0;
+	m_segmentBuffers[kind] = 0;
+	m_layouts[kind] = ImpostorLayout();
+	int filamentBinding = kind == 1 ? 2 : 3;
+	glm::vec3 boundsMin, boundsMax;
+	if (!m_baker.getLocalBounds(filamentBinding, boundsMin, boundsMax))
+	{
+		return;
+	}
+
+	//segments about twice as long as the filament is wide keep most of the square quads covered
+	ImpostorLayout layout;
+	glm::vec2 extent = glm::vec2(boundsMax.x - boundsMin.x, boundsMax.z - boundsMin.z);
+	float radius = std::max(glm::length(extent) / 2.0f, 0.000001f);
+	float filamentLength = std::max(boundsMax.y - boundsMin.y, 0.000001f);
+	layout.numSegments = glm::clamp(static_cast<int>(std::ceil(filamentLength / (4.0f * radius))), 1, MAX_SEGMENTS);
+	layout.start = boundsMin.y;
+	layout.length = filamentLength / layout.numSegments;
+	layout.axis = glm::vec2(boundsMin.x + boundsMax.x, boundsMin.z + boundsMax.z) / 2.0f;
+	float halfSize = glm::length(glm::vec2(layout.length / 2.0f, radius));
+	layout.size = 2.0f * halfSize;
+
+	int side = GRID_SIZE * CELL_SIZE;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_atlases[kind]);
+	glTextureStorage3D(m_atlases[kind], 1, GL_RGBA16, side, side, layout.numSegments);
+	//the slot of a pixel must not be interpolated, the shader blends the views itself
+	glTextureParameteri(m_atlases[kind], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_atlases[kind], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_atlases[kind], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(m_atlases[kind], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	std::vector<uint16_t> pixels(static_cast<size_t>(side) * side * 4);
+	for (int segment = 0; segment < layout.numSegments; segment++)
+	{
+		//the structures of the neighbouring segments are cut off, they have impostors of their own
+		float segmentStart = layout.start + segment * layout.length;
+		glm::vec3 center = glm::vec3(layout.axis.x, segmentStart + layout.length / 2.0f, layout.axis.y);
+		std::vector<glm::vec4> planes = { glm::vec4(0.0f, 1.0f, 0.0f, -segmentStart), glm::vec4(0.0f, -1.0f, 0.0f, segmentStart + layout.length) };
+		#pragma omp parallel for schedule(dynamic)
+		for (int cell = 0; cell < GRID_SIZE * GRID_SIZE; cell++)
+		{
+			int cellX = cell % GRID_SIZE;
+			int cellY = cell / GRID_SIZE;
+			glm::vec3 direction = octDecode((glm::vec2(cellX, cellY) + 0.5f) / static_cast<float>(GRID_SIZE));
+			glm::vec3 right, up;
+			viewBasis(direction, right, up);
+			std::vector<LocalSample> samples(CELL_SIZE * CELL_SIZE);
+			m_baker.traceLocal(filamentBinding, center, direction, right, up, halfSize, planes, CELL_SIZE, samples.data());
+			for (int y = 0; y < CELL_SIZE; y++)
+			{
+				for (int x = 0; x < CELL_SIZE; x++)
+				{
+					const LocalSample& sample = samples[y * CELL_SIZE + x];
+					uint16_t* texel = &pixels[(static_cast<size_t>(cellY * CELL_SIZE + y) * side + cellX * CELL_SIZE + x) * 4];
+					const auto& slots = DETAIL_GROUPS[kind];
+					int slot = static_cast<int>(std::find(slots.begin(), slots.end(), static_cast<CullGroup>(sample.group)) - slots.begin());
+					if (sample.group < 0 || slot >= NUM_SLOTS)
+					{
+						std::fill(texel, texel + 4, static_cast<uint16_t>(0));
+						continue;
+					}
+					//rg = local normal, b = depth in units of the bounding radius, a = slot + 1, 0 = empty
+					glm::vec2 normal = octEncode(sample.normal);
+					texel[0] = toUnorm16(normal.x);
+					texel[1] = toUnorm16(normal.y);
+					texel[2] = toUnorm16(sample.depth / halfSize * 0.5f + 0.5f);
+					texel[3] = toUnorm16((slot + 1) / 4.0f);
+				}
+			}
+		}
+		glTextureSubImage3D(m_atlases[kind], 0, 0, 0, segment, side, side, 1, GL_RGBA, GL_UNSIGNED_SHORT, pixels.data());
+	}
+
+	std::vector<glm::vec4> centers(layout.numSegments);
+	for (int segment = 0; segment < layout.numSegments; segment++)
+	{
+		centers[segment] = glm::vec4(layout.axis.x, layout.start + (segment + 0.5f) * layout.length, layout.axis.y, 0.0f);
+	}
+	glCreateBuffers(1, &m_segmentBuffers[kind]);
+	glNamedBufferStorage(m_segmentBuffers[kind], centers.size() * sizeof(glm::vec4), centers.data(), 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kind == 1 ? 11 : 10, m_segmentBuffers[kind]);
+	m_layouts[kind] = layout;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include "InstanceCuller.h"
+#include "RayTracer.h"
+#include "shaderProgram.h"
+
+class Sarcomere;
+
+// Pre-rendered octahedral impostors of the far segments of the thin and the thick filaments.
+// Every filament is cut into segments along its axis about twice as long as it is wide. Each segment is
+// baked from GRID_SIZE x GRID_SIZE directions spread over the sphere by an octahedral map, with the local
+// normal, the depth and the structure of every pixel, by tracing the structures of one filament with the
+// RayTracer. The thin filaments bake their monomers, troponin and tropomyosin, the thick filaments their
+// LMM, HMM and heads, the rods are drawn as they are. All filaments of a kind share the atlases, one layer
+// per segment. The culler swaps the detail of the segments that get small on screen for one camera facing
+// quad per segment (ACTIN_IMPOSTORS and MYOSIN_IMPOSTORS), whose shader blends the four views closest to
+// the view direction and writes the baked depth, so the impostors intersect the rest of the scene.
+// The centers of the segments are the element offsets of the impostor groups (binding 10 for the thin and
+// 11 for the thick filaments), so the selection and the color mapping place the impostors like any instance.
+// The atlases are baked again after invalidate() or a change of the groups, the colors are applied when drawn.
+class FilamentImpostors
+{
+public:
+	static constexpr int GRID_SIZE = 8;
+	static constexpr int CELL_SIZE = 32;
+	static constexpr int MAX_SEGMENTS = 32;
+	//structures baked into the impostors of a filament
+	static constexpr int NUM_SLOTS = 3;
+	FilamentImpostors();
+	~FilamentImpostors();
+	// Sets a detail group baked into the impostors of its filament and its color, the other groups are ignored
+	// * CullGroup group - ACTIN_MONOMERS, TROPONIN, TROPOMYOSIN, LMM, HMM or MYOSIN_HEADS
+	void setGroup(CullGroup group, const CullGroupDescription& description, glm::vec3 color);
+	// * bool bothHelices - bakes the second helix of every LMM and HMM piece
+	void setHelices(bool bothHelices);
+	// Bakes the atlases again before the next draw, used when the structures were generated again
+	void invalidate();
+	// Bakes the outdated atlases of the filaments that have any detail enabled from the cpu arrays of the sarcomere
+	// and binds the segment centers
+	void update(Sarcomere& sarcomere);
+	// Returns the instances of an impostor group for the culler, disabled until its atlas is baked
+	// * CullGroup group - ACTIN_IMPOSTORS or MYOSIN_IMPOSTORS
+	CullGroupDescription getDescription(CullGroup group);
+	ImpostorLayout getLayout(CullGroup group);
+	// Returns the detail groups of an impostor group by their slot in the atlas
+	const std::array<CullGroup, NUM_SLOTS>& getSlots(CullGroup group);
+	// Binds the atlas of an impostor group to a texture unit and sets the uniforms of the impostor shader,
+	// returns false if there is nothing to draw
+	bool bind(CullGroup group, ShaderProgram& shader, GLuint unit);
+	size_t getMemoryUsage();
+private:
+	static constexpr int NUM_KINDS = 2;
+	//detail groups of the thin and the thick filaments, the index of a group is its slot in the atlas
+	static constexpr std::array<std::array<CullGroup, NUM_SLOTS>, NUM_KINDS> DETAIL_GROUPS = { {
+		{ CullGroup::ACTIN_MONOMERS, CullGroup::TROPONIN, CullGroup::TROPOMYOSIN },
+		{ CullGroup::LMM, CullGroup::HMM, CullGroup::MYOSIN_HEADS } } };
+	static int getKind(CullGroup group);
+	bool hasDetail(int kind);
+	void bake(int kind);
+	RayTracer m_baker;
+	std::array<CullGroupDescription, static_cast<int>(CullGroup::COUNT)> m_groups;
+	std::array<glm::vec3, static_cast<int>(CullGroup::COUNT)> m_colors;
+	bool m_bothHelices = true;
+	std::array<bool, NUM_KINDS> m_dirty = { true, true };
+	std::array<ImpostorLayout, NUM_KINDS> m_layouts;
+	//normal, depth and slot of every pixel, one layer per segment
+	std::array<GLuint, NUM_KINDS> m_atlases = { 0, 0 };
+	//local center of every segment
+	std::array<GLuint, NUM_KINDS> m_segmentBuffers = { 0, 0 };
+};
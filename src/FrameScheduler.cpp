@@ -0,0 +1,59 @@
+#include "FrameScheduler.h"
+#include <GLFW/glfw3.h>
+
+FrameScheduler::FrameScheduler()
+{
+	m_lastFrameTime = glfwGetTime();
+}
+
+void FrameScheduler::invalidate(int frames)
+{
+	m_pendingFrames = glm::max(m_pendingFrames, frames);
+}
+
+bool FrameScheduler::beginFrame(const RenderOnDemandSettings& settings, glm::mat4 viewProjection, int width, int height, int settleFrames)
+{
+	if (viewProjection != m_lastViewProjection || width != m_lastWidth || height != m_lastHeight)
+	{
+		m_lastViewProjection = viewProjection;
+		m_lastWidth = width;
+		m_lastHeight = height;
+		invalidate(settleFrames);
+	}
+	if (!settings.enabled)
+	{
+		m_pendingFrames = 0;
+		return true;
+	}
+	if (m_pendingFrames > 0)
+	{
+		m_pendingFrames--;
+		return true;
+	}
+	return false;
+}
+
+void FrameScheduler::waitForNextFrame(const RenderOnDemandSettings& settings)
+{
+	if (!settings.enabled)
+	{
+		glfwPollEvents();
+		m_lastFrameTime = glfwGetTime();
+		return;
+	}
+	//hold the cap, the events arriving meanwhile are processed
+	double nextFrameTime = m_lastFrameTime + 1.0 / glm::max(settings.maxFPS, 1.0f);
+	for (double now = glfwGetTime(); now < nextFrameTime; now = glfwGetTime())
+	{
+		glfwWaitEventsTimeout(nextFrameTime - now);
+	}
+	if (m_pendingFrames > 0)
+	{
+		glfwPollEvents();
+	}
+	else
+	{
+		glfwWaitEventsTimeout(IDLE_TIMEOUT);
+	}
+	m_lastFrameTime = glfwGetTime();
+}
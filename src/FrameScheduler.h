@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+//parameters of the render on demand mode
+struct RenderOnDemandSettings
+{
+	bool enabled = false;
+	//frame-rate cap while the scene changes
+	float maxFPS = 60.0f;
+};
+
+// Decides whether the scene has to be drawn and how long the render loop waits.
+// In render on demand mode the scene is only drawn after the view, the scene size or something
+// that called invalidate() changed, the last frame is shown otherwise. Without pending frames the
+// loop sleeps in glfwWaitEventsTimeout until the next input event, so an idle window costs nothing.
+class FrameScheduler
+{
+public:
+	FrameScheduler();
+	// Requests the scene to be drawn in the next frames
+	// * int frames - more than one frame lets temporal effects converge after the change
+	void invalidate(int frames = 1);
+	// Returns true if the scene has to be drawn this frame
+	// * int settleFrames - frames drawn after a view or size change
+	bool beginFrame(const RenderOnDemandSettings& settings, glm::mat4 viewProjection, int width, int height, int settleFrames);
+	// Processes the window events, waits for the next one if there is nothing to draw and limits the frame rate
+	void waitForNextFrame(const RenderOnDemandSettings& settings);
+private:
+	//idle timeout, keeps the window title and asynchronous readbacks updated
+	static constexpr double IDLE_TIMEOUT = 1.0;
+	glm::mat4 m_lastViewProjection = glm::mat4(0.0f);
+	int m_lastWidth = 0;
+	int m_lastHeight = 0;
+	int m_pendingFrames = 1;
+	double m_lastFrameTime = 0.0;
+};
@@ -0,0 +1,659 @@
+#include "InstanceCuller.h"
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+
+bool CullGroupDescription::operator==(const CullGroupDescription& other) const
+{
+	return enabled == other.enabled &&
+		filamentBinding == other.filamentBinding &&
+		elementBinding == other.elementBinding &&
+		numFilaments == other.numFilaments &&
+		numElements == other.numElements &&
+		elementSpacing == other.elementSpacing &&
+		axisStart == other.axisStart &&
+		axisEnd == other.axisEnd &&
+		boundingRadius == other.boundingRadius &&
+		secondHalfStart == other.secondHalfStart &&
+		vertexCount == other.vertexCount &&
+		perFilamentDraws == other.perFilamentDraws &&
+		lodPointSize == other.lodPointSize;
+}
+
+bool CullGroupDescription::operator!=(const CullGroupDescription& other) const
+{
+	return !(*this == other);
+}
+
+bool ImpostorLayout::operator==(const ImpostorLayout& other) const
+{
+	return numSegments == other.numSegments &&
+		start == other.start &&
+		length == other.length &&
+		axis == other.axis &&
+		size == other.size;
+}
+
+bool ImpostorLayout::operator!=(const ImpostorLayout& other) const
+{
+	return !(*this == other);
+}
+
+std::vector<glm::vec4> ClipSettings::getPlanes(glm::vec3 midPoint) const
+{
+	std::vector<glm::vec4> planes;
+	if (mode == SLAB)
+	{
+		glm::vec3 normal = glm::normalize(slabNormal);
+		glm::vec3 center = midPoint + normal * slabCenter;
+		//two opposing planes, each half of the thickness away from the center
+		planes.push_back(glm::vec4(normal, -glm::dot(normal, center) + slabThickness / 2.0f));
+		planes.push_back(glm::vec4(-normal, glm::dot(normal, center) + slabThickness / 2.0f));
+	}
+	else if (mode == PLANES)
+	{
+		for (int i = 0; i < static_cast<int>(planeEnabled.size()); i++)
+		{
+			if (!planeEnabled[i] || glm::length(planeNormals[i]) == 0.0f)
+			{
+				continue;
+			}
+			glm::vec3 normal = glm::normalize(planeNormals[i]);
+			glm::vec3 point = midPoint + normal * planeOffsets[i];
+			planes.push_back(glm::vec4(normal, -glm::dot(normal, point)));
+		}
+	}
+	return planes;
+}
+
+std::vector<glm::vec4> getFrustumPlanes(glm::mat4 viewProjection)
+{
+	glm::vec4 row0 = glm::row(viewProjection, 0);
+	glm::vec4 row1 = glm::row(viewProjection, 1);
+	glm::vec4 row2 = glm::row(viewProjection, 2);
+	glm::vec4 row3 = glm::row(viewProjection, 3);
+	std::vector<glm::vec4> planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+	//normalize so the distances can be compared against bounding radii
+	for (glm::vec4& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return planes;
+}
+
+InstanceCuller::InstanceCuller() : m_cullShader(SHADERS_PATH "/cullInstances.comp"), m_sortShader(SHADERS_PATH "/sortInstances.comp")
+{
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_offsetAlignment);
+	//gl_DrawIDARB and gl_BaseInstanceARB address the filament records of the per filament draws
+	if (!GLEW_ARB_shader_draw_parameters)
+	{
+		std::cout << "FAIL: GL_ARB_shader_draw_parameters is not supported, the filament structures can not be drawn" << std::endl;
+	}
+	glCreateBuffers(1, &m_commandBuffer);
+	glNamedBufferStorage(m_commandBuffer, sizeof(DrawCommand) * static_cast<int>(CullGroup::COUNT), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &m_bucketBuffer);
+	glNamedBufferStorage(m_bucketBuffer, sizeof(GLuint) * NUM_SORT_BUCKETS * static_cast<int>(CullGroup::COUNT), nullptr, 0);
+	glCreateBuffers(1, &m_splatDispatchBuffer);
+	glNamedBufferStorage(m_splatDispatchBuffer, sizeof(SplatDispatch) * static_cast<int>(CullGroup::COUNT), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	m_sectionOffsets.fill(0);
+	m_sectionSizes.fill(0);
+	m_drawOffsets.fill(0);
+	m_selectionOffsets.fill(-1);
+	m_selectionSlots.fill(1);
+}
+
+InstanceCuller::~InstanceCuller()
+{
+	glDeleteBuffers(1, &m_commandBuffer);
+	glDeleteBuffers(1, &m_visibleBuffer);
+	glDeleteBuffers(1, &m_sortedBuffer);
+	glDeleteBuffers(1, &m_bucketBuffer);
+	glDeleteBuffers(1, &m_drawBuffer);
+	glDeleteBuffers(1, &m_sortedDrawBuffer);
+	glDeleteBuffers(1, &m_splatBuffer);
+	glDeleteBuffers(1, &m_splatDispatchBuffer);
+	glDeleteBuffers(1, &m_tileRangeBuffer);
+}
+
+void InstanceCuller::setClipPlanes(const std::vector<glm::vec4>& planes)
+{
+	std::vector<glm::vec4> clipPlanes(planes.begin(), planes.begin() + std::min(static_cast<int>(planes.size()), MAX_CLIP_PLANES));
+	if (clipPlanes != m_clipPlanes)
+	{
+		m_clipPlanes = clipPlanes;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setCullFrustum(const std::vector<glm::vec4>& planes)
+{
+	if (planes != m_frustumPlanes)
+	{
+		m_frustumPlanes = planes;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setGroup(CullGroup group, const CullGroupDescription& description)
+{
+	CullGroupDescription& current = m_groups[static_cast<int>(group)];
+	if (current != description)
+	{
+		current = description;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setChildCounts(CullGroup group, const std::vector<int>& childCounts)
+{
+	std::vector<int>& current = m_childCounts[static_cast<int>(group)];
+	if (current != childCounts)
+	{
+		current = childCounts;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix)
+{
+	if (rotationMatrix != m_rotationMatrix || secondHalfRotationMatrix != m_secondHalfRotationMatrix)
+	{
+		m_rotationMatrix = rotationMatrix;
+		m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setSortView(bool frontToBack, glm::mat4 view, glm::vec3 center, float radius)
+{
+	if (frontToBack != m_frontToBack || (frontToBack && (view != m_sortView || center != m_sortCenter || radius != m_sortRadius)))
+	{
+		m_frontToBack = frontToBack;
+		m_sortView = view;
+		m_sortCenter = center;
+		m_sortRadius = radius;
+		m_sortDirty = true;
+	}
+}
+
+void InstanceCuller::setSelection(GLuint maskBuffer, const std::array<int, static_cast<int>(CullGroup::COUNT)>& bitOffsets, const std::array<int, static_cast<int>(CullGroup::COUNT)>& bitsPerInstance)
+{
+	if (maskBuffer != m_selectionBuffer || bitOffsets != m_selectionOffsets || bitsPerInstance != m_selectionSlots)
+	{
+		m_selectionBuffer = maskBuffer;
+		m_selectionOffsets = bitOffsets;
+		m_selectionSlots = bitsPerInstance;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setLevelOfDetail(const LevelOfDetailSettings& settings, glm::vec3 eye, float pixelScale, float tolerance)
+{
+	bool changed = settings.enabled != m_lodSettings.enabled || settings.splatSubPixel != m_lodSettings.splatSubPixel || settings.impostors != m_lodSettings.impostors;
+	if (settings.enabled || settings.splatSubPixel || settings.impostors)
+	{
+		//the fade width only changes the sprite shaders, the tolerance of the last pass stays valid until the eye left it
+		bool fractionChanged = settings.enabled && (settings.targetPixels != m_lodSettings.targetPixels || settings.minFraction != m_lodSettings.minFraction);
+		bool impostorsChanged = settings.impostors && settings.impostorPixels != m_lodSettings.impostorPixels;
+		changed = changed || fractionChanged || impostorsChanged || pixelScale != m_lodPixelScale || glm::length(eye - m_lodEye) > m_lodTolerance;
+	}
+	if (changed)
+	{
+		m_lodSettings = settings;
+		m_lodEye = eye;
+		m_lodPixelScale = pixelScale;
+		m_lodTolerance = tolerance;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setImpostors(CullGroup group, const ImpostorLayout& layout)
+{
+	ImpostorLayout& current = m_impostorLayouts[group == CullGroup::MYOSIN_IMPOSTORS ? 1 : 0];
+	if (current != layout)
+	{
+		current = layout;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::setTiles(const LatticeTiles* tiles)
+{
+	if (tiles != m_tiles)
+	{
+		m_tiles = tiles;
+		m_dirty = true;
+	}
+}
+
+void InstanceCuller::invalidate()
+{
+	m_dirty = true;
+}
+
+void InstanceCuller::update()
+{
+	if (m_dirty)
+	{
+		m_dirty = false;
+		cull();
+		m_generation++;
+		m_sortDirty = true;
+	}
+	if (m_frontToBack && m_sortDirty)
+	{
+		m_sortDirty = false;
+		sort();
+	}
+}
+
+void InstanceCuller::cull()
+{
+	//lay out one aligned section per group in the visible instance buffer
+	GLsizeiptr totalSize = 0;
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		GLsizeiptr numInstances = group.enabled ? static_cast<GLsizeiptr>(group.numFilaments) * group.numElements : 0;
+		m_sectionOffsets[i] = totalSize;
+		m_sectionSizes[i] = std::max<GLsizeiptr>(numInstances, 1) * sizeof(GLuint);
+		totalSize += ((m_sectionSizes[i] + m_offsetAlignment - 1) / m_offsetAlignment) * m_offsetAlignment;
+	}
+	if (totalSize > m_visibleBufferSize)
+	{
+		glDeleteBuffers(1, &m_visibleBuffer);
+		glCreateBuffers(1, &m_visibleBuffer);
+		glNamedBufferStorage(m_visibleBuffer, totalSize, nullptr, 0);
+		glDeleteBuffers(1, &m_sortedBuffer);
+		glCreateBuffers(1, &m_sortedBuffer);
+		glNamedBufferStorage(m_sortedBuffer, totalSize, nullptr, 0);
+		m_visibleBufferSize = totalSize;
+	}
+	//the splat lists are only allocated while they are used
+	m_splatting = m_lodSettings.splatSubPixel;
+	if (m_splatting && totalSize > m_splatBufferSize)
+	{
+		glDeleteBuffers(1, &m_splatBuffer);
+		glCreateBuffers(1, &m_splatBuffer);
+		glNamedBufferStorage(m_splatBuffer, totalSize, nullptr, 0);
+		m_splatBufferSize = totalSize;
+	}
+	else if (!m_splatting && m_splatBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_splatBuffer);
+		m_splatBuffer = 0;
+		m_splatBufferSize = 0;
+	}
+
+	//one aligned section of filament commands per group with per filament draws, each filament reserves
+	//numElements slots in the visible instances of its group
+	std::vector<FilamentDraw> filamentDraws;
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		if (!group.enabled || !group.perFilamentDraws)
+		{
+			continue;
+		}
+		while (filamentDraws.size() * sizeof(FilamentDraw) % m_offsetAlignment != 0)
+		{
+			filamentDraws.push_back({});
+		}
+		m_drawOffsets[i] = filamentDraws.size() * sizeof(FilamentDraw);
+		const std::vector<int>& childCounts = m_childCounts[i];
+		for (int filament = 0; filament < group.numFilaments; filament++)
+		{
+			int firstInstance = filament * group.numElements;
+			int numChildren = filament < static_cast<int>(childCounts.size()) ? std::min(childCounts[filament], group.numElements) : group.numElements;
+			filamentDraws.push_back({ static_cast<GLuint>(group.vertexCount), 0, 0, static_cast<GLuint>(firstInstance), filament, firstInstance, numChildren, 0 });
+		}
+	}
+	//test the lattice tiles against the same planes and distances as the instances, one aligned section
+	//of tile ranges per tiled group, the other groups dispatch all of their instances
+	std::vector<glm::vec4> cullPlanes = m_clipPlanes;
+	cullPlanes.insert(cullPlanes.end(), m_frustumPlanes.begin(), m_frustumPlanes.begin() + std::min(static_cast<int>(m_frustumPlanes.size()), 6));
+	std::vector<TileRange> tileRanges;
+	std::array<GLintptr, static_cast<int>(CullGroup::COUNT)> rangeOffsets;
+	std::array<int, static_cast<int>(CullGroup::COUNT)> numRanges;
+	std::array<int, static_cast<int>(CullGroup::COUNT)> numTiledInstances;
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		while (tileRanges.size() * sizeof(TileRange) % m_offsetAlignment != 0)
+		{
+			tileRanges.push_back({});
+		}
+		rangeOffsets[i] = tileRanges.size() * sizeof(TileRange);
+		size_t firstRange = tileRanges.size();
+		bool tiled = m_groups[i].enabled && getTileRanges(i, getImpostorRole(i), cullPlanes, tileRanges, numTiledInstances[i]);
+		numRanges[i] = tiled ? static_cast<int>(tileRanges.size() - firstRange) : -1;
+	}
+	GLsizeiptr rangeSize = std::max<GLsizeiptr>(tileRanges.size(), 1) * sizeof(TileRange);
+	if (rangeSize > m_tileRangeBufferSize)
+	{
+		glDeleteBuffers(1, &m_tileRangeBuffer);
+		glCreateBuffers(1, &m_tileRangeBuffer);
+		glNamedBufferStorage(m_tileRangeBuffer, rangeSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		m_tileRangeBufferSize = rangeSize;
+	}
+	if (!tileRanges.empty())
+	{
+		glNamedBufferSubData(m_tileRangeBuffer, 0, tileRanges.size() * sizeof(TileRange), tileRanges.data());
+	}
+
+	GLsizeiptr drawSize = filamentDraws.size() * sizeof(FilamentDraw);
+	if (drawSize > m_drawBufferSize)
+	{
+		glDeleteBuffers(1, &m_drawBuffer);
+		glCreateBuffers(1, &m_drawBuffer);
+		glNamedBufferStorage(m_drawBuffer, drawSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glDeleteBuffers(1, &m_sortedDrawBuffer);
+		glCreateBuffers(1, &m_sortedDrawBuffer);
+		glNamedBufferStorage(m_sortedDrawBuffer, drawSize, nullptr, 0);
+		m_drawBufferSize = drawSize;
+	}
+	if (drawSize > 0)
+	{
+		glNamedBufferSubData(m_drawBuffer, 0, drawSize, filamentDraws.data());
+	}
+
+	//reset the indirect commands, the instance counts are accumulated by the culling pass
+	std::array<DrawCommand, static_cast<int>(CullGroup::COUNT)> commands;
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		commands[i] = { static_cast<GLuint>(m_groups[i].vertexCount), 0, 0, 0, 0 };
+	}
+	glNamedBufferSubData(m_commandBuffer, 0, sizeof(commands), commands.data());
+	std::array<SplatDispatch, static_cast<int>(CullGroup::COUNT)> splatDispatches;
+	splatDispatches.fill({ 0, 1, 1, 0 });
+	glNamedBufferSubData(m_splatDispatchBuffer, 0, sizeof(splatDispatches), splatDispatches.data());
+
+	m_cullShader.use();
+	m_cullShader.updateUniform("rotationMatrix", m_rotationMatrix);
+	m_cullShader.updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_cullShader.updateUniform("clipPlanes", cullPlanes.data(), static_cast<int>(cullPlanes.size()));
+	m_cullShader.updateUniform("numClipPlanes", static_cast<int>(cullPlanes.size()));
+	m_cullShader.updateUniform("lodEnabled", m_lodSettings.enabled ? 1 : 0);
+	m_cullShader.updateUniform("lodEye", m_lodEye);
+	m_cullShader.updateUniform("lodPixelScale", m_lodPixelScale);
+	m_cullShader.updateUniform("lodTargetPixels", m_lodSettings.targetPixels);
+	m_cullShader.updateUniform("lodMinFraction", m_lodSettings.minFraction);
+	m_cullShader.updateUniform("lodTolerance", m_lodTolerance);
+	m_cullShader.updateUniform("splatEnabled", m_splatting ? 1 : 0);
+	m_cullShader.updateUniform("impostorPixels", m_lodSettings.impostors ? m_lodSettings.impostorPixels : 0.0f);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, m_splatDispatchBuffer);
+	if (m_selectionBuffer != 0)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 21, m_selectionBuffer);
+	}
+	for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		int numInstances = group.numFilaments * group.numElements;
+		if (!group.enabled || numInstances < 1)
+		{
+			continue;
+		}
+		//every tile of the group was rejected, the commands stay empty
+		if (numRanges[i] == 0)
+		{
+			continue;
+		}
+		if (numRanges[i] > 0)
+		{
+			numInstances = numTiledInstances[i];
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 31, m_tileRangeBuffer, rangeOffsets[i], numRanges[i] * sizeof(TileRange));
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 32, m_tiles->getOrderBuffer(LatticeTiles::getKind(group.filamentBinding)));
+		}
+		//the pass reads the same offset buffers as the vertex shaders, copy them to the culling bindings
+		GLint filamentBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+		if (group.elementBinding != 0 && group.elementBinding != 5)
+		{
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.elementBinding, &elementBuffer);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, elementBuffer ? elementBuffer : filamentBuffer);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 13, m_visibleBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+		if (group.perFilamentDraws)
+		{
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 23, m_drawBuffer, m_drawOffsets[i], group.numFilaments * sizeof(FilamentDraw));
+		}
+		if (m_splatting)
+		{
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 28, m_splatBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+		}
+
+		m_cullShader.updateUniform("numInstances", numInstances);
+		m_cullShader.updateUniform("numTileRanges", std::max(numRanges[i], 0));
+		m_cullShader.updateUniform("perFilamentDraws", group.perFilamentDraws ? 1 : 0);
+		m_cullShader.updateUniform("numElements", group.numElements);
+		m_cullShader.updateUniform("elementBinding", group.elementBinding);
+		m_cullShader.updateUniform("elementSpacing", group.elementSpacing);
+		m_cullShader.updateUniform("axisStart", group.axisStart);
+		m_cullShader.updateUniform("axisEnd", group.axisEnd);
+		m_cullShader.updateUniform("boundingRadius", group.boundingRadius);
+		m_cullShader.updateUniform("secondHalfStart", group.secondHalfStart);
+		m_cullShader.updateUniform("commandIndex", i);
+		m_cullShader.updateUniform("selectionOffset", m_selectionBuffer != 0 ? m_selectionOffsets[i] : -1);
+		m_cullShader.updateUniform("selectionSlots", m_selectionSlots[i]);
+		m_cullShader.updateUniform("lodPointSize", group.lodPointSize);
+		const ImpostorLayout& layout = m_impostorLayouts[group.filamentBinding == 2 ? 1 : 0];
+		m_cullShader.updateUniform("impostorRole", getImpostorRole(i));
+		m_cullShader.updateUniform("impostorSegments", std::max(layout.numSegments, 1));
+		m_cullShader.updateUniform("impostorStart", layout.start);
+		m_cullShader.updateUniform("impostorLength", layout.length);
+		m_cullShader.updateUniform("impostorAxis", layout.axis);
+		m_cullShader.updateUniform("impostorSize", layout.size);
+		dispatchInstances(numInstances);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+int InstanceCuller::getImpostorRole(int group)
+{
+	//the rods stay whole, every other group of a filament with impostors swaps its far segments
+	const CullGroupDescription& description = m_groups[group];
+	bool isImpostorGroup = group == static_cast<int>(CullGroup::ACTIN_IMPOSTORS) || group == static_cast<int>(CullGroup::MYOSIN_IMPOSTORS);
+	bool isRodGroup = group == static_cast<int>(CullGroup::ACTIN_RODS) || group == static_cast<int>(CullGroup::MYOSIN_RODS);
+	const ImpostorLayout& layout = m_impostorLayouts[description.filamentBinding == 2 ? 1 : 0];
+	bool hasImpostors = layout.numSegments > 0 && m_groups[description.filamentBinding == 2 ? static_cast<int>(CullGroup::MYOSIN_IMPOSTORS) : static_cast<int>(CullGroup::ACTIN_IMPOSTORS)].enabled;
+	return !hasImpostors || isRodGroup ? 0 : isImpostorGroup ? 2 : 1;
+}
+
+bool InstanceCuller::getTileRanges(int group, int impostorRole, const std::vector<glm::vec4>& cullPlanes, std::vector<TileRange>& ranges, int& numInstances)
+{
+	numInstances = 0;
+	const CullGroupDescription& description = m_groups[group];
+	if (!m_tiles || !m_tiles->isEnabled() || (description.filamentBinding != 2 && description.filamentBinding != 3))
+	{
+		return false;
+	}
+	//the rods cover both halves, the detail of the thin filaments only the first half
+	int kind = LatticeTiles::getKind(description.filamentBinding);
+	int numFilaments = m_tiles->getNumFilaments(kind);
+	int secondHalfStart = m_tiles->getSecondHalfStart(kind);
+	int numHalves = description.numFilaments == numFilaments ? 2 : description.numFilaments == secondHalfStart ? 1 : 0;
+	if (numHalves == 0 || (numHalves == 2 && secondHalfStart < numFilaments && description.secondHalfStart != secondHalfStart))
+	{
+		return false;
+	}
+	//a segment is far beyond this distance, a small margin keeps the tile and the instance tests from disagreeing
+	const ImpostorLayout& layout = m_impostorLayouts[kind];
+	float impostorPixels = m_lodSettings.impostors ? m_lodSettings.impostorPixels : 0.0f;
+	float farDistance = impostorPixels > 0.0f ? layout.size * m_lodPixelScale / impostorPixels : FLT_MAX;
+	for (const LatticeTile& tile : m_tiles->getTiles())
+	{
+		int count = tile.count[kind][0] + (numHalves == 2 ? tile.count[kind][1] : 0);
+		if (count == 0)
+		{
+			continue;
+		}
+		int side = m_tiles->classify(tile, kind, m_rotationMatrix, cullPlanes, description.boundingRadius);
+		if (side < 0)
+		{
+			continue;
+		}
+		//the centers of the segments lie in the tile, so a tile can be completely near or completely far
+		if (impostorRole != 0)
+		{
+			glm::vec2 distances = m_tiles->getDistanceRange(tile, kind, m_rotationMatrix, m_lodEye, 0.0f);
+			if ((impostorRole == 2 && distances.y < farDistance * 0.999f) || (impostorRole == 1 && distances.x > farDistance * 1.001f))
+			{
+				continue;
+			}
+		}
+		ranges.push_back({ tile.first[kind][0], count, numInstances, side > 0 ? 1 : 0 });
+		numInstances += count * description.numElements;
+	}
+	return true;
+}
+
+void InstanceCuller::sort()
+{
+	//the buckets span the depth of the bounding sphere, everything in front or behind it lands in the first or last one
+	GLuint zero = 0;
+	glClearNamedBufferData(m_bucketBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	float centerDepth = -(m_sortView * glm::vec4(m_sortCenter, 1.0f)).z;
+	m_sortShader.use();
+	m_sortShader.updateUniform("viewRotationMatrix", m_sortView * m_rotationMatrix);
+	m_sortShader.updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_sortShader.updateUniform("nearDepth", centerDepth - m_sortRadius);
+	m_sortShader.updateUniform("depthRange", std::max(2.0f * m_sortRadius, 0.0001f));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, m_bucketBuffer);
+	//count the instances per bucket, sum up the counts and scatter, each pass needs the buckets of the previous one
+	for (int sortPass = 0; sortPass < 3; sortPass++)
+	{
+		m_sortShader.updateUniform("sortPass", sortPass);
+		for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+		{
+			const CullGroupDescription& group = m_groups[i];
+			int numInstances = group.numFilaments * group.numElements;
+			if (!group.enabled || numInstances < 1)
+			{
+				continue;
+			}
+			GLint filamentBuffer = 0;
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 13, m_visibleBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 18, m_sortedBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+			//the children of a filament share its depth, so only the filament commands are sorted
+			if (group.perFilamentDraws)
+			{
+				GLsizeiptr drawSize = group.numFilaments * sizeof(FilamentDraw);
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 23, m_drawBuffer, m_drawOffsets[i], drawSize);
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 24, m_sortedDrawBuffer, m_drawOffsets[i], drawSize);
+			}
+
+			m_sortShader.updateUniform("sortDraws", group.perFilamentDraws ? 1 : 0);
+			m_sortShader.updateUniform("numFilaments", group.numFilaments);
+			m_sortShader.updateUniform("axisCenter", (group.axisStart + group.axisEnd) * 0.5f);
+			m_sortShader.updateUniform("numElements", group.numElements);
+			m_sortShader.updateUniform("secondHalfStart", group.secondHalfStart);
+			m_sortShader.updateUniform("commandIndex", i);
+			//the number of visible instances is only known on the gpu, every pass but the sum covers all instances
+			if (sortPass == 1)
+			{
+				glDispatchCompute(1, 1, 1);
+			}
+			else
+			{
+				dispatchInstances(group.perFilamentDraws ? group.numFilaments : numInstances);
+			}
+		}
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+	}
+}
+
+void InstanceCuller::dispatchInstances(int numInstances)
+{
+	int numGroups = (numInstances + 255) / 256;
+	int numGroupsX = std::min(numGroups, 65535);
+	int numGroupsY = (numGroups + numGroupsX - 1) / numGroupsX;
+	glDispatchCompute(numGroupsX, numGroupsY, 1);
+}
+
+void InstanceCuller::bindGroup(CullGroup group)
+{
+	int i = static_cast<int>(group);
+	const CullGroupDescription& description = m_groups[i];
+	if (description.perFilamentDraws)
+	{
+		//the children stay in place, the sort only reorders the filament commands
+		GLuint drawBuffer = m_frontToBack ? m_sortedDrawBuffer : m_drawBuffer;
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 13, m_visibleBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 23, drawBuffer, m_drawOffsets[i], std::max(description.numFilaments, 1) * sizeof(FilamentDraw));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer);
+		return;
+	}
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 13, m_frontToBack ? m_sortedBuffer : m_visibleBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+}
+
+void InstanceCuller::drawArrays(CullGroup group, GLenum mode)
+{
+	bindGroup(group);
+	const CullGroupDescription& description = m_groups[static_cast<int>(group)];
+	if (description.perFilamentDraws)
+	{
+		glMultiDrawArraysIndirect(mode, reinterpret_cast<const void*>(m_drawOffsets[static_cast<int>(group)]), description.numFilaments, sizeof(FilamentDraw));
+		return;
+	}
+	glDrawArraysIndirect(mode, reinterpret_cast<const void*>(getCommandOffset(group)));
+}
+
+void InstanceCuller::drawElements(CullGroup group, GLuint vao)
+{
+	int last_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
+	bindGroup(group);
+	glBindVertexArray(vao);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(getCommandOffset(group)));
+	glBindVertexArray(last_vao);
+}
+
+bool InstanceCuller::isSplatting()
+{
+	return m_splatting;
+}
+
+void InstanceCuller::dispatchSplats(CullGroup group)
+{
+	int i = static_cast<int>(group);
+	if (!m_splatting || !m_groups[i].enabled)
+	{
+		return;
+	}
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 28, m_splatBuffer, m_sectionOffsets[i], m_sectionSizes[i]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 29, m_splatDispatchBuffer);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_splatDispatchBuffer);
+	glDispatchComputeIndirect(static_cast<GLintptr>(i) * sizeof(SplatDispatch));
+}
+
+int InstanceCuller::getGeneration()
+{
+	return m_generation;
+}
+
+glm::vec3 InstanceCuller::getLevelOfDetailEye()
+{
+	return m_lodEye;
+}
+
+int InstanceCuller::getNumClipPlanes()
+{
+	return static_cast<int>(m_clipPlanes.size());
+}
+
+const std::vector<glm::vec4>& InstanceCuller::getClipPlanes()
+{
+	return m_clipPlanes;
+}
+
+GLintptr InstanceCuller::getCommandOffset(CullGroup group)
+{
+	return static_cast<GLintptr>(group) * sizeof(DrawCommand);
+}
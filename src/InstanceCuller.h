@@ -0,0 +1,295 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <climits>
+#include <vector>
+#include "LatticeTiles.h"
+#include "shaderProgram.h"
+
+//instanced structures that are drawn from a compacted list of visible instances
+enum class CullGroup
+{
+	ACTIN_RODS = 0,
+	MYOSIN_RODS = 1,
+	ACTIN_MONOMERS = 2,
+	TROPONIN = 3,
+	TROPOMYOSIN = 4,
+	LMM = 5,
+	HMM = 6,
+	MYOSIN_HEADS = 7,
+	//one quad per far segment of a filament, see FilamentImpostors
+	ACTIN_IMPOSTORS = 8,
+	MYOSIN_IMPOSTORS = 9,
+	COUNT = 10
+};
+
+// Describes how the culling pass reconstructs the bounds of one instance
+// instance = filament * numElements + element, which also indexes the selection mask and the mapped scalars
+// Every instance is bounded by a capsule from axisStart to axisEnd (before the filament and element offset
+// are added and the sarcomere rotation is applied) with boundingRadius.
+struct CullGroupDescription
+{
+	bool enabled = false;
+	// * int filamentBinding - ssbo binding of the filament offsets (2 = myosin rods, 3 = actin rods)
+	// * int elementBinding - ssbo binding of the element offsets, 0 = no element offset,
+	//   5 = tropomyosin strands or molecules, which are spaced by elementSpacing and mirrored for the second half
+	int filamentBinding = 3;
+	int elementBinding = 0;
+	int numFilaments = 0;
+	int numElements = 1;
+	float elementSpacing = 0.0f;
+	glm::vec3 axisStart = glm::vec3(0.0f);
+	glm::vec3 axisEnd = glm::vec3(0.0f);
+	float boundingRadius = 0.0f;
+	// filaments with an index >= secondHalfStart are additionally rotated by the second half rotation
+	int secondHalfStart = INT_MAX;
+	// vertex or index count written into the indirect draw command
+	int vertexCount = 0;
+	// draws every filament with its own indirect command, the vertex shaders read the filament record of
+	// gl_DrawIDARB and the element from the visible children at gl_BaseInstanceARB + gl_InstanceID
+	bool perFilamentDraws = false;
+	// world space point size of sprite instances, groups with a size are thinned out by the level of detail
+	float lodPointSize = 0.0f;
+
+	bool operator==(const CullGroupDescription& other) const;
+	bool operator!=(const CullGroupDescription& other) const;
+};
+
+// Segments of the impostors of one kind of filament in the local space of the filament, see FilamentImpostors
+struct ImpostorLayout
+{
+	int numSegments = 0;
+	// local y of the start of the first segment and the length of every segment
+	float start = 0.0f;
+	float length = 0.0f;
+	// local x and z of the filament axis
+	glm::vec2 axis = glm::vec2(0.0f);
+	// diameter of the bounding sphere of a segment, the side of its quad
+	float size = 0.0f;
+
+	bool operator==(const ImpostorLayout& other) const;
+	bool operator!=(const ImpostorLayout& other) const;
+};
+
+// Clipping planes and slabs used to cut into the lattice
+// Planes are stored as (normal, distance), a point p is kept if dot(normal, p) + distance >= 0.
+struct ClipSettings
+{
+	enum Mode
+	{
+		OFF = 0,
+		SLAB = 1,
+		PLANES = 2
+	};
+	int mode = OFF;
+	// slab around slabCenter (distance from the sarcomere mid point along slabNormal)
+	glm::vec3 slabNormal = glm::vec3(1.0f, 0.0f, 0.0f);
+	float slabCenter = 0.0f;
+	float slabThickness = 0.05f;
+	// free planes, the offset is measured from the sarcomere mid point as well
+	std::array<bool, 4> planeEnabled = { true, false, false, false };
+	std::array<glm::vec3, 4> planeNormals = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) };
+	std::array<float, 4> planeOffsets = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Returns the active planes in world space
+	// * glm::vec3 midPoint - world space sarcomere mid point
+	std::vector<glm::vec4> getPlanes(glm::vec3 midPoint) const;
+};
+
+// Stochastic level of detail of the sprite groups
+// Once the sprites of a group get smaller than targetPixels on screen, only a fraction of them is kept,
+// chosen by a hash of the instance, so the number of sprites per pixel stays constant. The kept sprites
+// grow by the inverse square root of the fraction to cover the same area.
+struct LevelOfDetailSettings
+{
+	bool enabled = false;
+	float targetPixels = 4.0f;
+	float minFraction = 0.05f;
+	// part of the kept fraction over which the sprites shrink to nothing before they are dropped
+	float fadeWidth = 0.25f;
+	// sprites that stay smaller than a pixel are splatted by a compute pass instead of drawn as points
+	bool splatSubPixel = false;
+	// filament segments whose quad covers fewer than impostorPixels pixels are drawn as impostors
+	bool impostors = false;
+	float impostorPixels = 32.0f;
+};
+
+// Returns the six normalized world space planes of a view frustum, inside is positive
+std::vector<glm::vec4> getFrustumPlanes(glm::mat4 viewProjection);
+
+// Builds compacted lists of the instances that are not completely outside of the clipping planes.
+// A compute pass writes the indices of the surviving instances per group into one ssbo together with
+// indirect draw commands, so a thin cross section of a large lattice only draws what it intersects.
+// The rods, one instance per filament, read their filament from visibleInstances[gl_InstanceID] (binding 13),
+// all other groups use per filament draws. The vertex shaders clip the straddling instances themselves. The pass only reruns after invalidate() or a change
+// of the planes or group descriptions, culling in world space keeps it independent of the camera.
+// Optionally a counting sort orders the visible instances front to back by the view depth of their
+// filament, so near filaments fill the depth buffer first and the ones behind fail the early depth test.
+// Groups with per filament draws are drawn with one multi draw indirect command per filament instead.
+// The visible children of a filament are compacted into its own range and the command carries the
+// filament record, so the shaders need no division and the filaments may have different child counts.
+// Filaments without visible children cost an empty command, sorting reorders the commands.
+// Sprite groups can be thinned out by a stochastic level of detail, which culls again once the eye moved.
+// With the same view the sprites below a pixel can be moved into separate splat lists (binding 28),
+// which are drawn by the SpriteSplatter with an indirect dispatch instead of the point pipeline.
+// Far segments of the filaments can swap their detail for impostors. The detail groups of a filament drop
+// their instances in the far segments and the impostor group keeps one instance for each of them, both
+// measure the distance to the center of the segment, so every segment is drawn exactly once.
+// With lattice tiles the planes, the frustum and the impostor distance are tested per tile on the cpu first.
+// Only the instances of the tiles that are not rejected are dispatched, in the filament order of the tiles
+// (binding 32) found through a list of tile ranges (binding 31), and tiles completely in front of all
+// planes skip the plane tests of their instances.
+class InstanceCuller
+{
+public:
+	static constexpr int MAX_CLIP_PLANES = 4;
+	//clipping planes plus the six planes of an optional culling frustum
+	static constexpr int MAX_CULL_PLANES = MAX_CLIP_PLANES + 6;
+	InstanceCuller();
+	~InstanceCuller();
+	// * std::vector<glm::vec4> planes - world space planes, at most MAX_CLIP_PLANES are used
+	void setClipPlanes(const std::vector<glm::vec4>& planes);
+	// Additionally rejects instances outside of a frustum, used to draw only what a poster tile sees.
+	// These planes only cull, the shaders do not clip against them. Pass an empty vector to reset.
+	void setCullFrustum(const std::vector<glm::vec4>& planes);
+	void setGroup(CullGroup group, const CullGroupDescription& description);
+	// Sets the number of drawn children of every filament of a group with per filament draws,
+	// at most numElements each. An empty vector draws numElements children per filament.
+	void setChildCounts(CullGroup group, const std::vector<int>& childCounts);
+	void setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix);
+	// Draws the instances of every group front to back as seen from view, sorted into coarse depth buckets.
+	// The sort reruns after a culling pass or a change of the view.
+	// * glm::vec3 center, float radius - world space bounding sphere of the lattice, the buckets span its depth
+	void setSortView(bool frontToBack, glm::mat4 view, glm::vec3 center, float radius);
+	// Additionally rejects the instances whose bit is cleared in a selection mask (binding 21)
+	// * std::array<int, COUNT> bitOffsets - first bit of every group, -1 if the group is not masked
+	// * std::array<int, COUNT> bitsPerInstance - slots of every group, an instance is kept while any of its bits is set
+	void setSelection(GLuint maskBuffer, const std::array<int, static_cast<int>(CullGroup::COUNT)>& bitOffsets, const std::array<int, static_cast<int>(CullGroup::COUNT)>& bitsPerInstance);
+	// Drops sprites by the level of detail as seen from eye. The pass keeps every sprite the shaders may show
+	// while the eye stays within tolerance of the eye of the last pass, and reruns once it moved further.
+	// Splatted sprites stay below a pixel for every eye within tolerance.
+	// * float pixelScale - point size in pixels of a sprite with a world space size of one at a distance of one
+	void setLevelOfDetail(const LevelOfDetailSettings& settings, glm::vec3 eye, float pixelScale, float tolerance);
+	// Sets the segments of the impostors of a filament, the detail groups with the same filament binding
+	// are dropped in the segments drawn as impostors. An empty layout keeps the detail everywhere.
+	// * CullGroup group - ACTIN_IMPOSTORS or MYOSIN_IMPOSTORS
+	void setImpostors(CullGroup group, const ImpostorLayout& layout);
+	// Tests the lattice tiles before the instances, nullptr or disabled tiles test every instance.
+	// The culler has to be invalidated when the tiles were built again.
+	void setTiles(const LatticeTiles* tiles);
+	// Forces a new culling pass, used when the offset buffers changed
+	void invalidate();
+	// Runs the culling and the sorting pass if needed, expects the sarcomere ssbos to be bound
+	void update();
+	// Binds the visible instances of a group to binding 13 and the indirect command buffer,
+	// groups with per filament draws also bind their filament records to binding 23
+	void bindGroup(CullGroup group);
+	// Draws a group with the indirect command written by the culling pass
+	void drawArrays(CullGroup group, GLenum mode);
+	void drawElements(CullGroup group, GLuint vao);
+	// Returns true if the last culling pass moved the sub-pixel sprites into the splat lists
+	bool isSplatting();
+	// Binds the splat list of a group to binding 28 and its dispatch record to binding 29 and dispatches
+	// the bound compute shader with one thread per splat, at most 65535 work groups of 256 threads
+	void dispatchSplats(CullGroup group);
+	// Returns the number of culling passes so far, the visible instances only change with it
+	int getGeneration();
+	int getNumClipPlanes();
+	const std::vector<glm::vec4>& getClipPlanes();
+	// Returns the eye of the last culling pass, shaders that drop detail for the impostors measure from it
+	glm::vec3 getLevelOfDetailEye();
+private:
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseVertex;
+		GLuint baseInstance;
+	};
+	//indirect command of one filament followed by its record, matches FilamentDraw of the shaders
+	struct FilamentDraw
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+		GLint filament;
+		GLint firstInstance;
+		GLint numChildren;
+		GLint padding;
+	};
+	//indirect dispatch of the splats of one group followed by their count, matches SplatDispatch of the shaders
+	struct SplatDispatch
+	{
+		GLuint numGroupsX;
+		GLuint numGroupsY;
+		GLuint numGroupsZ;
+		GLuint count;
+	};
+	//filaments of one tile and half that survived the tile tests, matches TileRange of the culling shader
+	struct TileRange
+	{
+		GLint first;
+		GLint count;
+		GLint instanceBase;
+		GLint inside;
+	};
+	static constexpr int NUM_SORT_BUCKETS = 64;
+	// Collects the ranges of the tiles of a group that are not rejected, returns false if the group is not tiled
+	// * int impostorRole - 0 = no impostors, 1 = detail dropped in the far segments, 2 = impostors of the far segments
+	bool getTileRanges(int group, int impostorRole, const std::vector<glm::vec4>& cullPlanes, std::vector<TileRange>& ranges, int& numInstances);
+	int getImpostorRole(int group);
+	void cull();
+	void sort();
+	//spreads large groups over a second dimension to stay below the work group count limit
+	void dispatchInstances(int numInstances);
+	GLintptr getCommandOffset(CullGroup group);
+	ShaderProgram m_cullShader;
+	ShaderProgram m_sortShader;
+	std::array<CullGroupDescription, static_cast<int>(CullGroup::COUNT)> m_groups;
+	std::array<GLintptr, static_cast<int>(CullGroup::COUNT)> m_sectionOffsets;
+	std::array<GLsizeiptr, static_cast<int>(CullGroup::COUNT)> m_sectionSizes;
+	std::array<GLintptr, static_cast<int>(CullGroup::COUNT)> m_drawOffsets;
+	std::array<std::vector<int>, static_cast<int>(CullGroup::COUNT)> m_childCounts;
+	std::vector<glm::vec4> m_clipPlanes;
+	std::vector<glm::vec4> m_frustumPlanes;
+	GLuint m_selectionBuffer = 0;
+	std::array<int, static_cast<int>(CullGroup::COUNT)> m_selectionOffsets;
+	std::array<int, static_cast<int>(CullGroup::COUNT)> m_selectionSlots;
+	LevelOfDetailSettings m_lodSettings;
+	glm::vec3 m_lodEye = glm::vec3(0.0f);
+	float m_lodPixelScale = 0.0f;
+	float m_lodTolerance = 0.0f;
+	std::array<ImpostorLayout, 2> m_impostorLayouts;
+	const LatticeTiles* m_tiles = nullptr;
+	GLuint m_tileRangeBuffer = 0;
+	GLsizeiptr m_tileRangeBufferSize = 0;
+	glm::mat4 m_rotationMatrix = glm::mat4(1.0f);
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	GLuint m_visibleBuffer = 0;
+	GLsizeiptr m_visibleBufferSize = 0;
+	GLuint m_commandBuffer = 0;
+	//sorted copy of the visible instances with the same sections and the counters of the depth buckets
+	GLuint m_sortedBuffer = 0;
+	GLuint m_bucketBuffer = 0;
+	//filament commands of the groups with per filament draws and their sorted copy
+	GLuint m_drawBuffer = 0;
+	GLuint m_sortedDrawBuffer = 0;
+	GLsizeiptr m_drawBufferSize = 0;
+	//sub-pixel sprites with the same sections as the visible instances and the dispatch of every group
+	GLuint m_splatBuffer = 0;
+	GLsizeiptr m_splatBufferSize = 0;
+	GLuint m_splatDispatchBuffer = 0;
+	bool m_splatting = false;
+	GLint m_offsetAlignment = 256;
+	bool m_dirty = true;
+	int m_generation = 0;
+	bool m_frontToBack = false;
+	glm::mat4 m_sortView = glm::mat4(1.0f);
+	glm::vec3 m_sortCenter = glm::vec3(0.0f);
+	float m_sortRadius = 0.0f;
+	bool m_sortDirty = true;
+};
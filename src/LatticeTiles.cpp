@@ -0,0 +1,291 @@
+#include "LatticeTiles.h"
+#include "Sarcomere.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+bool LatticeTiles::Extent::operator!=(const Extent& other) const
+{
+	return minY != other.minY || maxY != other.maxY || radius != other.radius;
+}
+
+LatticeTiles::LatticeTiles()
+{
+}
+
+LatticeTiles::~LatticeTiles()
+{
+	glDeleteBuffers(NUM_KINDS, m_orderBuffers.data());
+}
+
+bool LatticeTiles::update(Sarcomere& sarcomere, const LatticeTileSettings& settings, glm::mat4 secondHalfRotationMatrix)
+{
+	//everything the tiles depend on is compared, the filaments only move when the lattice is edited
+	std::array<std::vector<glm::vec4>, NUM_KINDS> filaments = { sarcomere.getActinRods(), sarcomere.getMyosinRods() };
+	std::array<Extent, NUM_KINDS> extents = { getActinExtent(sarcomere), getMyosinExtent(sarcomere) };
+	glm::vec4 midPoint = sarcomere.getMidPoint();
+	glm::vec2 center = glm::vec2(midPoint.x, midPoint.z);
+	//the myosin filaments are two d11 apart
+	float tileSize = std::max(settings.cellsPerTile, 1) * 2.0f * sarcomere.d10 / std::sqrt(3.0f);
+	bool changed = !m_built || settings.enabled != m_settings.enabled || settings.cellsPerTile != m_settings.cellsPerTile ||
+		secondHalfRotationMatrix != m_secondHalfRotationMatrix || center != m_center || tileSize != m_tileSize;
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		changed = changed || filaments[kind] != m_filaments[kind] || extents[kind] != m_extents[kind];
+	}
+	if (!changed)
+	{
+		return false;
+	}
+	m_settings = settings;
+	m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+	m_center = center;
+	m_tileSize = tileSize;
+	m_filaments = filaments;
+	m_extents = extents;
+	//the myosin filaments span both halves, the actin filaments of the second half follow the first half
+	m_secondHalfStart = { static_cast<int>(filaments[0].size()) / 2, static_cast<int>(filaments[1].size()) };
+	build();
+	m_built = true;
+	return true;
+}
+
+bool LatticeTiles::isEnabled() const
+{
+	return m_settings.enabled && !m_tiles.empty();
+}
+
+const std::vector<LatticeTile>& LatticeTiles::getTiles() const
+{
+	return m_tiles;
+}
+
+int LatticeTiles::getTile(int kind, int filament) const
+{
+	if (!isEnabled() || filament < 0 || filament >= static_cast<int>(m_filamentTiles[kind].size()))
+	{
+		return -1;
+	}
+	return m_filamentTiles[kind][filament];
+}
+
+int LatticeTiles::getNumFilaments(int kind) const
+{
+	return static_cast<int>(m_filaments[kind].size());
+}
+
+int LatticeTiles::getSecondHalfStart(int kind) const
+{
+	return m_secondHalfStart[kind];
+}
+
+GLuint LatticeTiles::getOrderBuffer(int kind) const
+{
+	return m_orderBuffers[kind];
+}
+
+int LatticeTiles::getKind(int filamentBinding)
+{
+	return filamentBinding == 2 ? 1 : 0;
+}
+
+int LatticeTiles::classify(const LatticeTile& tile, int kind, glm::mat4 rotationMatrix, const std::vector<glm::vec4>& planes, float extraRadius) const
+{
+	glm::vec3 a = glm::vec3(rotationMatrix * glm::vec4(tile.axisStart[kind], 1.0f));
+	glm::vec3 b = glm::vec3(rotationMatrix * glm::vec4(tile.axisEnd[kind], 1.0f));
+	float radius = tile.radius[kind] + extraRadius;
+	bool inside = true;
+	for (const glm::vec4& plane : planes)
+	{
+		float distanceA = glm::dot(glm::vec3(plane), a) + plane.w;
+		float distanceB = glm::dot(glm::vec3(plane), b) + plane.w;
+		if (std::max(distanceA, distanceB) < -radius)
+		{
+			return -1;
+		}
+		inside = inside && std::min(distanceA, distanceB) > radius;
+	}
+	return inside ? 1 : 0;
+}
+
+glm::vec2 LatticeTiles::getDistanceRange(const LatticeTile& tile, int kind, glm::mat4 rotationMatrix, glm::vec3 point, float extraRadius) const
+{
+	glm::vec3 a = glm::vec3(rotationMatrix * glm::vec4(tile.axisStart[kind], 1.0f));
+	glm::vec3 b = glm::vec3(rotationMatrix * glm::vec4(tile.axisEnd[kind], 1.0f));
+	float radius = tile.radius[kind] + extraRadius;
+	glm::vec3 axis = b - a;
+	float t = glm::dot(axis, axis) > 0.0f ? glm::clamp(glm::dot(point - a, axis) / glm::dot(axis, axis), 0.0f, 1.0f) : 0.0f;
+	float closest = std::max(glm::length(point - (a + t * axis)) - radius, 0.0f);
+	float farthest = std::max(glm::length(point - a), glm::length(point - b)) + radius;
+	return glm::vec2(closest, farthest);
+}
+
+LatticeTiles::Extent LatticeTiles::getActinExtent(Sarcomere& sarcomere)
+{
+	Extent extent;
+	bool empty = true;
+	auto include = [&](glm::vec3 position, float radius)
+	{
+		float radial = glm::length(glm::vec2(position.x, position.z)) + radius;
+		extent.minY = empty ? position.y - radius : std::min(extent.minY, position.y - radius);
+		extent.maxY = empty ? position.y + radius : std::max(extent.maxY, position.y + radius);
+		extent.radius = empty ? radial : std::max(extent.radius, radial);
+		empty = false;
+	};
+	float actinRadius = sarcomere.actinRadius;
+	//the rods are scaled and moved like the culler places them
+	glm::vec3 rodStart = glm::vec3(sarcomere.getMidPoint()) * glm::vec3(actinRadius, sarcomere.actinLength, actinRadius) + glm::vec3(0.0f, -sarcomere.sarcomereLength / 2.0f, 0.0f);
+	include(rodStart, actinRadius);
+	include(rodStart + glm::vec3(0.0f, sarcomere.actinLength, 0.0f), actinRadius);
+	for (const glm::vec4& position : sarcomere.getActinParticles())
+	{
+		include(glm::vec3(position), actinRadius / 2.0f);
+	}
+	for (const glm::vec4& position : sarcomere.getTroponinPositions())
+	{
+		include(glm::vec3(position), actinRadius / 4.0f);
+	}
+	//the strand of the second half is mirrored and runs the other way
+	for (const glm::vec4& position : sarcomere.getTropomyosinPositions())
+	{
+		float radial = glm::length(glm::vec2(position.x, position.z));
+		for (float y : { position.y, -position.y })
+		{
+			include(glm::vec3(radial, y, 0.0f), actinRadius / 8.0f);
+		}
+	}
+	return extent;
+}
+
+LatticeTiles::Extent LatticeTiles::getMyosinExtent(Sarcomere& sarcomere)
+{
+	Extent extent;
+	bool empty = true;
+	auto include = [&](glm::vec3 position, float radius)
+	{
+		float radial = glm::length(glm::vec2(position.x, position.z)) + radius;
+		extent.minY = empty ? position.y - radius : std::min(extent.minY, position.y - radius);
+		extent.maxY = empty ? position.y + radius : std::max(extent.maxY, position.y + radius);
+		extent.radius = empty ? radial : std::max(extent.radius, radial);
+		empty = false;
+	};
+	//the rods are as wide as the trunk or the whole filament, depending on the detail
+	float width = std::max(sarcomere.myosinRadius, sarcomere.myosinTrunkRadius);
+	glm::vec3 rodStart = glm::vec3(sarcomere.getMidPoint()) * glm::vec3(width, sarcomere.myosinLength, width) + glm::vec3(0.0f, -sarcomere.myosinLength / 2.0f, 0.0f);
+	include(rodStart, width);
+	include(rodStart + glm::vec3(0.0f, sarcomere.myosinLength, 0.0f), width);
+	for (const glm::vec4& position : sarcomere.getLMMOffsetPositions())
+	{
+		include(glm::vec3(position), sarcomere.getLMMBoundingRadius() + sarcomere.myosinTrunkRadius / 20.0f);
+	}
+	for (const glm::vec4& position : sarcomere.getHMMOffsetPositions())
+	{
+		include(glm::vec3(position), sarcomere.getHMMBoundingRadius() + sarcomere.myosinTrunkRadius / 20.0f);
+	}
+	//the head sprites are ten times their base size
+	for (const glm::vec4& position : sarcomere.getMyosinHeadOffsetPositions())
+	{
+		include(glm::vec3(position), sarcomere.myosinHeadRadius * 10.0f);
+	}
+	return extent;
+}
+
+glm::ivec2 LatticeTiles::getHex(glm::vec2 position, float size)
+{
+	//axial coordinates of pointy top hexagons, rounded in cube coordinates
+	float q = (std::sqrt(3.0f) / 3.0f * position.x - position.y / 3.0f) / size;
+	float r = (2.0f / 3.0f * position.y) / size;
+	float s = -q - r;
+	float roundedQ = std::round(q);
+	float roundedR = std::round(r);
+	float roundedS = std::round(s);
+	float errorQ = std::abs(roundedQ - q);
+	float errorR = std::abs(roundedR - r);
+	float errorS = std::abs(roundedS - s);
+	if (errorQ > errorR && errorQ > errorS)
+	{
+		roundedQ = -roundedR - roundedS;
+	}
+	else if (errorR > errorS)
+	{
+		roundedR = -roundedQ - roundedS;
+	}
+	return glm::ivec2(static_cast<int>(roundedQ), static_cast<int>(roundedR));
+}
+
+void LatticeTiles::build()
+{
+	m_tiles.clear();
+	glDeleteBuffers(NUM_KINDS, m_orderBuffers.data());
+	m_orderBuffers = { 0, 0 };
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		m_filamentTiles[kind].assign(m_filaments[kind].size(), -1);
+	}
+	if (!m_settings.enabled)
+	{
+		return;
+	}
+
+	//the members of every tile per kind and half, ordered row by row
+	std::map<std::pair<int, int>, std::array<std::array<std::vector<int>, 2>, NUM_KINDS>> members;
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		for (int filament = 0; filament < static_cast<int>(m_filaments[kind].size()); filament++)
+		{
+			int half = filament >= m_secondHalfStart[kind] ? 1 : 0;
+			glm::mat4 rotation = half == 1 ? m_secondHalfRotationMatrix : glm::mat4(1.0f);
+			glm::vec3 position = glm::vec3(rotation * glm::vec4(glm::vec3(m_filaments[kind][filament]), 1.0f));
+			glm::ivec2 hex = getHex(glm::vec2(position.x, position.z) - m_center, m_tileSize);
+			members[{ hex.y, hex.x }][kind][half].push_back(filament);
+		}
+	}
+
+	std::array<std::vector<GLint>, NUM_KINDS> orders;
+	for (const auto& entry : members)
+	{
+		LatticeTile tile;
+		tile.hex = glm::ivec2(entry.first.second, entry.first.first);
+		glm::vec2 center = m_center + m_tileSize * glm::vec2(std::sqrt(3.0f) * tile.hex.x + std::sqrt(3.0f) / 2.0f * tile.hex.y, 1.5f * tile.hex.y);
+		for (int kind = 0; kind < NUM_KINDS; kind++)
+		{
+			float minY = 0.0f;
+			float maxY = 0.0f;
+			float radius = 0.0f;
+			bool empty = true;
+			for (int half = 0; half < 2; half++)
+			{
+				const std::vector<int>& filaments = entry.second[kind][half];
+				tile.first[kind][half] = static_cast<int>(orders[kind].size());
+				tile.count[kind][half] = static_cast<int>(filaments.size());
+				glm::mat4 rotation = half == 1 ? m_secondHalfRotationMatrix : glm::mat4(1.0f);
+				for (int filament : filaments)
+				{
+					m_filamentTiles[kind][filament] = static_cast<int>(m_tiles.size());
+					orders[kind].push_back(filament);
+					//both ends of the extent of the filament, the radius grows by the distance of the ends to the tile axis
+					glm::vec3 offset = glm::vec3(m_filaments[kind][filament]);
+					for (float y : { m_extents[kind].minY, m_extents[kind].maxY })
+					{
+						glm::vec3 end = glm::vec3(rotation * glm::vec4(offset + glm::vec3(0.0f, y, 0.0f), 1.0f));
+						float radial = glm::length(glm::vec2(end.x, end.z) - center) + m_extents[kind].radius;
+						minY = empty ? end.y : std::min(minY, end.y);
+						maxY = empty ? end.y : std::max(maxY, end.y);
+						radius = std::max(radius, radial);
+						empty = false;
+					}
+				}
+			}
+			tile.axisStart[kind] = glm::vec3(center.x, minY, center.y);
+			tile.axisEnd[kind] = glm::vec3(center.x, maxY, center.y);
+			tile.radius[kind] = radius;
+		}
+		m_tiles.push_back(tile);
+	}
+
+	for (int kind = 0; kind < NUM_KINDS; kind++)
+	{
+		glCreateBuffers(1, &m_orderBuffers[kind]);
+		glNamedBufferStorage(m_orderBuffers[kind], std::max<size_t>(orders[kind].size(), 1) * sizeof(GLint), orders[kind].empty() ? nullptr : orders[kind].data(), 0);
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+class Sarcomere;
+
+//parameters of the lattice tiles in the clipping window
+struct LatticeTileSettings
+{
+	bool enabled = true;
+	//side of a hexagonal tile in unit cells (myosin spacings)
+	int cellsPerTile = 4;
+};
+
+//one hexagonal column of the lattice, kind 0 = thin filaments (binding 3), 1 = thick filaments (binding 2)
+struct LatticeTile
+{
+	//axial coordinates of the hexagon around the lattice center
+	glm::ivec2 hex = glm::ivec2(0);
+	//capsule around every structure of the filaments of a kind, in the space of the first half before
+	//the sarcomere rotation, so only the rotation matrix has to be applied to get the world space bounds
+	std::array<glm::vec3, 2> axisStart;
+	std::array<glm::vec3, 2> axisEnd;
+	std::array<float, 2> radius = { 0.0f, 0.0f };
+	//range of the filaments of a kind and half in the tile order of the kind, the first half comes first
+	std::array<std::array<int, 2>, 2> first = { { { 0, 0 }, { 0, 0 } } };
+	std::array<std::array<int, 2>, 2> count = { { { 0, 0 }, { 0, 0 } } };
+};
+
+// Partitions the lattice into hexagonal tiles of cellsPerTile x cellsPerTile unit cells.
+// The filaments are stored in generation order (the actin rods row by row, four mirrored points at a time),
+// so neighbouring indices are spread over the whole cross section. The tiles group the filaments by their
+// position in the lattice plane, the second half is placed by the second half rotation, so a tile is one
+// column through the whole sarcomere. Every tile has a bounding capsule per kind of filament, which covers
+// the rods and every detail structure, and a contiguous range per kind and half in the tile order, which is
+// uploaded to an ssbo per kind. The culler tests the tiles instead of the filaments and only dispatches the
+// instances of the ranges that survive, the ray tracer leaves out the clipped tiles and the inspector shows
+// the tile of the picked filament. The filament indices themselves stay in generation order.
+// The tiles are built again whenever the filament offsets, the extents of their structures or the settings change.
+class LatticeTiles
+{
+public:
+	static constexpr int NUM_KINDS = 2;
+	LatticeTiles();
+	~LatticeTiles();
+	// Builds the tiles again if anything they depend on changed, returns true if they were built
+	bool update(Sarcomere& sarcomere, const LatticeTileSettings& settings, glm::mat4 secondHalfRotationMatrix);
+	bool isEnabled() const;
+	const std::vector<LatticeTile>& getTiles() const;
+	// Returns the index of the tile of a filament, -1 if there are no tiles
+	int getTile(int kind, int filament) const;
+	int getNumFilaments(int kind) const;
+	// Filaments at or above it belong to the second half and are rotated by the second half rotation
+	int getSecondHalfStart(int kind) const;
+	// Returns the ssbo with the filament indices of a kind tile by tile
+	GLuint getOrderBuffer(int kind) const;
+	// * int filamentBinding - 2 = thick filaments, 3 = thin filaments
+	static int getKind(int filamentBinding);
+	// Classifies the world space bounds of a tile grown by extraRadius against planes,
+	// returns -1 if it is behind any plane, 1 if it is in front of all planes and 0 otherwise
+	int classify(const LatticeTile& tile, int kind, glm::mat4 rotationMatrix, const std::vector<glm::vec4>& planes, float extraRadius) const;
+	// Returns the closest and the farthest distance of a point to the world space bounds of a tile
+	glm::vec2 getDistanceRange(const LatticeTile& tile, int kind, glm::mat4 rotationMatrix, glm::vec3 point, float extraRadius) const;
+private:
+	//capsule of every structure of a filament around its offset, in the space of the filament
+	struct Extent
+	{
+		float minY = 0.0f;
+		float maxY = 0.0f;
+		float radius = 0.0f;
+
+		bool operator!=(const Extent& other) const;
+	};
+	static Extent getActinExtent(Sarcomere& sarcomere);
+	static Extent getMyosinExtent(Sarcomere& sarcomere);
+	static glm::ivec2 getHex(glm::vec2 position, float size);
+	void build();
+	LatticeTileSettings m_settings;
+	bool m_built = false;
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	glm::vec2 m_center = glm::vec2(0.0f);
+	float m_tileSize = 1.0f;
+	std::array<std::vector<glm::vec4>, NUM_KINDS> m_filaments;
+	std::array<int, NUM_KINDS> m_secondHalfStart = { 0, 0 };
+	std::array<Extent, NUM_KINDS> m_extents;
+	std::vector<LatticeTile> m_tiles;
+	std::array<std::vector<int>, NUM_KINDS> m_filamentTiles;
+	std::array<GLuint, NUM_KINDS> m_orderBuffers = { 0, 0 };
+};
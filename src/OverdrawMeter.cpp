@@ -0,0 +1,103 @@
+#include "OverdrawMeter.h"
+
+OverdrawMeter::OverdrawMeter() : m_heatmapShader(SHADERS_PATH "/overdrawHeatmap.vert", SHADERS_PATH "/overdrawHeatmap.frag")
+{
+	glCreateVertexArrays(1, &m_vao);
+	m_queries.fill(0);
+	m_pending.fill(false);
+	m_numPixels.fill(0);
+	m_querySupported = GLEW_ARB_pipeline_statistics_query;
+	if (m_querySupported)
+	{
+		glCreateQueries(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, NUM_QUERIES, m_queries.data());
+	}
+}
+
+OverdrawMeter::~OverdrawMeter()
+{
+	if (m_querySupported)
+	{
+		glDeleteQueries(NUM_QUERIES, m_queries.data());
+	}
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void OverdrawMeter::begin(const OverdrawSettings& settings)
+{
+	//all queries are in flight, skip the measurement of this frame
+	if (m_querySupported && !m_pending[m_writeIndex])
+	{
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, m_queries[m_writeIndex]);
+		m_active = true;
+	}
+	if (settings.showHeatmap)
+	{
+		//the stencil buffer is cleared with the scene, every fragment passing the depth test adds one
+		glEnable(GL_STENCIL_TEST);
+		glStencilMask(0xFF);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	}
+}
+
+void OverdrawMeter::end(const OverdrawSettings& settings, int width, int height)
+{
+	if (m_active)
+	{
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+		m_numPixels[m_writeIndex] = width * height;
+		m_pending[m_writeIndex] = true;
+		m_writeIndex = (m_writeIndex + 1) % NUM_QUERIES;
+		m_active = false;
+	}
+	if (settings.showHeatmap)
+	{
+		drawHeatmap();
+		glDisable(GL_STENCIL_TEST);
+	}
+	//consume every finished measurement
+	while (m_pending[m_readIndex])
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[m_readIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+		GLuint64 invocations = 0;
+		glGetQueryObjectui64v(m_queries[m_readIndex], GL_QUERY_RESULT, &invocations);
+		m_shadedFragmentsPerPixel = static_cast<float>(invocations) / glm::max(m_numPixels[m_readIndex], 1);
+		m_pending[m_readIndex] = false;
+		m_readIndex = (m_readIndex + 1) % NUM_QUERIES;
+	}
+}
+
+float OverdrawMeter::getShadedFragmentsPerPixel()
+{
+	return m_shadedFragmentsPerPixel;
+}
+
+void OverdrawMeter::drawHeatmap()
+{
+	int last_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
+	//the IDs stay untouched, so picking still works on the heatmap
+	glDisable(GL_DEPTH_TEST);
+	glColorMaski(1, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	m_heatmapShader.use();
+	glBindVertexArray(m_vao);
+	//one full screen triangle per level, the stencil test keeps the pixels with that count
+	for (int level = 0; level <= MAX_LEVEL; level++)
+	{
+		//jet color ramp from dark blue over green to dark red, black for pixels without fragments
+		float t = (level - 1) / static_cast<float>(MAX_LEVEL - 1);
+		glm::vec3 color = glm::clamp(glm::vec3(1.5f) - glm::abs(glm::vec3(4.0f * t - 3.0f, 4.0f * t - 2.0f, 4.0f * t - 1.0f)), 0.0f, 1.0f);
+		m_heatmapShader.updateUniform("levelColor", level == 0 ? glm::vec3(0.0f) : color);
+		glStencilFunc(level == MAX_LEVEL ? GL_LEQUAL : GL_EQUAL, level, 0xFF);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	glColorMaski(1, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glBindVertexArray(last_vao);
+}
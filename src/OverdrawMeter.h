@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include "shaderProgram.h"
+
+//parameters of the overdraw window
+struct OverdrawSettings
+{
+	//depth only pass of the sprites before the color pass, which then only shades the front most sprite fragment
+	bool depthPrePass = true;
+	//draw the instances of every group front to back
+	bool frontToBack = true;
+	//replace the scene by the number of fragments written per pixel
+	bool showHeatmap = false;
+};
+
+// Measures the overdraw of the scene.
+// The heatmap counts the fragments of every pixel which pass the depth test in the stencil buffer of the
+// scene framebuffer and afterwards colors each pixel by its count, from blue for one fragment to red for
+// MAX_LEVEL and more. Stencil operations keep the early depth test intact, so the map shows the shading
+// the ordering and the depth pre-pass saved. Where supported, a pipeline statistics query additionally
+// counts all fragment shader invocations, it is read a few frames later like the timer queries.
+class OverdrawMeter
+{
+public:
+	OverdrawMeter();
+	~OverdrawMeter();
+	// Starts counting, expects the scene framebuffer to be bound and cleared
+	void begin(const OverdrawSettings& settings);
+	// Stops counting and draws the heatmap over the scene if it is enabled
+	void end(const OverdrawSettings& settings, int width, int height);
+	// Returns the average fragment shader invocations per pixel of the last finished query, -1 if unsupported
+	float getShadedFragmentsPerPixel();
+private:
+	static constexpr int MAX_LEVEL = 12;
+	static constexpr int NUM_QUERIES = 4;
+	void drawHeatmap();
+	ShaderProgram m_heatmapShader;
+	GLuint m_vao = 0;
+	bool m_querySupported = false;
+	std::array<GLuint, NUM_QUERIES> m_queries;
+	std::array<bool, NUM_QUERIES> m_pending;
+	std::array<int, NUM_QUERIES> m_numPixels;
+	int m_writeIndex = 0;
+	int m_readIndex = 0;
+	bool m_active = false;
+	float m_shadedFragmentsPerPixel = -1.0f;
+};
@@ -0,0 +1,115 @@
+#include "Picker.h"
+#include <cstring>
+
+const char* getStructureName(StructureType type)
+{
+	switch (type)
+	{
+	case StructureType::Z_DISC:
+		return "Z-Disc";
+	case StructureType::MYOSIN_ROD:
+		return "Myosin Filament";
+	case StructureType::ACTIN_ROD:
+		return "Actin Filament";
+	case StructureType::ACTIN_MONOMER:
+		return "Actin Monomer";
+	case StructureType::TROPOMYOSIN:
+		return "Tropomyosin Segment";
+	case StructureType::TROPONIN:
+		return "Troponin";
+	case StructureType::LMM:
+		return "LMM Segment";
+	case StructureType::HMM:
+		return "HMM Segment";
+	case StructureType::MYOSIN_HEAD:
+		return "Myosin Head";
+	case StructureType::MESH:
+		return "Mesh";
+	default:
+		return "None";
+	}
+}
+
+Picker::Picker()
+{
+	//one texel of RG32UI IDs followed by one float depth value
+	glCreateBuffers(RING_SIZE, m_pbos.data());
+	for (int i = 0; i < RING_SIZE; i++)
+	{
+		glNamedBufferStorage(m_pbos[i], 4 * sizeof(GLuint), nullptr, GL_CLIENT_STORAGE_BIT);
+	}
+}
+
+Picker::~Picker()
+{
+	for (PendingPick& pending : m_pending)
+	{
+		if (pending.fence)
+		{
+			glDeleteSync(pending.fence);
+		}
+	}
+	glDeleteBuffers(RING_SIZE, m_pbos.data());
+}
+
+void Picker::requestPick(GLuint fbo, int x, int y, int width, int height, glm::mat4 viewProjection)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+	{
+		return;
+	}
+	PendingPick& pending = m_pending[m_writeIndex];
+	//ring is full, drop the request instead of waiting for the gpu
+	if (pending.fence)
+	{
+		return;
+	}
+	GLint lastReadFBO;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastReadFBO);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[m_writeIndex]);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(x, y, 1, 1, GL_RG_INTEGER, GL_UNSIGNED_INT, reinterpret_cast<void*>(0));
+	glReadPixels(x, y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, reinterpret_cast<void*>(2 * sizeof(GLuint)));
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, lastReadFBO);
+
+	pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pending.inverseViewProjection = glm::inverse(viewProjection);
+	pending.ndc = glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) * 2.0f - 1.0f;
+	m_writeIndex = (m_writeIndex + 1) % RING_SIZE;
+}
+
+bool Picker::poll(PickResult& result)
+{
+	bool found = false;
+	//consume every finished readback, the newest one wins
+	while (m_pending[m_readIndex].fence)
+	{
+		PendingPick& pending = m_pending[m_readIndex];
+		GLenum status = glClientWaitSync(pending.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		glDeleteSync(pending.fence);
+		pending.fence = nullptr;
+
+		GLuint data[4];
+		glGetNamedBufferSubData(m_pbos[m_readIndex], 0, sizeof(data), data);
+		float depth;
+		std::memcpy(&depth, &data[2], sizeof(float));
+
+		result.hit = data[0] != 0;
+		result.type = static_cast<StructureType>(data[0] >> 24);
+		result.filamentID = static_cast<int>(data[0] & 0x00FFFFFF);
+		result.elementID = static_cast<int>(data[1]);
+		result.depth = depth;
+		glm::vec4 position = pending.inverseViewProjection * glm::vec4(pending.ndc, depth * 2.0f - 1.0f, 1.0f);
+		result.position = glm::vec3(position) / position.w;
+		found = true;
+		m_readIndex = (m_readIndex + 1) % RING_SIZE;
+	}
+	return found;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+
+//structure types written into the ID attachment of the scene framebuffer
+//the values are hard coded in the fragment shaders, keep them in sync
+enum class StructureType
+{
+	NONE = 0,
+	Z_DISC = 1,
+	MYOSIN_ROD = 2,
+	ACTIN_ROD = 3,
+	ACTIN_MONOMER = 4,
+	TROPOMYOSIN = 5,
+	TROPONIN = 6,
+	LMM = 7,
+	HMM = 8,
+	MYOSIN_HEAD = 9,
+	MESH = 10
+};
+
+const char* getStructureName(StructureType type);
+
+struct PickResult
+{
+	bool hit = false;
+	StructureType type = StructureType::NONE;
+	int filamentID = -1;
+	int elementID = -1;
+	float depth = 1.0f;
+	glm::vec3 position = glm::vec3(0.0f);
+};
+
+// Reads the structure ID and depth below the cursor without stalling the render loop.
+// Every request copies one texel into a pixel buffer object of a small ring and places a fence,
+// the result is fetched one or two frames later once the fence has been signaled.
+// An ID texel is encoded as r = (structure type << 24) | filament index, g = element index.
+class Picker
+{
+public:
+	Picker();
+	~Picker();
+	// Queues a readback of the texel at x,y (framebuffer coordinates, origin bottom left)
+	// * GLuint fbo - framebuffer with the IDs in color attachment 1 and a depth attachment
+	// * glm::mat4 viewProjection - matrix of the frame, used to reconstruct the picked position
+	void requestPick(GLuint fbo, int x, int y, int width, int height, glm::mat4 viewProjection);
+	// Returns true if a queued readback finished since the last call and writes it to result
+	bool poll(PickResult& result);
+private:
+	static constexpr int RING_SIZE = 3;
+	struct PendingPick
+	{
+		GLsync fence = nullptr;
+		glm::mat4 inverseViewProjection;
+		glm::vec2 ndc;
+	};
+	std::array<GLuint, RING_SIZE> m_pbos;
+	std::array<PendingPick, RING_SIZE> m_pending;
+	int m_writeIndex = 0;
+	int m_readIndex = 0;
+};
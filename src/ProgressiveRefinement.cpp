@@ -0,0 +1,54 @@
+#include "ProgressiveRefinement.h"
+#include <algorithm>
+
+ProgressiveRefinement::ProgressiveRefinement()
+{
+	m_pending.fill(false);
+}
+
+void ProgressiveRefinement::beginFrame(const ProgressiveSettings& settings, bool interacting)
+{
+	m_interacting = settings.enabled && interacting;
+	m_proxyScale = settings.proxyScale;
+	m_stepTaken = false;
+}
+
+bool ProgressiveRefinement::defer(RefinementStep step)
+{
+	if (!m_interacting)
+	{
+		return false;
+	}
+	m_pending[static_cast<int>(step)] = true;
+	return true;
+}
+
+RefinementStep ProgressiveRefinement::nextStep()
+{
+	//the postponed steps are also finished if the mode was switched off in between
+	if (m_interacting || m_stepTaken)
+	{
+		return RefinementStep::COUNT;
+	}
+	for (int i = 0; i < static_cast<int>(RefinementStep::COUNT); i++)
+	{
+		if (m_pending[i])
+		{
+			m_pending[i] = false;
+			m_stepTaken = true;
+			return static_cast<RefinementStep>(i);
+		}
+	}
+	return RefinementStep::COUNT;
+}
+
+bool ProgressiveRefinement::isProxy()
+{
+	//the proxy is only needed once something was postponed, dragging a color keeps the full detail
+	return std::find(m_pending.begin(), m_pending.end(), true) != m_pending.end();
+}
+
+float ProgressiveRefinement::getRenderScale()
+{
+	return isProxy() ? m_proxyScale : 1.0f;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+
+//parameters of the progressive refinement window
+struct ProgressiveSettings
+{
+	bool enabled = true;
+	//factor applied to the render resolution while the proxy is shown
+	float proxyScale = 0.5f;
+};
+
+//detail structures that are regenerated after a drag, in the order in which they are refined
+enum class RefinementStep
+{
+	//double helices of the actin filaments with tropomyosin and troponin
+	ACTIN_DETAIL = 0,
+	//LMM and HMM helices of the myosin filaments with their heads
+	MYOSIN_DETAIL = 1,
+	//offsets and tilt of the HMM parts and the heads only
+	HMM_DETAIL = 2,
+	COUNT = 3
+};
+
+// Keeps the interaction responsive while parameters are dragged.
+// Regenerating the detail structures of a large lattice takes far longer than a frame, and a drag
+// used to regenerate them every frame. While a gui item is active the regenerations are only recorded
+// and the scene is drawn as a proxy from the filament rods at a reduced resolution. Once the input
+// settled, one recorded step is regenerated per frame, the detail structures and the full resolution
+// return after the last one. Nothing is regenerated more than once per drag.
+class ProgressiveRefinement
+{
+public:
+	ProgressiveRefinement();
+	// * bool interacting - true while a gui item is held
+	void beginFrame(const ProgressiveSettings& settings, bool interacting);
+	// Returns true if a regeneration has to be postponed, the step is then returned by nextStep() later
+	bool defer(RefinementStep step);
+	// Returns the next postponed step to regenerate this frame, COUNT if there is none or the input has not settled
+	RefinementStep nextStep();
+	// Returns true while the scene has to be drawn as the proxy
+	bool isProxy();
+	// Returns the factor applied to the render resolution
+	float getRenderScale();
+private:
+	std::array<bool, static_cast<int>(RefinementStep::COUNT)> m_pending;
+	bool m_interacting = false;
+	bool m_stepTaken = false;
+	float m_proxyScale = 1.0f;
+};
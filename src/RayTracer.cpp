@@ -0,0 +1,858 @@
+#include "RayTracer.h"
+#include "Sarcomere.h"
+#include "TiffWriter.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+
+namespace
+{
+	constexpr int TILE_SIZE = 32;
+	constexpr int TEMPLATE_LEAF_SIZE = 4;
+	constexpr int INSTANCE_LEAF_SIZE = 2;
+	constexpr int STACK_SIZE = 64;
+	constexpr float PI = 3.14159265358979f;
+
+	//xorshift, the state must never be 0
+	float nextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	uint32_t hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	//two tangents completing n to an orthonormal basis
+	void makeBasis(glm::vec3 n, glm::vec3& tangent, glm::vec3& bitangent)
+	{
+		tangent = glm::normalize(glm::abs(n.x) > 0.9f ? glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f)) : glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)));
+		bitangent = glm::cross(n, tangent);
+	}
+
+	//consecutive points of a line strip, the repeated end points of the adjacency strips add nothing
+	void addChain(std::vector<RayCapsule>& capsules, const std::vector<glm::vec3>& points, float radius)
+	{
+		for (size_t i = 1; i < points.size(); i++)
+		{
+			if (points[i] != points[i - 1])
+			{
+				capsules.push_back({ points[i - 1], radius, points[i], 0.0f });
+			}
+		}
+	}
+
+	//distance along the unit direction to the first intersection with the capsule, -1 if there is none
+	float intersectCapsule(glm::vec3 origin, glm::vec3 direction, const RayCapsule& capsule)
+	{
+		glm::vec3 ba = capsule.b - capsule.a;
+		glm::vec3 oa = origin - capsule.a;
+		float baba = glm::dot(ba, ba);
+		float r2 = capsule.radius * capsule.radius;
+		if (baba > 0.0f)
+		{
+			//infinite cylinder first, its hit counts if it lies between the end caps
+			float bard = glm::dot(ba, direction);
+			float baoa = glm::dot(ba, oa);
+			float rdoa = glm::dot(direction, oa);
+			float oaoa = glm::dot(oa, oa);
+			float a = baba - bard * bard;
+			float b = baba * rdoa - baoa * bard;
+			float c = baba * oaoa - baoa * baoa - r2 * baba;
+			float h = b * b - a * c;
+			if (h < 0.0f)
+			{
+				return -1.0f;
+			}
+			if (a > 0.0f)
+			{
+				float t = (-b - glm::sqrt(h)) / a;
+				float y = baoa + t * bard;
+				if (y > 0.0f && y < baba)
+				{
+					return t;
+				}
+				oa = y <= 0.0f ? oa : origin - capsule.b;
+			}
+		}
+		//sphere of the nearer end cap
+		float b = glm::dot(direction, oa);
+		float c = glm::dot(oa, oa) - r2;
+		float h = b * b - c;
+		return h > 0.0f ? -b - glm::sqrt(h) : -1.0f;
+	}
+
+	//returns true if any active ray of the packet enters the box before its tMax
+	bool intersectBox(const float origin[3][4], const float inverseDirection[3][4], const float tMax[4], const int32_t active[4], const BVHNode& node)
+	{
+		__m128 tNear = _mm_setzero_ps();
+		__m128 tFar = _mm_load_ps(tMax);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 o = _mm_load_ps(origin[axis]);
+			__m128 inverse = _mm_load_ps(inverseDirection[axis]);
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[axis]), o), inverse);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[axis]), o), inverse);
+			tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+			tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+		}
+		__m128 hit = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(active))));
+		return _mm_movemask_ps(hit) != 0;
+	}
+
+	bool anyActive(const int32_t active[4])
+	{
+		return _mm_movemask_ps(_mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(active)))) != 0;
+	}
+
+	void buildNode(std::vector<BVHNode>& nodes, int nodeIndex, std::vector<int>& indices, int first, int count, int leafSize,
+		const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax)
+	{
+		glm::vec3 boundsMin(FLT_MAX);
+		glm::vec3 boundsMax(-FLT_MAX);
+		glm::vec3 centerMin(FLT_MAX);
+		glm::vec3 centerMax(-FLT_MAX);
+		for (int i = first; i < first + count; i++)
+		{
+			int index = indices[i];
+			boundsMin = glm::min(boundsMin, boxMin[index]);
+			boundsMax = glm::max(boundsMax, boxMax[index]);
+			glm::vec3 center = (boxMin[index] + boxMax[index]) * 0.5f;
+			centerMin = glm::min(centerMin, center);
+			centerMax = glm::max(centerMax, center);
+		}
+		nodes[nodeIndex].boundsMin = boundsMin;
+		nodes[nodeIndex].boundsMax = boundsMax;
+		glm::vec3 extent = centerMax - centerMin;
+		int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+		//small ranges and primitives sharing one center stay together
+		if (count <= leafSize || extent[axis] <= 0.0f)
+		{
+			nodes[nodeIndex].first = first;
+			nodes[nodeIndex].count = count;
+			nodes[nodeIndex].axis = 0;
+			return;
+		}
+		//median split along the longest axis of the centers
+		int middle = first + count / 2;
+		std::nth_element(indices.begin() + first, indices.begin() + middle, indices.begin() + first + count, [&](int a, int b)
+		{
+			return boxMin[a][axis] + boxMax[a][axis] < boxMin[b][axis] + boxMax[b][axis];
+		});
+		int left = static_cast<int>(nodes.size());
+		nodes.push_back({});
+		nodes.push_back({});
+		nodes[nodeIndex].first = left;
+		nodes[nodeIndex].count = 0;
+		nodes[nodeIndex].axis = axis;
+		buildNode(nodes, left, indices, first, middle - first, leafSize, boxMin, boxMax);
+		buildNode(nodes, left + 1, indices, middle, first + count - middle, leafSize, boxMin, boxMax);
+	}
+}
+
+RayTracer::RayTracer()
+{
+}
+
+void RayTracer::setGroup(CullGroup group, const CullGroupDescription& description)
+{
+	m_groups[static_cast<int>(group)] = description;
+}
+
+void RayTracer::setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix)
+{
+	m_rotationMatrix = rotationMatrix;
+	m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+}
+
+void RayTracer::setClipPlanes(const std::vector<glm::vec4>& planes)
+{
+	m_clipPlanes = planes;
+}
+
+void RayTracer::setTiles(const LatticeTiles* tiles)
+{
+	m_tiles = tiles;
+}
+
+void RayTracer::build(Sarcomere& sarcomere, bool bothHelices)
+{
+	m_templates.clear();
+	m_instances.clear();
+	m_nodes.clear();
+	m_d10 = sarcomere.d10;
+	std::vector<glm::vec4> actinRods = sarcomere.getActinRods();
+	std::vector<glm::vec4> myosinRods = sarcomere.getMyosinRods();
+	auto addGroup = [&](CullGroup group, std::vector<RayCapsule>& capsules, glm::vec3 color)
+	{
+		const CullGroupDescription& description = m_groups[static_cast<int>(group)];
+		if (!description.enabled)
+		{
+			return;
+		}
+		int templateIndex = addTemplate(capsules, color, group, description.filamentBinding);
+		addInstances(templateIndex, description.filamentBinding == 2 ? myosinRods : actinRods, description.numFilaments, description.secondHalfStart, description.filamentBinding);
+	};
+
+	//the rods are the capsules the culler bounds them with
+	for (CullGroup group : { CullGroup::ACTIN_RODS, CullGroup::MYOSIN_RODS })
+	{
+		const CullGroupDescription& description = m_groups[static_cast<int>(group)];
+		std::vector<RayCapsule> capsules = { { description.axisStart, description.boundingRadius, description.axisEnd, 0.0f } };
+		addGroup(group, capsules, group == CullGroup::ACTIN_RODS ? sarcomere.getActinColor() : sarcomere.getMyosinColor());
+	}
+
+	//the sprites are spheres with the radius of the culler
+	auto addSpheres = [&](CullGroup group, const std::vector<glm::vec4>& positions, float radius, glm::vec3 color)
+	{
+		std::vector<RayCapsule> capsules;
+		for (const glm::vec4& position : positions)
+		{
+			capsules.push_back({ glm::vec3(position), radius, glm::vec3(position), 0.0f });
+		}
+		addGroup(group, capsules, color);
+	};
+	addSpheres(CullGroup::ACTIN_MONOMERS, sarcomere.getActinParticles(), m_groups[static_cast<int>(CullGroup::ACTIN_MONOMERS)].boundingRadius, sarcomere.getActinColor());
+	addSpheres(CullGroup::TROPONIN, sarcomere.getTroponinPositions(), m_groups[static_cast<int>(CullGroup::TROPONIN)].boundingRadius, sarcomere.getTroponinColor());
+	//the head sprites are ten times their base size, the heads fill about a third of them
+	addSpheres(CullGroup::MYOSIN_HEADS, sarcomere.getMyosinHeadOffsetPositions(), sarcomere.myosinHeadRadius * 3.5f, sarcomere.getMyosinHeadColor());
+
+	//the helices are placed like the vertex shaders place them, every segment of a strip becomes a capsule
+	//one strand per filament half, the second one mirrored by the second half rotation
+	const std::vector<glm::vec4>& tropomyosinPositions = sarcomere.getTropomyosinPositions();
+	std::vector<RayCapsule> tropomyosin;
+	for (int strand = 0; strand < 2; strand++)
+	{
+		//the first and the last point only give the tangents
+		std::vector<glm::vec3> points;
+		for (size_t i = 1; i + 1 < tropomyosinPositions.size(); i++)
+		{
+			points.push_back(glm::vec3(strand == 0 ? tropomyosinPositions[i] : m_secondHalfRotationMatrix * tropomyosinPositions[i]));
+		}
+		addChain(tropomyosin, points, sarcomere.actinRadius / 8.0f);
+	}
+	addGroup(CullGroup::TROPOMYOSIN, tropomyosin, sarcomere.getTropomyosinColor());
+
+	const std::vector<glm::vec4>& LMMOffsets = sarcomere.getLMMOffsetPositions();
+	int numLMMPieces = static_cast<int>(LMMOffsets.size());
+	std::vector<RayCapsule> LMM;
+	for (int helix = 0; helix < (bothHelices ? 2 : 1); helix++)
+	{
+		for (int piece = 0; piece < numLMMPieces; piece++)
+		{
+			std::vector<glm::vec3> points;
+			for (const glm::vec4& position : sarcomere.getLMMPositions(helix))
+			{
+				glm::vec4 rotated = piece < numLMMPieces / 2 ? m_secondHalfRotationMatrix * position : position;
+				points.push_back(glm::vec3(rotated) + glm::vec3(LMMOffsets[piece]));
+			}
+			addChain(LMM, points, sarcomere.myosinTrunkRadius / 20.0f);
+		}
+	}
+	addGroup(CullGroup::LMM, LMM, sarcomere.getLMMColor());
+
+	//both halves share the tilt and the turn of the pieces of the first half
+	const std::vector<glm::vec4>& HMMOffsets = sarcomere.getHMMOffsetPositions();
+	const std::vector<glm::vec4>& HMMRotations = sarcomere.getHMMRotations();
+	int numHMMPieces = static_cast<int>(HMMOffsets.size());
+	std::vector<RayCapsule> HMM;
+	for (int helix = 0; helix < (bothHelices ? 2 : 1) && !HMMRotations.empty(); helix++)
+	{
+		for (int piece = 0; piece < numHMMPieces; piece++)
+		{
+			glm::vec4 rotation = HMMRotations[piece % std::max(numHMMPieces / 2, 1) % HMMRotations.size()];
+			std::vector<glm::vec3> points;
+			for (const glm::vec4& position : sarcomere.getHMMPositions(helix))
+			{
+				glm::vec3 p = glm::vec3(rotation.z * position.x + rotation.w * position.y, -rotation.w * position.x + rotation.z * position.y, position.z);
+				if (piece < numHMMPieces / 2)
+				{
+					p = glm::mat3(m_secondHalfRotationMatrix) * p;
+				}
+				p = glm::vec3(rotation.x * p.x + rotation.y * p.z, p.y, -rotation.y * p.x + rotation.x * p.z);
+				points.push_back(p + glm::vec3(HMMOffsets[piece]));
+			}
+			addChain(HMM, points, sarcomere.myosinTrunkRadius / 20.0f);
+		}
+	}
+	addGroup(CullGroup::HMM, HMM, sarcomere.getHMMColor());
+
+	//top level bvh over the world space boxes of the instances
+	std::vector<glm::vec3> boxMin(m_instances.size());
+	std::vector<glm::vec3> boxMax(m_instances.size());
+	for (size_t i = 0; i < m_instances.size(); i++)
+	{
+		const Instance& instance = m_instances[i];
+		const BVHNode& root = m_templates[instance.templateIndex].nodes[0];
+		boxMin[i] = glm::vec3(FLT_MAX);
+		boxMax[i] = glm::vec3(-FLT_MAX);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 local((corner & 1) ? root.boundsMax.x : root.boundsMin.x, (corner & 2) ? root.boundsMax.y : root.boundsMin.y, (corner & 4) ? root.boundsMax.z : root.boundsMin.z);
+			glm::vec3 world = instance.rotation * local + instance.translation;
+			boxMin[i] = glm::min(boxMin[i], world);
+			boxMax[i] = glm::max(boxMax[i], world);
+		}
+	}
+	std::vector<int> indices;
+	buildBVH(m_nodes, indices, boxMin, boxMax, INSTANCE_LEAF_SIZE);
+	std::vector<Instance> sortedInstances(m_instances.size());
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		sortedInstances[i] = m_instances[indices[i]];
+	}
+	m_instances.swap(sortedInstances);
+}
+
+int RayTracer::addTemplate(std::vector<RayCapsule>& capsules, glm::vec3 color, CullGroup group, int filamentBinding)
+{
+	if (capsules.empty())
+	{
+		return -1;
+	}
+	std::vector<glm::vec3> boxMin(capsules.size());
+	std::vector<glm::vec3> boxMax(capsules.size());
+	for (size_t i = 0; i < capsules.size(); i++)
+	{
+		boxMin[i] = glm::min(capsules[i].a, capsules[i].b) - capsules[i].radius;
+		boxMax[i] = glm::max(capsules[i].a, capsules[i].b) + capsules[i].radius;
+	}
+	Template rayTemplate;
+	std::vector<int> indices;
+	buildBVH(rayTemplate.nodes, indices, boxMin, boxMax, TEMPLATE_LEAF_SIZE);
+	rayTemplate.capsules.reserve(capsules.size());
+	for (int index : indices)
+	{
+		rayTemplate.capsules.push_back(capsules[index]);
+	}
+	rayTemplate.color = color;
+	rayTemplate.group = group;
+	rayTemplate.filamentBinding = filamentBinding;
+	m_templates.push_back(std::move(rayTemplate));
+	return static_cast<int>(m_templates.size()) - 1;
+}
+
+void RayTracer::addInstances(int templateIndex, const std::vector<glm::vec4>& offsets, int numFilaments, int secondHalfStart, int filamentBinding)
+{
+	if (templateIndex < 0)
+	{
+		return;
+	}
+	//the tiles bound every structure of their filaments, so a clipped tile has nothing to hit
+	int kind = LatticeTiles::getKind(filamentBinding);
+	std::vector<int> tileSides;
+	if (m_tiles && m_tiles->isEnabled() && m_tiles->getNumFilaments(kind) == static_cast<int>(offsets.size()))
+	{
+		for (const LatticeTile& tile : m_tiles->getTiles())
+		{
+			tileSides.push_back(m_tiles->classify(tile, kind, m_rotationMatrix, m_clipPlanes, 0.0f));
+		}
+	}
+	for (int filament = 0; filament < std::min(numFilaments, static_cast<int>(offsets.size())); filament++)
+	{
+		int tile = tileSides.empty() ? -1 : m_tiles->getTile(kind, filament);
+		if (tile >= 0 && tileSides[tile] < 0)
+		{
+			continue;
+		}
+		//the offset is added before the rotations, exactly like in the vertex shaders
+		glm::mat4 rotation = filament >= secondHalfStart ? m_rotationMatrix * m_secondHalfRotationMatrix : m_rotationMatrix;
+		Instance instance;
+		instance.rotation = glm::mat3(rotation);
+		instance.translation = glm::vec3(rotation * glm::vec4(glm::vec3(offsets[filament]), 1.0f));
+		instance.templateIndex = templateIndex;
+		m_instances.push_back(instance);
+	}
+}
+
+void RayTracer::buildBVH(std::vector<BVHNode>& nodes, std::vector<int>& indices, const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax, int leafSize)
+{
+	int count = static_cast<int>(boxMin.size());
+	indices.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		indices[i] = i;
+	}
+	nodes.clear();
+	if (count == 0)
+	{
+		return;
+	}
+	nodes.reserve(2 * count);
+	nodes.push_back({});
+	buildNode(nodes, 0, indices, 0, count, leafSize, boxMin, boxMax);
+}
+
+void RayTracer::trace(RayPacket& packet, PacketHit& hit, bool anyHit) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = m_nodes[stack[--stackSize]];
+		if (!intersectBox(packet.origin, packet.inverseDirection, packet.tMax, packet.active, node))
+		{
+			continue;
+		}
+		if (node.count == 0)
+		{
+			//the packets are coherent, the first ray decides which child is visited first
+			int nearChild = packet.direction[node.axis][0] < 0.0f ? node.first + 1 : node.first;
+			stack[stackSize++] = nearChild == node.first ? node.first + 1 : node.first;
+			stack[stackSize++] = nearChild;
+			continue;
+		}
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			traceInstance(packet, hit, m_instances[i], i, m_clipPlanes, anyHit);
+		}
+		if (anyHit && !anyActive(packet.active))
+		{
+			return;
+		}
+	}
+}
+
+void RayTracer::traceInstance(RayPacket& packet, PacketHit& hit, const Instance& instance, int instanceIndex, const std::vector<glm::vec4>& clipPlanes, bool anyHit) const
+{
+	const Template& rayTemplate = m_templates[instance.templateIndex];
+	//move the packet into the template space, the transform is orthonormal so the distances stay the same
+	RayPacket local;
+	glm::mat3 inverse = glm::transpose(instance.rotation);
+	__m128 relative[3];
+	__m128 direction[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		relative[axis] = _mm_sub_ps(_mm_load_ps(packet.origin[axis]), _mm_set1_ps(instance.translation[axis]));
+		direction[axis] = _mm_load_ps(packet.direction[axis]);
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		__m128 origin = _mm_setzero_ps();
+		__m128 localDirection = _mm_setzero_ps();
+		for (int column = 0; column < 3; column++)
+		{
+			__m128 factor = _mm_set1_ps(inverse[column][axis]);
+			origin = _mm_add_ps(origin, _mm_mul_ps(factor, relative[column]));
+			localDirection = _mm_add_ps(localDirection, _mm_mul_ps(factor, direction[column]));
+		}
+		_mm_store_ps(local.origin[axis], origin);
+		_mm_store_ps(local.direction[axis], localDirection);
+		_mm_store_ps(local.inverseDirection[axis], _mm_div_ps(_mm_set1_ps(1.0f), localDirection));
+	}
+	std::copy(packet.tMax, packet.tMax + 4, local.tMax);
+	std::copy(packet.active, packet.active + 4, local.active);
+
+	int stack[STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = rayTemplate.nodes[stack[--stackSize]];
+		if (!intersectBox(local.origin, local.inverseDirection, local.tMax, local.active, node))
+		{
+			continue;
+		}
+		if (node.count == 0)
+		{
+			int nearChild = local.direction[node.axis][0] < 0.0f ? node.first + 1 : node.first;
+			stack[stackSize++] = nearChild == node.first ? node.first + 1 : node.first;
+			stack[stackSize++] = nearChild;
+			continue;
+		}
+		//the capsules are tested one ray at a time, the packet only shares the traversal
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!local.active[lane])
+				{
+					continue;
+				}
+				glm::vec3 origin(local.origin[0][lane], local.origin[1][lane], local.origin[2][lane]);
+				glm::vec3 localDirection(local.direction[0][lane], local.direction[1][lane], local.direction[2][lane]);
+				float t = intersectCapsule(origin, localDirection, rayTemplate.capsules[i]);
+				if (t <= 0.0f || t >= local.tMax[lane])
+				{
+					continue;
+				}
+				glm::vec3 position = glm::vec3(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]) +
+					t * glm::vec3(packet.direction[0][lane], packet.direction[1][lane], packet.direction[2][lane]);
+				if (isClipped(position, clipPlanes))
+				{
+					continue;
+				}
+				local.tMax[lane] = t;
+				hit.instance[lane] = instanceIndex;
+				hit.capsule[lane] = i;
+				if (anyHit)
+				{
+					local.active[lane] = 0;
+				}
+			}
+		}
+		if (anyHit && !anyActive(local.active))
+		{
+			break;
+		}
+	}
+	std::copy(local.tMax, local.tMax + 4, packet.tMax);
+	std::copy(local.active, local.active + 4, packet.active);
+}
+
+bool RayTracer::isClipped(glm::vec3 position, const std::vector<glm::vec4>& clipPlanes)
+{
+	for (const glm::vec4& plane : clipPlanes)
+	{
+		if (glm::dot(glm::vec3(plane), position) + plane.w < 0.0f)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+glm::vec3 RayTracer::getNormal(const Instance& instance, int capsuleIndex, glm::vec3 position) const
+{
+	const RayCapsule& capsule = m_templates[instance.templateIndex].capsules[capsuleIndex];
+	glm::vec3 local = glm::transpose(instance.rotation) * (position - instance.translation);
+	glm::vec3 ba = capsule.b - capsule.a;
+	float baba = glm::dot(ba, ba);
+	float h = baba > 0.0f ? glm::clamp(glm::dot(local - capsule.a, ba) / baba, 0.0f, 1.0f) : 0.0f;
+	glm::vec3 normal = local - (capsule.a + h * ba);
+	float length = glm::length(normal);
+	return instance.rotation * (length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+bool RayTracer::render(const char* path, const RayTracerSettings& settings, glm::mat4 view, glm::mat4 projection, glm::vec3 lightDirection, glm::vec3 background)
+{
+	int width = settings.width;
+	int height = settings.height;
+	if (width < 1 || height < 1)
+	{
+		std::cout << "FAIL: Invalid image size." << std::endl;
+		return false;
+	}
+	TiffWriter writer;
+	if (!writer.open(path, width, height, TILE_SIZE, settings.dpi))
+	{
+		return false;
+	}
+
+	//rays start on the near plane of the rasterizer and run through the pixel centers of its projection
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::mat4 inverseView = glm::inverse(view);
+	glm::vec3 eye = glm::vec3(inverseView[3]);
+	glm::vec3 right = glm::normalize(glm::vec3(inverseView[0]));
+	glm::vec3 up = glm::normalize(glm::vec3(inverseView[1]));
+	glm::vec3 forward = -glm::normalize(glm::vec3(inverseView[2]));
+	glm::vec3 light = glm::normalize(lightDirection);
+	glm::vec3 lightTangent, lightBitangent;
+	makeBasis(light, lightTangent, lightBitangent);
+	float cosLightAngle = glm::cos(glm::radians(glm::max(settings.lightAngle, 0.0f)) / 2.0f);
+	float aperture = glm::max(settings.aperture, 0.0f) * m_d10;
+	float focusDistance = glm::max(settings.focusDistance, 0.0f) * m_d10;
+	float occlusionDistance = glm::max(settings.occlusionDistance, 0.0f) * m_d10;
+	int samples = std::max(settings.samplesPerPixel, 1);
+	int occlusionRays = std::max(settings.occlusionRays, 0);
+	//secondary rays start slightly above the surface
+	float surfaceOffset = 0.0001f * m_d10;
+
+	std::vector<unsigned char> strip(static_cast<size_t>(width) * TILE_SIZE * 3);
+	int numColumns = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int numRows = (height + TILE_SIZE - 1) / TILE_SIZE;
+	bool success = true;
+	for (int row = 0; row < numRows && success; row++)
+	{
+		int rowTop = row * TILE_SIZE;
+		int rows = std::min(TILE_SIZE, height - rowTop);
+		#pragma omp parallel for schedule(dynamic)
+		for (int column = 0; column < numColumns; column++)
+		{
+			int x0 = column * TILE_SIZE;
+			int columns = std::min(TILE_SIZE, width - x0);
+			//2x2 pixels share a packet
+			for (int y = 0; y < rows; y += 2)
+			{
+				for (int x = 0; x < columns; x += 2)
+				{
+					glm::vec3 colors[4] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+					uint32_t states[4];
+					for (int lane = 0; lane < 4; lane++)
+					{
+						states[lane] = hash(static_cast<uint32_t>((rowTop + y + lane / 2) * width + x0 + x + lane % 2)) | 1u;
+					}
+					for (int sample = 0; sample < samples; sample++)
+					{
+						RayPacket packet = {};
+						PacketHit hit = {};
+						for (int lane = 0; lane < 4; lane++)
+						{
+							float px = static_cast<float>(x0 + x + lane % 2) + nextRandom(states[lane]);
+							float py = static_cast<float>(rowTop + y + lane / 2) + nextRandom(states[lane]);
+							//tiff rows run top to bottom
+							glm::vec4 nearPoint = inverseViewProjection * glm::vec4(2.0f * px / width - 1.0f, 1.0f - 2.0f * py / height, -1.0f, 1.0f);
+							glm::vec4 farPoint = inverseViewProjection * glm::vec4(2.0f * px / width - 1.0f, 1.0f - 2.0f * py / height, 1.0f, 1.0f);
+							glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+							glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+							if (aperture > 0.0f)
+							{
+								//thin lens, every ray through the lens meets the others on the plane in focus
+								glm::vec3 focusPoint = origin + direction * ((focusDistance - glm::dot(origin - eye, forward)) / glm::dot(direction, forward));
+								float radius = aperture * glm::sqrt(nextRandom(states[lane]));
+								float angle = 2.0f * PI * nextRandom(states[lane]);
+								origin += (right * glm::cos(angle) + up * glm::sin(angle)) * radius;
+								direction = glm::normalize(focusPoint - origin);
+							}
+							for (int axis = 0; axis < 3; axis++)
+							{
+								packet.origin[axis][lane] = origin[axis];
+								packet.direction[axis][lane] = direction[axis];
+								packet.inverseDirection[axis][lane] = 1.0f / direction[axis];
+							}
+							packet.tMax[lane] = FLT_MAX;
+							packet.active[lane] = -1;
+						}
+						trace(packet, hit, false);
+
+						//shadow and occlusion rays of the lanes that hit something
+						glm::vec3 positions[4];
+						glm::vec3 normals[4];
+						RayPacket shadow = {};
+						PacketHit shadowHit = {};
+						bool hasHit[4];
+						for (int lane = 0; lane < 4; lane++)
+						{
+							hasHit[lane] = packet.tMax[lane] < FLT_MAX;
+							if (!hasHit[lane])
+							{
+								continue;
+							}
+							glm::vec3 direction(packet.direction[0][lane], packet.direction[1][lane], packet.direction[2][lane]);
+							positions[lane] = glm::vec3(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]) + packet.tMax[lane] * direction;
+							normals[lane] = getNormal(m_instances[hit.instance[lane]], hit.capsule[lane], positions[lane]);
+							if (glm::dot(normals[lane], direction) > 0.0f)
+							{
+								normals[lane] = -normals[lane];
+							}
+							//a direction within the cone of the light
+							float cosTheta = 1.0f - nextRandom(states[lane]) * (1.0f - cosLightAngle);
+							float sinTheta = glm::sqrt(glm::max(1.0f - cosTheta * cosTheta, 0.0f));
+							float phi = 2.0f * PI * nextRandom(states[lane]);
+							glm::vec3 toLight = glm::normalize(light * cosTheta + (lightTangent * glm::cos(phi) + lightBitangent * glm::sin(phi)) * sinTheta);
+							glm::vec3 origin = positions[lane] + normals[lane] * surfaceOffset;
+							for (int axis = 0; axis < 3; axis++)
+							{
+								shadow.origin[axis][lane] = origin[axis];
+								shadow.direction[axis][lane] = toLight[axis];
+								shadow.inverseDirection[axis][lane] = 1.0f / toLight[axis];
+							}
+							shadow.tMax[lane] = FLT_MAX;
+							shadow.active[lane] = glm::dot(normals[lane], toLight) > 0.0f ? -1 : 0;
+						}
+						float diffuse[4];
+						for (int lane = 0; lane < 4; lane++)
+						{
+							glm::vec3 toLight(shadow.direction[0][lane], shadow.direction[1][lane], shadow.direction[2][lane]);
+							diffuse[lane] = shadow.active[lane] ? glm::dot(normals[lane], toLight) : 0.0f;
+						}
+						trace(shadow, shadowHit, true);
+
+						float visibility[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+						if (occlusionRays > 0 && occlusionDistance > 0.0f)
+						{
+							for (int lane = 0; lane < 4; lane++)
+							{
+								visibility[lane] = 0.0f;
+							}
+							for (int i = 0; i < occlusionRays; i++)
+							{
+								RayPacket occlusion = {};
+								PacketHit occlusionHit = {};
+								for (int lane = 0; lane < 4; lane++)
+								{
+									if (!hasHit[lane])
+									{
+										continue;
+									}
+									//cosine weighted directions around the normal
+									glm::vec3 tangent, bitangent;
+									makeBasis(normals[lane], tangent, bitangent);
+									float u = nextRandom(states[lane]);
+									float phi = 2.0f * PI * nextRandom(states[lane]);
+									glm::vec3 direction = glm::normalize((tangent * glm::cos(phi) + bitangent * glm::sin(phi)) * glm::sqrt(u) + normals[lane] * glm::sqrt(1.0f - u));
+									glm::vec3 origin = positions[lane] + normals[lane] * surfaceOffset;
+									for (int axis = 0; axis < 3; axis++)
+									{
+										occlusion.origin[axis][lane] = origin[axis];
+										occlusion.direction[axis][lane] = direction[axis];
+										occlusion.inverseDirection[axis][lane] = 1.0f / direction[axis];
+									}
+									occlusion.tMax[lane] = occlusionDistance;
+									occlusion.active[lane] = -1;
+								}
+								trace(occlusion, occlusionHit, true);
+								for (int lane = 0; lane < 4; lane++)
+								{
+									visibility[lane] += occlusion.active[lane] ? 1.0f / occlusionRays : 0.0f;
+								}
+							}
+						}
+
+						for (int lane = 0; lane < 4; lane++)
+						{
+							if (!hasHit[lane])
+							{
+								colors[lane] += background;
+								continue;
+							}
+							float lit = shadow.active[lane] ? diffuse[lane] : 0.0f;
+							const Instance& instance = m_instances[hit.instance[lane]];
+							colors[lane] += m_templates[instance.templateIndex].color * (0.3f * visibility[lane] + 0.7f * lit);
+						}
+					}
+					for (int lane = 0; lane < 4; lane++)
+					{
+						int px = x + lane % 2;
+						int py = y + lane / 2;
+						if (px >= columns || py >= rows)
+						{
+							continue;
+						}
+						glm::vec3 color = glm::clamp(colors[lane] / static_cast<float>(samples), 0.0f, 1.0f);
+						size_t pixel = (static_cast<size_t>(py) * width + x0 + px) * 3;
+						for (int channel = 0; channel < 3; channel++)
+						{
+							strip[pixel + channel] = static_cast<unsigned char>(color[channel] * 255.0f + 0.5f);
+						}
+					}
+				}
+			}
+		}
+		success = writer.writeRows(strip.data(), rows);
+		std::cout << "Ray traced row " << row + 1 << " / " << numRows << std::endl;
+	}
+	return writer.close() && success;
+}
+
+bool RayTracer::getLocalBounds(int filamentBinding, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	boundsMin = glm::vec3(FLT_MAX);
+	boundsMax = glm::vec3(-FLT_MAX);
+	bool found = false;
+	for (const Template& rayTemplate : m_templates)
+	{
+		if (rayTemplate.filamentBinding == filamentBinding)
+		{
+			boundsMin = glm::min(boundsMin, rayTemplate.nodes[0].boundsMin);
+			boundsMax = glm::max(boundsMax, rayTemplate.nodes[0].boundsMax);
+			found = true;
+		}
+	}
+	return found;
+}
+
+void RayTracer::traceLocal(int filamentBinding, glm::vec3 center, glm::vec3 direction, glm::vec3 right, glm::vec3 up, float halfSize,
+	const std::vector<glm::vec4>& planes, int size, LocalSample* samples) const
+{
+	//every template of the filament is an instance at the origin of the local space
+	std::vector<Instance> instances;
+	std::vector<int> templateIndices;
+	for (int i = 0; i < static_cast<int>(m_templates.size()); i++)
+	{
+		if (m_templates[i].filamentBinding == filamentBinding)
+		{
+			instances.push_back({ glm::mat3(1.0f), glm::vec3(0.0f), i });
+			templateIndices.push_back(i);
+		}
+	}
+	//the rays start in front of the bounding sphere of the view and run parallel
+	glm::vec3 origin = center + direction * (2.0f * halfSize);
+	float pixelSize = 2.0f * halfSize / size;
+	#pragma omp parallel for schedule(dynamic)
+	for (int y = 0; y < size; y += 2)
+	{
+		for (int x = 0; x < size; x += 2)
+		{
+			RayPacket packet = {};
+			PacketHit hit = {};
+			for (int lane = 0; lane < 4; lane++)
+			{
+				glm::vec3 laneOrigin = origin + right * ((x + lane % 2 + 0.5f) * pixelSize - halfSize) + up * ((y + lane / 2 + 0.5f) * pixelSize - halfSize);
+				for (int axis = 0; axis < 3; axis++)
+				{
+					packet.origin[axis][lane] = laneOrigin[axis];
+					packet.direction[axis][lane] = -direction[axis];
+					packet.inverseDirection[axis][lane] = -1.0f / direction[axis];
+				}
+				packet.tMax[lane] = 4.0f * halfSize;
+				packet.active[lane] = -1;
+				hit.instance[lane] = -1;
+			}
+			for (int i = 0; i < static_cast<int>(instances.size()); i++)
+			{
+				traceInstance(packet, hit, instances[i], i, planes, false);
+			}
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int px = x + lane % 2;
+				int py = y + lane / 2;
+				if (px >= size || py >= size)
+				{
+					continue;
+				}
+				LocalSample& sample = samples[static_cast<size_t>(py) * size + px];
+				if (hit.instance[lane] < 0)
+				{
+					sample = { glm::vec3(0.0f), 0.0f, -1 };
+					continue;
+				}
+				glm::vec3 position = glm::vec3(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]) - direction * packet.tMax[lane];
+				glm::vec3 normal = getNormal(instances[hit.instance[lane]], hit.capsule[lane], position);
+				sample = { glm::dot(normal, direction) < 0.0f ? -normal : normal, glm::dot(position - center, direction),
+					static_cast<int>(m_templates[templateIndices[hit.instance[lane]]].group) };
+			}
+		}
+	}
+}
+
+int RayTracer::getNumInstances()
+{
+	return static_cast<int>(m_instances.size());
+}
+
+int RayTracer::getNumPrimitives()
+{
+	size_t numPrimitives = 0;
+	for (const Template& rayTemplate : m_templates)
+	{
+		numPrimitives += rayTemplate.capsules.size();
+	}
+	return static_cast<int>(numPrimitives);
+}
+
+size_t RayTracer::getMemoryUsage()
+{
+	size_t size = m_instances.size() * sizeof(Instance) + m_nodes.size() * sizeof(BVHNode);
+	for (const Template& rayTemplate : m_templates)
+	{
+		size += rayTemplate.capsules.size() * sizeof(RayCapsule) + rayTemplate.nodes.size() * sizeof(BVHNode);
+	}
+	return size;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "InstanceCuller.h"
+
+class Sarcomere;
+
+//parameters of the ray tracing window
+struct RayTracerSettings
+{
+	int width = 3840;
+	int height = 2160;
+	int samplesPerPixel = 16;
+	//occlusion rays per sample, 0 = no ambient occlusion
+	int occlusionRays = 2;
+	//distance in d10 up to which a structure occludes the ambient light
+	float occlusionDistance = 0.5f;
+	//angular diameter of the light in degrees, 0 = hard shadows
+	float lightAngle = 2.0f;
+	//radius of the lens in d10, 0 = pinhole camera without depth of field
+	float aperture = 0.0f;
+	//distance of the plane in focus from the camera in d10
+	float focusDistance = 20.0f;
+	float dpi = 300.0f;
+};
+
+//capsule around the segment from a to b, a sphere if both are equal
+struct RayCapsule
+{
+	glm::vec3 a;
+	float radius;
+	glm::vec3 b;
+	float padding;
+};
+
+//surface seen by a pixel of an image in the local space of a filament, group = -1 if the pixel sees nothing
+struct LocalSample
+{
+	glm::vec3 normal;
+	//signed distance of the surface from the center along the view direction
+	float depth;
+	int group;
+};
+
+//axis aligned box of a bvh node, inner nodes have two adjacent children starting at first
+struct BVHNode
+{
+	glm::vec3 boundsMin;
+	int first;
+	glm::vec3 boundsMax;
+	//number of primitives of a leaf, 0 for inner nodes
+	int count;
+	//axis of the split, the child on the negative side is stored first
+	int axis;
+};
+
+// Offline renderer for figures with ambient occlusion, soft shadows and depth of field.
+// Every structure of a filament is stored once as a template in its local space with its own bvh over
+// capsules and spheres, the monomers, troponin, tropomyosin, LMM, HMM and heads of all filaments are the same.
+// The filaments are instances of the templates, placed by the rotations of the sarcomere and their offset,
+// and a top level bvh over the instances finds the filaments a ray passes. The memory grows with the number
+// of filaments, the monomers of a filament are never copied. The image is traced in tiles on all cores (OpenMP)
+// with packets of 2x2 rays, which test the bvh boxes four at a time with SSE and share their traversal.
+// The camera and the clipping planes are the ones of the rasterizer, the filaments of lattice tiles behind a
+// clipping plane get no instances. The result is streamed into a tiff file.
+class RayTracer
+{
+public:
+	RayTracer();
+	// Uses the same descriptions as the culler, the disabled groups are left out
+	void setGroup(CullGroup group, const CullGroupDescription& description);
+	void setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix);
+	// * std::vector<glm::vec4> planes - world space planes, surfaces behind any of them are not hit
+	void setClipPlanes(const std::vector<glm::vec4>& planes);
+	// * const LatticeTiles* tiles - the filaments of clipped tiles are left out, nullptr = no tiles
+	void setTiles(const LatticeTiles* tiles);
+	// Builds the templates and the instances of the enabled groups from the cpu arrays of the sarcomere
+	// * bool bothHelices - adds the second helix of every LMM and HMM piece
+	void build(Sarcomere& sarcomere, bool bothHelices);
+	// Traces the image and writes it to path, returns false if the file could not be written
+	// * glm::mat4 projection - projection of the whole image, its aspect has to match the image
+	// * glm::vec3 lightDirection - world space direction towards the light
+	bool render(const char* path, const RayTracerSettings& settings, glm::mat4 view, glm::mat4 projection, glm::vec3 lightDirection, glm::vec3 background);
+	// Returns the bounds of the templates of one kind of filament in their local space, false if there are none
+	// * int filamentBinding - 2 = the myosin filaments, 3 = the actin filaments
+	bool getLocalBounds(int filamentBinding, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+	// Traces a square image of the templates of one kind of filament in their local space with parallel rays,
+	// which look along -direction. Used to bake impostors, needs a build() but no instances.
+	// * float halfSize - half the side of the image, the rays start 2 * halfSize in front of the center
+	// * std::vector<glm::vec4> planes - local planes, only the surfaces in front of all of them are hit
+	// * LocalSample* samples - size * size samples, rows run along up
+	void traceLocal(int filamentBinding, glm::vec3 center, glm::vec3 direction, glm::vec3 right, glm::vec3 up, float halfSize,
+		const std::vector<glm::vec4>& planes, int size, LocalSample* samples) const;
+	int getNumInstances();
+	int getNumPrimitives();
+	size_t getMemoryUsage();
+private:
+	struct Template
+	{
+		std::vector<RayCapsule> capsules;
+		std::vector<BVHNode> nodes;
+		glm::vec3 color;
+		CullGroup group;
+		int filamentBinding;
+	};
+	//orthonormal transform of a filament, rays are moved into the template space by the transpose
+	struct Instance
+	{
+		glm::mat3 rotation;
+		glm::vec3 translation;
+		int templateIndex;
+	};
+	//four rays in structure of arrays layout, lanes with active = 0 are skipped
+	struct alignas(16) RayPacket
+	{
+		float origin[3][4];
+		float direction[3][4];
+		float inverseDirection[3][4];
+		float tMax[4];
+		int32_t active[4];
+	};
+	struct PacketHit
+	{
+		int instance[4];
+		int capsule[4];
+	};
+	int addTemplate(std::vector<RayCapsule>& capsules, glm::vec3 color, CullGroup group, int filamentBinding);
+	void addInstances(int templateIndex, const std::vector<glm::vec4>& offsets, int numFilaments, int secondHalfStart, int filamentBinding);
+	// Builds a bvh over the boxes, indices returns the order in which the leaves reference them
+	static void buildBVH(std::vector<BVHNode>& nodes, std::vector<int>& indices, const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax, int leafSize);
+	// Finds the closest hits of the active lanes, or only whether anything is hit if anyHit is set,
+	// which deactivates the lanes that hit
+	void trace(RayPacket& packet, PacketHit& hit, bool anyHit) const;
+	// Traces the template of the instance, hits are recorded with instanceIndex
+	// * std::vector<glm::vec4> clipPlanes - planes in the space of the packet
+	void traceInstance(RayPacket& packet, PacketHit& hit, const Instance& instance, int instanceIndex, const std::vector<glm::vec4>& clipPlanes, bool anyHit) const;
+	static bool isClipped(glm::vec3 position, const std::vector<glm::vec4>& clipPlanes);
+	glm::vec3 getNormal(const Instance& instance, int capsuleIndex, glm::vec3 position) const;
+	std::array<CullGroupDescription, static_cast<int>(CullGroup::COUNT)> m_groups;
+	glm::mat4 m_rotationMatrix = glm::mat4(1.0f);
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	std::vector<glm::vec4> m_clipPlanes;
+	const LatticeTiles* m_tiles = nullptr;
+	std::vector<Template> m_templates;
+	std::vector<Instance> m_instances;
+	std::vector<BVHNode> m_nodes;
+	float m_d10 = 1.0f;
+};
@@ -89,6 +89,11 @@ GLuint RenderCone::getVAO()
 	return m_vao;
 }
 
+int RenderCone::getNumIndices()
+{
+	return m_indices;
+}
+
 std::vector<glm::vec4> RenderCone::getVertices()
 {
 	return m_vertices;
@@ -116,19 +121,28 @@ void RenderCone::create()
 
 	// create index list
 	auto id_res = 2 * m_resolution;
-	//triangulate side
+	//triangulate side, every second triangle of the strip is flipped so all faces wind counter clockwise seen from outside
+	//consistent winding lets the shaders tell the inside of a clipped cone apart through gl_FrontFacing
 	for (int i = 0; i <= id_res; i++)
 	{
 		m_index.push_back(i % id_res);
-		m_index.push_back((i + 1) % id_res);
-		m_index.push_back((i + 2) % id_res);
+		if (i % 2 == 0)
+		{
+			m_index.push_back((i + 2) % id_res);
+			m_index.push_back((i + 1) % id_res);
+		}
+		else
+		{
+			m_index.push_back((i + 1) % id_res);
+			m_index.push_back((i + 2) % id_res);
+		}
 	}
 	//triangulate bottom
 	for (int i = 1; i <= m_resolution - 1; i++)
 	{
 		m_index.push_back(0);
+		m_index.push_back((i * 2 + 2) % id_res);
 		m_index.push_back(i * 2);
-		m_index.push_back(i * 2 + 2);
 	}
 	//triangulate top
 	for (int i = 1; i < m_resolution - 1; i++)
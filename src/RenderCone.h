@@ -15,6 +15,7 @@ public:
 	void render();
 	GLuint getVertexBuffer();
 	GLuint getVAO();
+	int getNumIndices();
 	std::vector<glm::vec4> getVertices();
 	std::vector<glm::vec3> getnormals();
 protected:
@@ -0,0 +1,146 @@
+#include "RibbonCache.h"
+#include <algorithm>
+#include <iostream>
+
+RibbonCache::RibbonCache()
+{
+	//the helix vertex shaders write the cache themselves, the HMM shader then reads seven storage blocks
+	GLint maxVertexBlocks = 0;
+	glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &maxVertexBlocks);
+	if (maxVertexBlocks < 7)
+	{
+		m_supported = false;
+		std::cout << "FAIL: not enough vertex shader storage blocks, the helices are expanded every frame" << std::endl;
+	}
+	m_offsets.fill(-1);
+	m_cached.fill(false);
+	m_stored.fill(false);
+}
+
+RibbonCache::~RibbonCache()
+{
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void RibbonCache::setSlot(RibbonSlot slot, const CullGroupDescription& description)
+{
+	CullGroupDescription& current = m_slots[static_cast<int>(slot)];
+	if (current != description)
+	{
+		current = description;
+		m_layoutChanged = true;
+	}
+}
+
+void RibbonCache::update(const RibbonCacheSettings& settings)
+{
+	if (settings.enabled != m_settings.enabled || settings.budgetMB != m_settings.budgetMB)
+	{
+		m_settings = settings;
+		m_layoutChanged = true;
+	}
+	if (m_layoutChanged)
+	{
+		layoutBuffer();
+	}
+}
+
+void RibbonCache::setCullGeneration(int generation)
+{
+	if (generation != m_cullGeneration)
+	{
+		m_cullGeneration = generation;
+		invalidate();
+	}
+}
+
+void RibbonCache::bind(RibbonSlot slot, ShaderProgram& shader)
+{
+	int i = static_cast<int>(slot);
+	int mode = EXPAND;
+	if (m_offsets[i] >= 0)
+	{
+		//the points are only read back in a later frame, after the barrier of endFrame()
+		mode = m_cached[i] ? LOAD : STORE;
+		m_stored[i] = m_stored[i] || !m_cached[i];
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 25, m_buffer);
+	}
+	shader.updateUniform("cacheMode", mode);
+	shader.updateUniform("cacheOffset", std::max(m_offsets[i], 0));
+}
+
+void RibbonCache::endFrame()
+{
+	bool stored = false;
+	for (int i = 0; i < NUM_SLOTS; i++)
+	{
+		stored = stored || m_stored[i];
+		m_cached[i] = m_cached[i] || m_stored[i];
+		m_stored[i] = false;
+	}
+	if (stored)
+	{
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+}
+
+void RibbonCache::invalidate()
+{
+	m_cached.fill(false);
+	m_stored.fill(false);
+}
+
+bool RibbonCache::isCached(RibbonSlot slot)
+{
+	return m_cached[static_cast<int>(slot)];
+}
+
+bool RibbonCache::isOverBudget(RibbonSlot slot)
+{
+	int i = static_cast<int>(slot);
+	return m_settings.enabled && m_supported && m_slots[i].enabled && m_offsets[i] < 0;
+}
+
+GLsizeiptr RibbonCache::getMemoryUsage()
+{
+	return m_usedSize;
+}
+
+void RibbonCache::layoutBuffer()
+{
+	//the slots are cached in order as long as they fit, a slot is never split between both paths
+	GLsizeiptr budget = static_cast<GLsizeiptr>(m_settings.budgetMB) * 1024 * 1024;
+	GLsizeiptr numVertices = 0;
+	for (int i = 0; i < NUM_SLOTS; i++)
+	{
+		const CullGroupDescription& slot = m_slots[i];
+		GLsizeiptr slotVertices = static_cast<GLsizeiptr>(slot.numFilaments) * slot.numElements * slot.vertexCount;
+		m_offsets[i] = -1;
+		if (!m_settings.enabled || !m_supported || !slot.enabled || slotVertices < 1)
+		{
+			continue;
+		}
+		if ((numVertices + slotVertices) * static_cast<GLsizeiptr>(sizeof(glm::vec4)) <= budget)
+		{
+			m_offsets[i] = static_cast<int>(numVertices);
+			numVertices += slotVertices;
+		}
+	}
+	m_usedSize = numVertices * sizeof(glm::vec4);
+	if (m_usedSize > m_bufferSize)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		glCreateBuffers(1, &m_buffer);
+		glNamedBufferStorage(m_buffer, m_usedSize, nullptr, 0);
+		m_bufferSize = m_usedSize;
+	}
+	//release the cache if nothing is cached anymore
+	if (m_usedSize == 0 && m_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		m_bufferSize = 0;
+	}
+	m_layoutChanged = false;
+	invalidate();
+}
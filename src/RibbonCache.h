@@ -0,0 +1,78 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include "InstanceCuller.h"
+#include "shaderProgram.h"
+
+//parameters of the ribbon cache window
+struct RibbonCacheSettings
+{
+	bool enabled = true;
+	//the helices that do not fit anymore are expanded every frame
+	int budgetMB = 256;
+};
+
+//helix draws whose expanded vertices are cached, each LMM and HMM helix is drawn twice with different curves
+enum class RibbonSlot
+{
+	LMM_FIRST = 0,
+	LMM_SECOND = 1,
+	HMM_FIRST = 2,
+	HMM_SECOND = 3,
+	TROPOMYOSIN = 4,
+	COUNT = 5
+};
+
+// Caches the expanded helix vertices of the LMM, HMM and tropomyosin ribbons between culling passes.
+// The vertex shaders place every point of every helix piece in world space, which costs a few matrix
+// products and the HMM tilt per vertex and frame. The first draw after a culling pass stores the world
+// space points of the visible instances into an ssbo (binding 25), indexed by instance and vertex,
+// and the following draws read them back until the culler runs again. The camera facing ribbons
+// are still extruded by the geometry shaders, they depend on the view.
+// Every slot that does not fit into the memory budget anymore falls back to the expansion per frame.
+class RibbonCache
+{
+public:
+	RibbonCache();
+	~RibbonCache();
+	// Sets the instances of a helix draw, uses the same descriptions as the culler
+	void setSlot(RibbonSlot slot, const CullGroupDescription& description);
+	// Lays out the cache if the slots or the budget changed
+	void update(const RibbonCacheSettings& settings);
+	// Drops the cached points if the visible instances of the culler changed since they were stored
+	void setCullGeneration(int generation);
+	// Binds the cache and sets the uniforms of the helix shader for the next draw of a slot
+	void bind(RibbonSlot slot, ShaderProgram& shader);
+	// Marks the slots stored this frame as cached, call after the last draw of the frame
+	void endFrame();
+	// Drops all cached points
+	void invalidate();
+	bool isCached(RibbonSlot slot);
+	// Returns true if the slot is enabled but does not fit into the budget
+	bool isOverBudget(RibbonSlot slot);
+	GLsizeiptr getMemoryUsage();
+private:
+	static constexpr int NUM_SLOTS = static_cast<int>(RibbonSlot::COUNT);
+	//the mode uniform of the helix vertex shaders
+	enum CacheMode
+	{
+		EXPAND = 0,
+		STORE = 1,
+		LOAD = 2
+	};
+	void layoutBuffer();
+	std::array<CullGroupDescription, NUM_SLOTS> m_slots;
+	//first vertex of every slot in the cache, -1 if the slot is expanded every frame
+	std::array<int, NUM_SLOTS> m_offsets;
+	std::array<bool, NUM_SLOTS> m_cached;
+	std::array<bool, NUM_SLOTS> m_stored;
+	RibbonCacheSettings m_settings;
+	bool m_supported = true;
+	GLuint m_buffer = 0;
+	GLsizeiptr m_bufferSize = 0;
+	GLsizeiptr m_usedSize = 0;
+	int m_cullGeneration = -1;
+	bool m_layoutChanged = true;
+};
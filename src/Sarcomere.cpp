@@ -4,6 +4,24 @@
 #include <filesystem>
 #include <cmath>
 
+//packs the rotations of one HMM part as cos and sin of the angle around the rod (y axis) and of the tilt away from the rod (-z axis)
+static glm::vec4 packHMMRotation(float yAngle, float tiltAngle)
+{
+	return glm::vec4(glm::cos(yAngle), glm::sin(yAngle), glm::cos(tiltAngle), glm::sin(tiltAngle));
+}
+
+//tilts a point away from the rod, same as HMMHelix.vert
+static glm::vec4 tiltHMM(glm::vec4 rotation, glm::vec4 p)
+{
+	return glm::vec4(rotation.z * p.x + rotation.w * p.y, -rotation.w * p.x + rotation.z * p.y, p.z, p.w);
+}
+
+//turns a point around the rod, same as HMMHelix.vert
+static glm::vec4 turnHMM(glm::vec4 rotation, glm::vec4 p)
+{
+	return glm::vec4(rotation.x * p.x + rotation.y * p.z, p.y, -rotation.y * p.x + rotation.x * p.z, p.w);
+}
+
 Sarcomere::Sarcomere(SarcomereType type, float d10_in, float actinLength_in, int numMyosinRods, glm::vec4 sarcomereMidPoint_in)
 {
 	m_numMyosinRods = numMyosinRods;
@@ -114,6 +132,16 @@ std::vector<glm::vec4> Sarcomere::getMyosinRods()
 	return m_myosinRods;
 }
 
+glm::vec4 Sarcomere::getActinRod(int index)
+{
+	return m_actinRods.at(index);
+}
+
+glm::vec4 Sarcomere::getMyosinRod(int index)
+{
+	return m_myosinRods.at(index);
+}
+
 int Sarcomere::getNumActin()
 {
 	return static_cast<int>(m_actinRods.size());
@@ -158,6 +186,58 @@ int Sarcomere::getNumHMMOffsetPositionsPerRod()
 {
 	return m_HMMOffsetPositions.size();
 }
+
+float Sarcomere::getLMMBoundingRadius()
+{
+	//the helix pieces are only rotated around their origin, so the farthest point bounds every orientation
+	float radius = 0.0f;
+	for (const glm::vec4& position : m_LMMPositions1)
+	{
+		radius = glm::max(radius, glm::length(glm::vec3(position)));
+	}
+	for (const glm::vec4& position : m_LMMPositions2)
+	{
+		radius = glm::max(radius, glm::length(glm::vec3(position)));
+	}
+	return radius;
+}
+
+float Sarcomere::getHMMBoundingRadius()
+{
+	float radius = 0.0f;
+	for (const glm::vec4& position : m_HMMPositions1)
+	{
+		radius = glm::max(radius, glm::length(glm::vec3(position)));
+	}
+	for (const glm::vec4& position : m_HMMPositions2)
+	{
+		radius = glm::max(radius, glm::length(glm::vec3(position)));
+	}
+	return radius;
+}
+
+void Sarcomere::getTropomyosinBounds(glm::vec3& axisStart, glm::vec3& axisEnd, float& radius)
+{
+	axisStart = glm::vec3(0.0f);
+	axisEnd = glm::vec3(0.0f);
+	radius = 0.0f;
+	if (m_tropomyosinPositions.size() < 3)
+	{
+		return;
+	}
+	//the adjacency points only give the tangents, the strand winds around the y axis between the others
+	float minY = m_tropomyosinPositions[1].y;
+	float maxY = minY;
+	for (size_t i = 1; i + 1 < m_tropomyosinPositions.size(); i++)
+	{
+		const glm::vec4& position = m_tropomyosinPositions[i];
+		minY = glm::min(minY, position.y);
+		maxY = glm::max(maxY, position.y);
+		radius = glm::max(radius, glm::length(glm::vec2(position.x, position.z)));
+	}
+	axisStart = glm::vec3(0.0f, minY, 0.0f);
+	axisEnd = glm::vec3(0.0f, maxY, 0.0f);
+}
 glm::vec3 Sarcomere::getActinColor()
 {
 	return m_actinColor;
@@ -224,9 +304,54 @@ float Sarcomere::getRadius()
 	;
 }
 
+const std::vector<glm::vec4>& Sarcomere::getTroponinPositions()
+{
+	return m_troponinPositions;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getTropomyosinPositions()
+{
+	return m_tropomyosinPositions;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getLMMPositions(int helix)
+{
+	return helix == 0 ? m_LMMPositions1 : m_LMMPositions2;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getHMMPositions(int helix)
+{
+	return helix == 0 ? m_HMMPositions1 : m_HMMPositions2;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getLMMOffsetPositions()
+{
+	return m_LMMOffsetPositions;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getHMMOffsetPositions()
+{
+	return m_HMMOffsetPositions;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getHMMRotations()
+{
+	return m_HMMRotations;
+}
+
+const std::vector<glm::vec4>& Sarcomere::getMyosinHeadOffsetPositions()
+{
+	return m_myosinHeadOffsetPositions;
+}
+
 int Sarcomere::getNumLineSegments()
 {
-	return static_cast<int>(m_lineRotMatricees.size());
+	return m_numLineSegments;
+}
+
+int Sarcomere::getNumPointsPerTropomyosinStrand()
+{
+	return static_cast<int>(m_tropomyosinPositions.size());
 }
 
 glm::vec4 Sarcomere::getMidPoint()
@@ -976,6 +1101,15 @@ void Sarcomere::genActinRods(SarcomereType type, glm::vec4 sarcomereMidPoint, fl
 	m_actinRods = aRods;
 }
 
+Sarcomere::~Sarcomere()
+{
+	GLuint buffers[] = { m_zDisc_ssbo, m_mRod_ssbo, m_aRod_ssbo, m_aSphere_ssbo, m_troponin_ssbo, m_LMMOffsetPositions_ssbo,
+		m_HMMOffsetPositions_ssbo, m_HMMRotations_ssbo, m_myosinHeadOffsetPositions_ssbo, m_linebuffer, m_LMM1buffer, m_LMM2buffer, m_HMM1buffer, m_HMM2buffer };
+	GLuint vertexArrays[] = { m_vao, m_vao2, m_vao3, m_vao4, m_vao5 };
+	glDeleteBuffers(sizeof(buffers) / sizeof(GLuint), buffers);
+	glDeleteVertexArrays(sizeof(vertexArrays) / sizeof(GLuint), vertexArrays);
+}
+
 void Sarcomere::genBuffers()
 {
 	glCreateBuffers(1, &m_zDisc_ssbo);
@@ -997,13 +1131,10 @@ void Sarcomere::bindBuffers()
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_mRod_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_aRod_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_aSphere_ssbo);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_lineMatricees_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_troponin_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_LMMOffsetPositions_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_HMMOffsetPositions_ssbo);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_HMMyRotationMatricees_ssbo);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_HMMzRotationMatrices_ssbo);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, m_HMMyRotationMatrices2_ssbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_HMMRotations_ssbo);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, m_myosinHeadOffsetPositions_ssbo);
 }
 
@@ -1134,10 +1265,11 @@ void Sarcomere::generateDoubleHelixOffsetPositions()
 	m_actinParticlePositions.clear();
 	m_troponinPositions.clear();
 	m_tropomyosinPositions.clear();
-	m_lineRotMatricees.clear();
 
 	float helixPitch = 180.0f / (37.5f / (actinRadius * 1000.0f));
-	float linePitch = 7.0f * helixPitch - 180.0f;
+	//tropomyosin is one continuous polymer in a groove of the helix, every molecule of seven monomers continues
+	//the turn of the previous one
+	float linePitch = 7.0f * helixPitch;
 	float alphaR = glm::radians(helixPitch);
 	float alphaL = glm::radians(helixPitch); // 180 / (37.5 / 5.1)
 	float yOffset = actinRadius;//5.9f?;
@@ -1220,45 +1352,28 @@ void Sarcomere::generateDoubleHelixOffsetPositions()
 
 	//create actin monomer offset position ssbo
 	numParticles = static_cast<int>(m_actinParticlePositions.size());
+	glDeleteBuffers(1, &m_aSphere_ssbo);
 	glCreateBuffers(1, &m_aSphere_ssbo);
 	glNamedBufferStorage(m_aSphere_ssbo, sizeof(glm::vec4) * numParticles, m_actinParticlePositions.data(), GL_DYNAMIC_STORAGE_BIT);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_aSphere_ssbo);
 
-	//generate one tropomyosin linesegment. One line segment is 7 actin monomers long, so it consits of 8 actin monomer positions
-	for (int i = 0; i < 8; i++)
+	//one strand per filament half, the molecules of seven monomers each are joined head to tail, so the strand
+	//follows the helix over the whole half. The second half mirrors the strand by the second half rotation.
+	//the GL_LINE_STRIP_ADJACENCY points before and after the strand only give the tangents at its ends
+	int numMoleculesPerStrand = int(m_actinParticlePositions.size() / 2 / 7) / 2;
+	m_numLineSegments = 2 * numMoleculesPerStrand;
+	for (int i = -1; i <= 7 * numMoleculesPerStrand + 1; i++)
 	{
 		//tropomyosin rotation
 		glm::vec4 tRotVec = glm::vec4(0.0f, 0.0f, sphereRadius, 0.0f);
 		tRotVec = glm::rotate(tRotVec, i * alphaR, glm::vec3(0.0f, 1.0f, 0.0f));
-		//push back positions of tropomyosin linesegment points, offset in y direction
+		//push back positions of the tropomyosin strand, offset in y direction
 		m_tropomyosinPositions.push_back(glm::vec4(0.0f, i * yOffset - sarcomereLength / 2.0f, 0.0f, 1.0f) + tRotVec);
-		//push back first position again to properly use GL_LINE_STRIP_ADJACENCY
-		if (i == 0)
-		{
-			m_tropomyosinPositions.push_back(glm::vec4(0.0f, i * yOffset - sarcomereLength / 2.0f, 0.0f, 1.0f) + tRotVec);
-		}
-	}
-	//create matricees to rotate linesegments
-	glm::mat4 tropomyosinRotationMatrix;
-	//first half rotates clockwise
-	for (int i = 0; i < int(m_actinParticlePositions.size() / 2 / 7) / 2; i++)
-	{
-		tropomyosinRotationMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(i * linePitch), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_lineRotMatricees.push_back(tropomyosinRotationMatrix);
 	}
-	//second half rotates counter clockwise
-	for (int i = 0; i < int(m_actinParticlePositions.size() / 2 / 7) / 2; i++)
-	{
-		tropomyosinRotationMatrix = glm::rotate(glm::mat4(1.0f), -glm::radians(i * linePitch), glm::vec3(0.0f, 1.0f, 0.0f));
-		m_lineRotMatricees.push_back(tropomyosinRotationMatrix);
-	}
-	//create ssbo for tropomyosin rotation matricees
-	glCreateBuffers(1, &m_lineMatricees_ssbo);
-	glNamedBufferStorage(m_lineMatricees_ssbo, sizeof(glm::mat4) * m_lineRotMatricees.size(), m_lineRotMatricees.data(), GL_DYNAMIC_STORAGE_BIT);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_lineMatricees_ssbo);
 
 	//create troponin offset position ssbo
 	int numTroponinOffests = static_cast<int>(m_troponinPositions.size());
+	glDeleteBuffers(1, &m_troponin_ssbo);
 	glCreateBuffers(1, &m_troponin_ssbo);
 	glNamedBufferStorage(m_troponin_ssbo, sizeof(glm::vec4) * numTroponinOffests, m_troponinPositions.data(), GL_DYNAMIC_STORAGE_BIT);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_troponin_ssbo);
@@ -1473,6 +1588,7 @@ void Sarcomere::genLMMOffsetPositions()
 		angle3 += alpha;
 	}
 	//create ssbo for LMMoffsetPositions
+	glDeleteBuffers(1, &m_LMMOffsetPositions_ssbo);
 	glCreateBuffers(1, &m_LMMOffsetPositions_ssbo);
 	glNamedBufferStorage(m_LMMOffsetPositions_ssbo, sizeof(glm::vec4) * m_LMMOffsetPositions.size(), m_LMMOffsetPositions.data(), GL_DYNAMIC_STORAGE_BIT);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_LMMOffsetPositions_ssbo);
@@ -1482,9 +1598,7 @@ void Sarcomere::genLMMOffsetPositions()
 void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 {
 	m_HMMOffsetPositions.clear();
-	m_HMMyRotMats.clear();
-	m_HMMyRotMatrices2.clear();
-	m_HMMRotMatrices.clear();
+	m_HMMRotations.clear();
 	m_HMMAngles.clear();
 	//number of HMM parts per myosin half
 	int numHMMPerHalf = static_cast<int>((myosinLength / 2.0f) / m_LMMyOffset);
@@ -1499,7 +1613,6 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 	float HMMAngleFull3 = glm::asin(glm::min(((m_d11 / glm::cos(glm::radians(15.0f))) - myosinRadius / 3.0f - actinRadius) / (m_HMMLength3 + (myosinHeadRadius)), 1.0f)); // for 6to1 myosin heads fully engaged
 	//the angle each HMM part gets rotated to its next iteration
 	float alpha = 40.0f;
-	glm::mat4 rotMat;
 	//generate HMM offset positions for the first Myosin half from the middle outwards
 	for (int i = 0; i <= numHMMPerHalf - overlap; i++)
 	{
@@ -1516,11 +1629,6 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 		m_HMMOffsetPositions.push_back(glm::vec4(0.0f, -m_LMMLength - i * m_LMMyOffset + 6.0f * m_LMMRadius, 0.0f, 0.0f) + pos1Rot);
 		m_HMMOffsetPositions.push_back(glm::vec4(0.0f, -m_LMMLength - i * m_LMMyOffset + 6.0f * m_LMMRadius, 0.0f, 0.0f) + pos2Rot);
 		m_HMMOffsetPositions.push_back(glm::vec4(0.0f, -m_LMMLength - i * m_LMMyOffset + 6.0f * m_LMMRadius, 0.0f, 0.0f) + pos3Rot);
-		//fill matrix to rotate the whole HMM part to the right angle around the myosin rod in the vertex shader
-		m_HMMyRotMats.push_back(glm::rotate(glm::mat4(1.0f), glm::radians(angle1), glm::vec3(0.0f, 1.0f, 0.0f)));
-		m_HMMyRotMats.push_back(glm::rotate(glm::mat4(1.0f), glm::radians(angle2), glm::vec3(0.0f, 1.0f, 0.0f)));
-		m_HMMyRotMats.push_back(glm::rotate(glm::mat4(1.0f), glm::radians(angle3), glm::vec3(0.0f, 1.0f, 0.0f)));
-
 		if (m_type == SarcomereType::TWO_TO_ONE)
 		{
 			m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull1 - m_HMMAngle);
@@ -1528,52 +1636,35 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 			{
 			case 0:
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 40:
 				angle = scaleFactor * 20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 80:
 				angle = scaleFactor * -20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 120:
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 160:
 				angle = scaleFactor * 20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 200:
 				angle = scaleFactor * -20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 240:
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 280:
 				angle = scaleFactor * 20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 320:
 				angle = scaleFactor * -20.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			default:
 				break;
 			}
 			m_HMMRotMat = glm::rotate(glm::mat4(1.0f), m_scaledAngle, glm::vec3(0.0f, 0.0f, -1.0f));
-			//fill rotation matrix for animation
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
 		}
 		else if (m_type == SarcomereType::THREE_TO_ONE)
 		{
@@ -1582,52 +1673,35 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 			{
 			case 0:
 				angle = scaleFactor * 30.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 40:
 				angle = scaleFactor * -10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 80:
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 120:
 				angle = scaleFactor * 30.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 160:
 				angle = scaleFactor * -1.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 200:
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 240:
 				angle = scaleFactor * 30.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 280:
 				angle = scaleFactor * -10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 320:
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			default:
 				break;
 			}
 			m_HMMRotMat = glm::rotate(glm::mat4(1.0f), m_scaledAngle, glm::vec3(0.0f, 0.0f, -1.0f));
-			//fill rotation matrix for animation
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
 		}
 		if (m_type == SarcomereType::FIVE_TO_ONE)
 		{
@@ -1636,60 +1710,43 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 			case 0:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull1 - m_HMMAngle);
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 40:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * -10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 80:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 120:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull1 - m_HMMAngle);
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 160:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * -10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 200:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 240:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull1 - m_HMMAngle);
 				angle = scaleFactor * 0.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 280:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * -10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 320:
 				m_scaledAngle = m_HMMAngle + scaleFactor * (HMMAngleFull2 - m_HMMAngle);
 				angle = scaleFactor * 10.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			default:
 				break;
 			}
 			m_HMMRotMat = glm::rotate(glm::mat4(1.0f), m_scaledAngle, glm::vec3(0.0f, 0.0f, -1.0f));
-			//fill rotation matrix for animation
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
 		}
 		if (m_type == SarcomereType::SIX_TO_ONE)
 		{
@@ -1698,53 +1755,40 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 			{
 			case 0:
 				angle = scaleFactor * 15.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 40:
 				angle = scaleFactor * 5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 80:
 				angle = scaleFactor * -5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 120:
 				angle = scaleFactor * 15.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 160:
 				angle = scaleFactor * 5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 200:
 				angle = scaleFactor * -5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 240:
 				angle = scaleFactor * 15.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 280:
 				angle = scaleFactor * 5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			case 320:
 				angle = scaleFactor * -5.0f;
-				rotMat = glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
 				break;
 			default:
 				break;
 			}
 			m_HMMRotMat = glm::rotate(glm::mat4(1.0f), m_scaledAngle, glm::vec3(0.0f, 0.0f, -1.0f));
-			//fill rotation matrix for animation
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-			m_HMMRotMatrices.push_back(m_HMMRotMat);
-
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
-			m_HMMyRotMatrices2.push_back(rotMat);
 		}
+		//one packed rotation per HMM part, the angle around the rod includes the turn towards the actin filament
+		m_HMMRotations.push_back(packHMMRotation(glm::radians(angle1 + angle), m_scaledAngle));
+		m_HMMRotations.push_back(packHMMRotation(glm::radians(angle2 + angle), m_scaledAngle));
+		m_HMMRotations.push_back(packHMMRotation(glm::radians(angle3 + angle), m_scaledAngle));
 		//increment each angle
 		angle1 += alpha;
 		angle2 += alpha;
@@ -1776,24 +1820,16 @@ void Sarcomere::genHMMOffsetPositions(float scaleFactor)
 		angle3 += alpha;
 	}
 	//create ssbo for LMMoffsetPositions
+	glDeleteBuffers(1, &m_HMMOffsetPositions_ssbo);
 	glCreateBuffers(1, &m_HMMOffsetPositions_ssbo);
 	glNamedBufferStorage(m_HMMOffsetPositions_ssbo, sizeof(glm::vec4) * m_HMMOffsetPositions.size(), m_HMMOffsetPositions.data(), GL_DYNAMIC_STORAGE_BIT);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_HMMOffsetPositions_ssbo);
 
-	//create ssbo for HMM y-axis rotation matricees
-	glCreateBuffers(1, &m_HMMyRotationMatricees_ssbo);
-	glNamedBufferStorage(m_HMMyRotationMatricees_ssbo, sizeof(glm::mat4) * m_HMMyRotMats.size(), m_HMMyRotMats.data(), GL_DYNAMIC_STORAGE_BIT);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_HMMyRotationMatricees_ssbo);
-
-	//create ssbo for HMM z-axis rotation matricees
-	glCreateBuffers(1, &m_HMMzRotationMatrices_ssbo);
-	glNamedBufferStorage(m_HMMzRotationMatrices_ssbo, sizeof(glm::mat4) * m_HMMRotMatrices.size(), m_HMMRotMatrices.data(), GL_DYNAMIC_STORAGE_BIT);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_HMMzRotationMatrices_ssbo);
-
-	//create ssbo for 2. HMM y-axis rotation matricees
-	glCreateBuffers(1, &m_HMMyRotationMatrices2_ssbo);
-	glNamedBufferStorage(m_HMMyRotationMatrices2_ssbo, sizeof(glm::mat4) * m_HMMyRotMatrices2.size(), m_HMMyRotMatrices2.data(), GL_DYNAMIC_STORAGE_BIT);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, m_HMMyRotationMatrices2_ssbo);
+	//create ssbo for the packed HMM rotations, 16 bytes per part instead of three matrices
+	glDeleteBuffers(1, &m_HMMRotations_ssbo);
+	glCreateBuffers(1, &m_HMMRotations_ssbo);
+	glNamedBufferStorage(m_HMMRotations_ssbo, sizeof(glm::vec4) * m_HMMRotations.size(), m_HMMRotations.data(), GL_DYNAMIC_STORAGE_BIT);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_HMMRotations_ssbo);
 }
 
 void Sarcomere::genMyosinHeads()
@@ -1811,17 +1847,11 @@ void Sarcomere::genMyosinHeads()
 		//set the second head pos to the last HMM2 position
 		headPos2 = m_HMMPositions2.back();
 
+		//both myosin halfs share the rotations of the first half
+		glm::vec4 rotation = m_HMMRotations[i % m_HMMRotations.size()];
 		//rotate both heads with an angle of "m_HMMAngle" away from the rod
-		if (i < m_HMMRotMatrices.size())
-		{
-			headPos1 = m_HMMRotMatrices[i] * headPos1;
-			headPos2 = m_HMMRotMatrices[i] * headPos2;
-		}
-		else
-		{
-			headPos1 = m_HMMRotMatrices[i - m_HMMRotMatrices.size()] * headPos1;
-			headPos2 = m_HMMRotMatrices[i - m_HMMRotMatrices.size()] * headPos2;
-		}
+		headPos1 = tiltHMM(rotation, headPos1);
+		headPos2 = tiltHMM(rotation, headPos2);
 		//headPos2 = glm::rotate(headPos2, m_scaledAngle, glm::vec3(0.0f, 0.0f, -1.0f));
 
 		//rotate the first half of head pairs 180 degrees around the x axis of the ro to let them face the right way 
@@ -1831,17 +1861,9 @@ void Sarcomere::genMyosinHeads()
 			headPos2 = glm::rotate(headPos2, glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		}
 		//rotate both heads towards the next actin filament
-		//rotate all heads with its coresponding HMM rotation matrix around the rod
-		if (i < m_HMMyRotMats.size())
-		{
-			headPos1 = m_HMMyRotMats[i] * m_HMMyRotMatrices2[i] * headPos1;
-			headPos2 = m_HMMyRotMats[i] * m_HMMyRotMatrices2[i] * headPos2;
-		}
-		else
-		{
-			headPos1 = m_HMMyRotMats[i - m_HMMyRotMats.size()] * m_HMMyRotMatrices2[i - m_HMMyRotMatrices2.size()] * headPos1;
-			headPos2 = m_HMMyRotMats[i - m_HMMyRotMats.size()] * m_HMMyRotMatrices2[i - m_HMMyRotMatrices2.size()] * headPos2;
-		}
+		//rotate all heads with its coresponding HMM rotation around the rod
+		headPos1 = turnHMM(rotation, headPos1);
+		headPos2 = turnHMM(rotation, headPos2);
 		//translate each head with the right offset along the y axis
 		headPos1 += m_HMMOffsetPositions[i];
 		headPos2 += m_HMMOffsetPositions[i];
@@ -1851,6 +1873,7 @@ void Sarcomere::genMyosinHeads()
 	}
 
 	//create ssbo for myosinHeadoffsetPositions
+	glDeleteBuffers(1, &m_myosinHeadOffsetPositions_ssbo);
 	glCreateBuffers(1, &m_myosinHeadOffsetPositions_ssbo);
 	glNamedBufferStorage(m_myosinHeadOffsetPositions_ssbo, sizeof(glm::vec4) * m_myosinHeadOffsetPositions.size(), m_myosinHeadOffsetPositions.data(), GL_DYNAMIC_STORAGE_BIT);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, m_myosinHeadOffsetPositions_ssbo);
@@ -1858,6 +1881,9 @@ void Sarcomere::genMyosinHeads()
 
 void Sarcomere::genTropomyosinBuffer()
 {
+	//the structures are regenerated on every parameter change, release the previous ones
+	glDeleteBuffers(1, &m_linebuffer);
+	glDeleteVertexArrays(1, &m_vao);
 	glGenBuffers(1, &m_linebuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_linebuffer);
 	glBufferData(GL_ARRAY_BUFFER, m_tropomyosinPositions.size() * sizeof(glm::vec4), m_tropomyosinPositions.data(), GL_STATIC_DRAW);
@@ -1877,6 +1903,9 @@ void Sarcomere::bindTropomyosinBuffer()
 
 void Sarcomere::genLMM1Buffer()
 {
+	//the structures are regenerated on every parameter change, release the previous ones
+	glDeleteBuffers(1, &m_LMM1buffer);
+	glDeleteVertexArrays(1, &m_vao2);
 	glGenBuffers(1, &m_LMM1buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_LMM1buffer);
 	glBufferData(GL_ARRAY_BUFFER, m_LMMPositions1.size() * sizeof(glm::vec4), m_LMMPositions1.data(), GL_STATIC_DRAW);
@@ -1891,6 +1920,9 @@ void Sarcomere::genLMM1Buffer()
 
 void Sarcomere::genLMM2Buffer()
 {
+	//the structures are regenerated on every parameter change, release the previous ones
+	glDeleteBuffers(1, &m_LMM2buffer);
+	glDeleteVertexArrays(1, &m_vao3);
 	glGenBuffers(1, &m_LMM2buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_LMM2buffer);
 	glBufferData(GL_ARRAY_BUFFER, m_LMMPositions2.size() * sizeof(glm::vec4), m_LMMPositions2.data(), GL_STATIC_DRAW);
@@ -1905,6 +1937,9 @@ void Sarcomere::genLMM2Buffer()
 
 void Sarcomere::genHMM1Buffer()
 {
+	//the structures are regenerated on every parameter change, release the previous ones
+	glDeleteBuffers(1, &m_HMM1buffer);
+	glDeleteVertexArrays(1, &m_vao4);
 	glGenBuffers(1, &m_HMM1buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_HMM1buffer);
 	glBufferData(GL_ARRAY_BUFFER, m_HMMPositions1.size() * sizeof(glm::vec4), m_HMMPositions1.data(), GL_STATIC_DRAW);
@@ -1919,6 +1954,9 @@ void Sarcomere::genHMM1Buffer()
 
 void Sarcomere::genHMM2Buffer()
 {
+	//the structures are regenerated on every parameter change, release the previous ones
+	glDeleteBuffers(1, &m_HMM2buffer);
+	glDeleteVertexArrays(1, &m_vao5);
 	glGenBuffers(1, &m_HMM2buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_HMM2buffer);
 	glBufferData(GL_ARRAY_BUFFER, m_HMMPositions2.size() * sizeof(glm::vec4), m_HMMPositions2.data(), GL_STATIC_DRAW);
@@ -21,9 +21,12 @@ class Sarcomere
 public:
 	Sarcomere(SarcomereType type, float d10, float actinLength, int numMyosinRods = 500, glm::vec4 sarcomereMidPoint = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 	Sarcomere(const char* filepath);
+	~Sarcomere();
 	std::vector<glm::vec4> getActinRods();
 	std::vector<glm::vec4> getActinParticles();
 	std::vector<glm::vec4> getMyosinRods();
+	glm::vec4 getActinRod(int index);
+	glm::vec4 getMyosinRod(int index);
 	int getNumActin();
 	int getNumActinParticles();
 	int getNumTroponinParticles();
@@ -35,6 +38,21 @@ public:
 	int getNumPointsPerHMMHelix();
 	int getNumLMMOffsetPositionsPerRod();
 	int getNumHMMOffsetPositionsPerRod();
+	//radius around the origin of one LMM or HMM helix piece that bounds all of its rotations
+	float getLMMBoundingRadius();
+	float getHMMBoundingRadius();
+	//capsule around the axis of the first half tropomyosin strand that bounds its points
+	void getTropomyosinBounds(glm::vec3& axisStart, glm::vec3& axisEnd, float& radius);
+	//cpu copies of the detail structures, read by the ray tracer without copying them
+	const std::vector<glm::vec4>& getTroponinPositions();
+	const std::vector<glm::vec4>& getTropomyosinPositions();
+	//helix = 0 or 1, the first or the second helix of every piece
+	const std::vector<glm::vec4>& getLMMPositions(int helix);
+	const std::vector<glm::vec4>& getHMMPositions(int helix);
+	const std::vector<glm::vec4>& getLMMOffsetPositions();
+	const std::vector<glm::vec4>& getHMMOffsetPositions();
+	const std::vector<glm::vec4>& getHMMRotations();
+	const std::vector<glm::vec4>& getMyosinHeadOffsetPositions();
 	glm::vec3 getActinColor();
 	glm::vec3 getTropomyosinColor();
 	glm::vec3 getTroponinColor();
@@ -51,7 +69,10 @@ public:
 	void setHMMColor(glm::vec3 color);
 	void setMyosinHeadColor(glm::vec3 color);
 	float getRadius();
+	//tropomyosin molecules of both halves of a filament, seven monomers long each
 	int getNumLineSegments();
+	//points of the strand of one filament half including its two adjacency points
+	int getNumPointsPerTropomyosinStrand();
 	glm::vec4 getMidPoint();
 	float getVolume();
 	SarcomereType getSarcomereType();
@@ -153,14 +174,13 @@ private:
 	std::vector<glm::vec4> m_HMMPositions1;
 	std::vector<glm::vec4> m_HMMPositions2;
 	std::vector<glm::vec4> m_myosinHeadOffsetPositions;
-	std::vector<glm::mat4> m_HMMyRotMats;
 	std::vector<glm::vec4> m_LMMOffsetPositions;
 	std::vector<glm::vec4> m_HMMOffsetPositions;
 	std::vector<glm::vec4> m_tropomyosinPositions;
 	std::vector<glm::vec4> m_troponinPositions;
-	std::vector<glm::mat4> m_lineRotMatricees;
-	std::vector<glm::mat4> m_HMMRotMatrices;
-	std::vector<glm::mat4> m_HMMyRotMatrices2;
+	int m_numLineSegments = 0;
+	//per HMM part: cos and sin of the angle around the rod, cos and sin of the tilt away from the rod
+	std::vector<glm::vec4> m_HMMRotations;
 	std::vector<float> m_HMMAngles;
 	//colors
 	glm::vec3 m_actinColor;
@@ -196,26 +216,23 @@ private:
 	bool m_invertAngle3 = false;
 	glm::mat4 m_HMMRotMat;
 	SarcomereType m_type;
-	GLuint m_zDisc_ssbo;
-	GLuint m_mRod_ssbo;
-	GLuint m_aRod_ssbo;
-	GLuint m_aSphere_ssbo;
-	GLuint m_troponin_ssbo;
-	GLuint m_lineMatricees_ssbo;
-	GLuint m_LMMOffsetPositions_ssbo;
-	GLuint m_HMMOffsetPositions_ssbo;
-	GLuint m_HMMyRotationMatricees_ssbo;
-	GLuint m_HMMyRotationMatrices2_ssbo;
-	GLuint m_HMMzRotationMatrices_ssbo;
-	GLuint m_myosinHeadOffsetPositions_ssbo;
-	GLuint m_linebuffer;
-	GLuint m_LMM1buffer;
-	GLuint m_LMM2buffer;
-	GLuint m_HMM1buffer;
-	GLuint m_HMM2buffer;
-	GLuint m_vao;
-	GLuint m_vao2;
-	GLuint m_vao3;
-	GLuint m_vao4;
-	GLuint m_vao5;
+	GLuint m_zDisc_ssbo = 0;
+	GLuint m_mRod_ssbo = 0;
+	GLuint m_aRod_ssbo = 0;
+	GLuint m_aSphere_ssbo = 0;
+	GLuint m_troponin_ssbo = 0;
+	GLuint m_LMMOffsetPositions_ssbo = 0;
+	GLuint m_HMMOffsetPositions_ssbo = 0;
+	GLuint m_HMMRotations_ssbo = 0;
+	GLuint m_myosinHeadOffsetPositions_ssbo = 0;
+	GLuint m_linebuffer = 0;
+	GLuint m_LMM1buffer = 0;
+	GLuint m_LMM2buffer = 0;
+	GLuint m_HMM1buffer = 0;
+	GLuint m_HMM2buffer = 0;
+	GLuint m_vao = 0;
+	GLuint m_vao2 = 0;
+	GLuint m_vao3 = 0;
+	GLuint m_vao4 = 0;
+	GLuint m_vao5 = 0;
 };
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "SceneFramebuffer.h"
+#include <iostream>
+
+SceneFramebuffer::SceneFramebuffer(int width, int height, int samples)
+{
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+	create();
+}
+
+SceneFramebuffer::~SceneFramebuffer()
+{
+	destroy();
+}
+
+void SceneFramebuffer::resize(int width, int height)
+{
+	if (width == m_width && height == m_height)
+	{
+		return;
+	}
+	m_width = width;
+	m_height = height;
+	destroy();
+	create();
+}
+
+void SceneFramebuffer::setSamples(int samples)
+{
+	if (samples == m_samples)
+	{
+		return;
+	}
+	m_samples = samples;
+	destroy();
+	create();
+}
+
+void SceneFramebuffer::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glViewport(0, 0, m_width, m_height);
+}
+
+void SceneFramebuffer::clear(glm::vec4 clearColor)
+{
+	const GLuint clearID[4] = { 0, 0, 0, 0 };
+	glClearNamedFramebufferfv(m_fbo, GL_COLOR, 0, &clearColor.x);
+	glClearNamedFramebufferuiv(m_fbo, GL_COLOR, 1, clearID);
+	glClearNamedFramebufferfi(m_fbo, GL_DEPTH_STENCIL, 0, 1.0f, 0);
+}
+
+void SceneFramebuffer::resolve()
+{
+	//resolve color
+	glNamedFramebufferReadBuffer(m_fbo, GL_COLOR_ATTACHMENT0);
+	glNamedFramebufferDrawBuffer(m_resolvedFBO, GL_COLOR_ATTACHMENT0);
+	glBlitNamedFramebuffer(m_fbo, m_resolvedFBO, 0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	//resolve IDs, integer buffers can only be resolved with GL_NEAREST which picks one sample
+	glNamedFramebufferReadBuffer(m_fbo, GL_COLOR_ATTACHMENT1);
+	glNamedFramebufferDrawBuffer(m_resolvedFBO, GL_COLOR_ATTACHMENT1);
+	glBlitNamedFramebuffer(m_fbo, m_resolvedFBO, 0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	//restore default read and draw buffers
+	glNamedFramebufferReadBuffer(m_fbo, GL_COLOR_ATTACHMENT0);
+	glNamedFramebufferReadBuffer(m_resolvedFBO, GL_COLOR_ATTACHMENT0);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glNamedFramebufferDrawBuffers(m_resolvedFBO, 2, drawBuffers);
+}
+
+void SceneFramebuffer::blitToScreen(int screenWidth, int screenHeight)
+{
+	glNamedFramebufferReadBuffer(m_resolvedFBO, GL_COLOR_ATTACHMENT0);
+	glBlitNamedFramebuffer(m_resolvedFBO, 0, 0, 0, m_width, m_height, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, screenWidth, screenHeight);
+}
+
+GLuint SceneFramebuffer::getResolvedFBO()
+{
+	return m_resolvedFBO;
+}
+
+GLuint SceneFramebuffer::getColorTexture()
+{
+	return m_colorTexture;
+}
+
+GLuint SceneFramebuffer::getIDTexture()
+{
+	return m_idTexture;
+}
+
+GLuint SceneFramebuffer::getDepthTexture()
+{
+	return m_depthTexture;
+}
+
+int SceneFramebuffer::getWidth()
+{
+	return m_width;
+}
+
+int SceneFramebuffer::getHeight()
+{
+	return m_height;
+}
+
+int SceneFramebuffer::getSamples()
+{
+	return m_samples;
+}
+
+void SceneFramebuffer::create()
+{
+	//multisampled render target
+	glCreateRenderbuffers(1, &m_colorBuffer);
+	glNamedRenderbufferStorageMultisample(m_colorBuffer, m_samples, GL_RGBA8, m_width, m_height);
+	glCreateRenderbuffers(1, &m_idBuffer);
+	glNamedRenderbufferStorageMultisample(m_idBuffer, m_samples, GL_RG32UI, m_width, m_height);
+	glCreateRenderbuffers(1, &m_depthBuffer);
+	glNamedRenderbufferStorageMultisample(m_depthBuffer, m_samples, GL_DEPTH32F_STENCIL8, m_width, m_height);
+
+	glCreateFramebuffers(1, &m_fbo);
+	glNamedFramebufferRenderbuffer(m_fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glNamedFramebufferRenderbuffer(m_fbo, GL_COLOR_ATTACHMENT1, GL_RENDERBUFFER, m_idBuffer);
+	glNamedFramebufferRenderbuffer(m_fbo, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glNamedFramebufferDrawBuffers(m_fbo, 2, drawBuffers);
+
+	//single sampled resolve target
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_colorTexture);
+	glTextureStorage2D(m_colorTexture, 1, GL_RGBA8, m_width, m_height);
+	glTextureParameteri(m_colorTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(m_colorTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(m_colorTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(m_colorTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_idTexture);
+	glTextureStorage2D(m_idTexture, 1, GL_RG32UI, m_width, m_height);
+	glTextureParameteri(m_idTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_idTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	//the depth blit of the resolve needs the same format on both sides
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH32F_STENCIL8, m_width, m_height);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glCreateFramebuffers(1, &m_resolvedFBO);
+	glNamedFramebufferTexture(m_resolvedFBO, GL_COLOR_ATTACHMENT0, m_colorTexture, 0);
+	glNamedFramebufferTexture(m_resolvedFBO, GL_COLOR_ATTACHMENT1, m_idTexture, 0);
+	glNamedFramebufferTexture(m_resolvedFBO, GL_DEPTH_STENCIL_ATTACHMENT, m_depthTexture, 0);
+	glNamedFramebufferDrawBuffers(m_resolvedFBO, 2, drawBuffers);
+
+	if (glCheckNamedFramebufferStatus(m_fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE ||
+		glCheckNamedFramebufferStatus(m_resolvedFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "FAIL: Scene framebuffer is incomplete." << std::endl;
+	}
+}
+
+void SceneFramebuffer::destroy()
+{
+	glDeleteFramebuffers(1, &m_fbo);
+	glDeleteFramebuffers(1, &m_resolvedFBO);
+	glDeleteRenderbuffers(1, &m_colorBuffer);
+	glDeleteRenderbuffers(1, &m_idBuffer);
+	glDeleteRenderbuffers(1, &m_depthBuffer);
+	glDeleteTextures(1, &m_colorTexture);
+	glDeleteTextures(1, &m_idTexture);
+	glDeleteTextures(1, &m_depthTexture);
+}
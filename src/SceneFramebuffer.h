@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Offscreen target the sarcomere is rendered into.
+// * attachment 0 - shaded color
+// * attachment 1 - structure ID (RG32UI, see Picker.h for the encoding)
+// * depth stencil - the stencil counts fragments for the overdraw heatmap (see OverdrawMeter.h)
+// The multisampled buffers are resolved into single sampled textures, which are used for
+// picking readback and the final blit to the window.
+class SceneFramebuffer
+{
+public:
+	SceneFramebuffer(int width, int height, int samples = 4);
+	~SceneFramebuffer();
+	void resize(int width, int height);
+	void setSamples(int samples);
+	void bind();
+	void clear(glm::vec4 clearColor = glm::vec4(1.0f));
+	void resolve();
+	void blitToScreen(int screenWidth, int screenHeight);
+	GLuint getResolvedFBO();
+	GLuint getColorTexture();
+	GLuint getIDTexture();
+	GLuint getDepthTexture();
+	int getWidth();
+	int getHeight();
+	int getSamples();
+private:
+	void create();
+	void destroy();
+	GLuint m_fbo;
+	GLuint m_colorBuffer;
+	GLuint m_idBuffer;
+	GLuint m_depthBuffer;
+	GLuint m_resolvedFBO;
+	GLuint m_colorTexture;
+	GLuint m_idTexture;
+	GLuint m_depthTexture;
+	int m_width;
+	int m_height;
+	int m_samples;
+};
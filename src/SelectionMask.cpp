@@ -0,0 +1,246 @@
+#include "SelectionMask.h"
+#include <algorithm>
+
+bool SelectionSettings::operator==(const SelectionSettings& other) const
+{
+	return mode == other.mode &&
+		structures == other.structures &&
+		half == other.half &&
+		useRadius == other.useRadius &&
+		radius == other.radius &&
+		useRings == other.useRings &&
+		ringMin == other.ringMin &&
+		ringMax == other.ringMax &&
+		usePicked == other.usePicked &&
+		pickedRadius == other.pickedRadius &&
+		useFilamentIDs == other.useFilamentIDs &&
+		filamentIDs == other.filamentIDs;
+}
+
+bool SelectionSettings::operator!=(const SelectionSettings& other) const
+{
+	return !(*this == other);
+}
+
+SelectionMask::SelectionMask() : m_selectShader(SHADERS_PATH "/selectInstances.comp")
+{
+	m_offsets.fill(-1);
+}
+
+SelectionMask::~SelectionMask()
+{
+	glDeleteBuffers(1, &m_buffer);
+	glDeleteBuffers(1, &m_idBuffer);
+}
+
+void SelectionMask::setGroup(CullGroup group, const CullGroupDescription& description)
+{
+	CullGroupDescription& current = m_groups[static_cast<int>(group)];
+	if (current != description)
+	{
+		current = description;
+		m_layoutChanged = true;
+	}
+}
+
+void SelectionMask::setSlots(CullGroup group, const std::vector<CullGroup>& structures)
+{
+	std::vector<CullGroup>& current = m_slots[static_cast<int>(group)];
+	if (current != structures)
+	{
+		if (current.size() != structures.size())
+		{
+			m_layoutChanged = true;
+		}
+		current = structures;
+		invalidate();
+	}
+}
+
+void SelectionMask::setLattice(glm::mat4 secondHalfRotationMatrix, glm::vec3 latticeCenter, float latticeSpacing)
+{
+	if (secondHalfRotationMatrix != m_secondHalfRotationMatrix || latticeCenter != m_latticeCenter || latticeSpacing != m_latticeSpacing)
+	{
+		m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+		m_latticeCenter = latticeCenter;
+		m_latticeSpacing = latticeSpacing;
+		invalidate();
+	}
+}
+
+void SelectionMask::setPicked(bool valid, glm::vec3 position)
+{
+	if (valid != m_pickedValid || position != m_pickedPosition)
+	{
+		m_pickedValid = valid;
+		m_pickedPosition = position;
+		if (m_settings.usePicked)
+		{
+			invalidate();
+		}
+	}
+}
+
+void SelectionMask::invalidate()
+{
+	m_dirty = true;
+}
+
+bool SelectionMask::update(const SelectionSettings& settings)
+{
+	if (settings != m_settings)
+	{
+		//switching the selection off only has to reset the offsets of the culler
+		bool wasOff = m_settings.mode == SelectionSettings::OFF;
+		m_settings = settings;
+		if (m_settings.mode == SelectionSettings::OFF)
+		{
+			return !wasOff;
+		}
+		invalidate();
+	}
+	if (m_settings.mode == SelectionSettings::OFF)
+	{
+		return false;
+	}
+	if (m_layoutChanged)
+	{
+		layoutBuffer();
+	}
+	if (!m_dirty)
+	{
+		return false;
+	}
+	m_dirty = false;
+	evaluate();
+	return true;
+}
+
+GLuint SelectionMask::getBuffer()
+{
+	return m_buffer;
+}
+
+int SelectionMask::getOffset(CullGroup group)
+{
+	if (m_settings.mode == SelectionSettings::OFF || m_layoutChanged)
+	{
+		return -1;
+	}
+	return m_offsets[static_cast<int>(group)];
+}
+
+int SelectionMask::getNumSlots(CullGroup group)
+{
+	return std::max(static_cast<int>(m_slots[static_cast<int>(group)].size()), 1);
+}
+
+void SelectionMask::bind()
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 21, m_buffer);
+}
+
+void SelectionMask::layoutBuffer()
+{
+	//one range of whole words per enabled group, so no word is shared by two groups
+	int numWords = 0;
+	for (int i = 0; i < NUM_GROUPS; i++)
+	{
+		int groupBits = m_groups[i].enabled ? m_groups[i].numFilaments * m_groups[i].numElements * getNumSlots(static_cast<CullGroup>(i)) : 0;
+		m_offsets[i] = groupBits > 0 ? numWords * 32 : -1;
+		numWords += (groupBits + 31) / 32;
+	}
+	m_numWords = numWords;
+	if (numWords > m_bufferWords)
+	{
+		glDeleteBuffers(1, &m_buffer);
+		glCreateBuffers(1, &m_buffer);
+		glNamedBufferStorage(m_buffer, static_cast<GLsizeiptr>(numWords) * sizeof(GLuint), nullptr, 0);
+		m_bufferWords = numWords;
+	}
+	m_layoutChanged = false;
+	m_dirty = true;
+}
+
+void SelectionMask::evaluate()
+{
+	if (m_numWords < 1)
+	{
+		return;
+	}
+	//the explicit filament indices are searched linearly, the list is short compared to the instances
+	std::vector<GLint> filamentIDs(m_settings.filamentIDs.begin(), m_settings.filamentIDs.end());
+	int numFilamentIDs = m_settings.useFilamentIDs ? static_cast<int>(filamentIDs.size()) : 0;
+	if (static_cast<int>(filamentIDs.size()) > m_idBufferSize)
+	{
+		glDeleteBuffers(1, &m_idBuffer);
+		glCreateBuffers(1, &m_idBuffer);
+		glNamedBufferStorage(m_idBuffer, filamentIDs.size() * sizeof(GLint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		m_idBufferSize = static_cast<int>(filamentIDs.size());
+	}
+	if (!filamentIDs.empty())
+	{
+		glNamedBufferSubData(m_idBuffer, 0, filamentIDs.size() * sizeof(GLint), filamentIDs.data());
+	}
+
+	m_selectShader.use();
+	m_selectShader.updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_selectShader.updateUniform("latticeCenter", m_latticeCenter);
+	m_selectShader.updateUniform("latticeSpacing", m_latticeSpacing);
+	m_selectShader.updateUniform("isolate", m_settings.mode == SelectionSettings::ISOLATE ? 1 : 0);
+	m_selectShader.updateUniform("half", m_settings.half);
+	m_selectShader.updateUniform("useRadius", m_settings.useRadius ? 1 : 0);
+	m_selectShader.updateUniform("radius", m_settings.radius);
+	m_selectShader.updateUniform("useRings", m_settings.useRings ? 1 : 0);
+	m_selectShader.updateUniform("ringMin", m_settings.ringMin);
+	m_selectShader.updateUniform("ringMax", m_settings.ringMax);
+	//without a picked element nothing is close to it
+	m_selectShader.updateUniform("usePicked", m_settings.usePicked ? 1 : 0);
+	m_selectShader.updateUniform("pickedPosition", m_pickedPosition);
+	m_selectShader.updateUniform("pickedRadius", m_pickedValid ? m_settings.pickedRadius : -1.0f);
+	m_selectShader.updateUniform("useFilamentIDs", m_settings.useFilamentIDs ? 1 : 0);
+	m_selectShader.updateUniform("numFilamentIDs", numFilamentIDs);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 21, m_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 22, m_idBuffer ? m_idBuffer : m_buffer);
+	for (int i = 0; i < NUM_GROUPS; i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		if (m_offsets[i] < 0)
+		{
+			continue;
+		}
+		//the pass reads the same offset buffers as the vertex shaders, copy them to the bindings of the culler
+		GLint filamentBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+		if (group.elementBinding != 0 && group.elementBinding != 5)
+		{
+			glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.elementBinding, &elementBuffer);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, elementBuffer ? elementBuffer : filamentBuffer);
+
+		int numSlots = getNumSlots(static_cast<CullGroup>(i));
+		int numInstances = group.numFilaments * group.numElements;
+		int numWords = (numInstances * numSlots + 31) / 32;
+		int structureSelected = m_slots[i].empty() && m_settings.structures[i] ? 1 : 0;
+		for (int slot = 0; slot < static_cast<int>(m_slots[i].size()); slot++)
+		{
+			structureSelected |= m_settings.structures[static_cast<int>(m_slots[i][slot])] ? 1 << slot : 0;
+		}
+		m_selectShader.updateUniform("structureSelected", structureSelected);
+		m_selectShader.updateUniform("numSlots", numSlots);
+		m_selectShader.updateUniform("numInstances", numInstances);
+		m_selectShader.updateUniform("wordOffset", m_offsets[i] / 32);
+		m_selectShader.updateUniform("numElements", group.numElements);
+		m_selectShader.updateUniform("elementBinding", group.elementBinding);
+		m_selectShader.updateUniform("elementSpacing", group.elementSpacing);
+		m_selectShader.updateUniform("axisCenter", (group.axisStart + group.axisEnd) * 0.5f);
+		m_selectShader.updateUniform("secondHalfStart", group.secondHalfStart);
+		int numGroups = (numWords + 63) / 64;
+		int numGroupsX = std::min(numGroups, 65535);
+		int numGroupsY = (numGroups + numGroupsX - 1) / numGroupsX;
+		glDispatchCompute(numGroupsX, numGroupsY, 1);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include "InstanceCuller.h"
+#include "shaderProgram.h"
+
+//parameters of the selection window
+struct SelectionSettings
+{
+	enum Mode
+	{
+		OFF = 0,
+		//only the selected instances stay visible
+		ISOLATE = 1,
+		//the selected instances are hidden
+		HIDE = 2
+	};
+	enum Half
+	{
+		BOTH_HALVES = 0,
+		//the half below the M-line, the filaments which are not rotated by the second half rotation
+		FIRST_HALF = 1,
+		SECOND_HALF = 2
+	};
+	int mode = OFF;
+	//an instance is selected if it passes every enabled predicate, the structures are indexed by CullGroup
+	std::array<bool, static_cast<int>(CullGroup::COUNT)> structures = { true, true, true, true, true, true, true, true, true, true };
+	int half = BOTH_HALVES;
+	//distance from the axis of the lattice in d10
+	bool useRadius = false;
+	float radius = 3.0f;
+	//hexagonal rings of the myosin lattice, 0 is the central myosin filament
+	bool useRings = false;
+	int ringMin = 0;
+	int ringMax = 1;
+	//distance from the axis through the picked element in d10
+	bool usePicked = false;
+	float pickedRadius = 1.5f;
+	//filament indices within each structure
+	bool useFilamentIDs = false;
+	std::vector<int> filamentIDs;
+
+	bool operator==(const SelectionSettings& other) const;
+	bool operator!=(const SelectionSettings& other) const;
+};
+
+// Selects subsets of the instances by predicates and hides or isolates them without touching the geometry.
+// A compute pass evaluates the predicates of the settings for every instance of every structure and
+// writes one visibility bit per instance and slot into an ssbo (binding 21). Each structure owns a range of
+// 32 bit words laid out like the baked ambient occlusion. The culling pass rejects every instance whose
+// bit is cleared, so changing the selection costs one pass over the instances and one culling pass.
+class SelectionMask
+{
+public:
+	SelectionMask();
+	~SelectionMask();
+	// Sets the instances of a structure, uses the same descriptions as the culler
+	void setGroup(CullGroup group, const CullGroupDescription& description);
+	// Gives every instance of a group one bit per structure it stands for, each bit follows the selection
+	// of its structure. Used by the impostors, which carry the detail of several structures.
+	// * const std::vector<CullGroup>& structures - structures by slot, empty = the group itself
+	void setSlots(CullGroup group, const std::vector<CullGroup>& structures);
+	// * glm::vec3 latticeCenter - sarcomere space center of the lattice, the M-line runs through it
+	// * float latticeSpacing - d10 of the sarcomere, the radii of the settings are given in multiples of it
+	void setLattice(glm::mat4 secondHalfRotationMatrix, glm::vec3 latticeCenter, float latticeSpacing);
+	// Sets the element the picked predicate measures from
+	// * bool valid - false if nothing is picked, the predicate then selects nothing
+	// * glm::vec3 position - sarcomere space position of the picked element
+	void setPicked(bool valid, glm::vec3 position);
+	// Evaluates the predicates again, used when the offset buffers changed
+	void invalidate();
+	// Updates the bits if needed, expects the sarcomere ssbos to be bound
+	// Returns true if the bits changed and the instances have to be culled again
+	bool update(const SelectionSettings& settings);
+	GLuint getBuffer();
+	// Returns the index of the first bit of a group, -1 if nothing of the group is hidden by the selection
+	int getOffset(CullGroup group);
+	// Returns the bits per instance of a group, the bit of a slot is at offset + instance * slots + slot
+	int getNumSlots(CullGroup group);
+	// Binds the bits to binding 21 for the shaders that read the slots themselves
+	void bind();
+private:
+	static constexpr int NUM_GROUPS = static_cast<int>(CullGroup::COUNT);
+	void layoutBuffer();
+	void evaluate();
+	ShaderProgram m_selectShader;
+	std::array<CullGroupDescription, NUM_GROUPS> m_groups;
+	std::array<int, NUM_GROUPS> m_offsets;
+	std::array<std::vector<CullGroup>, NUM_GROUPS> m_slots;
+	SelectionSettings m_settings;
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	glm::vec3 m_latticeCenter = glm::vec3(0.0f);
+	float m_latticeSpacing = 1.0f;
+	bool m_pickedValid = false;
+	glm::vec3 m_pickedPosition = glm::vec3(0.0f);
+	GLuint m_buffer = 0;
+	GLuint m_idBuffer = 0;
+	int m_bufferWords = 0;
+	int m_idBufferSize = 0;
+	int m_numWords = 0;
+	bool m_layoutChanged = true;
+	bool m_dirty = true;
+};
@@ -0,0 +1,113 @@
+#include "ShadowMap.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+glm::vec3 ShadowSettings::getLightDirection() const
+{
+	float azimuth = glm::radians(lightAzimuth);
+	float elevation = glm::radians(lightElevation);
+	return glm::vec3(glm::cos(elevation) * glm::cos(azimuth), glm::sin(elevation), glm::cos(elevation) * glm::sin(azimuth));
+}
+
+ShadowMap::ShadowMap()
+{
+	create(ShadowSettings().resolution);
+}
+
+ShadowMap::~ShadowMap()
+{
+	glDeleteFramebuffers(1, &m_fbo);
+	glDeleteTextures(1, &m_texture);
+}
+
+void ShadowMap::invalidate()
+{
+	m_dirty = true;
+}
+
+bool ShadowMap::needsUpdate(const ShadowSettings& settings, glm::vec3 center, float radius)
+{
+	if (settings.resolution != m_resolution)
+	{
+		create(settings.resolution);
+	}
+	glm::vec3 lightDirection = settings.getLightDirection();
+	if (lightDirection != m_lightDirection || center != m_center || radius != m_radius)
+	{
+		m_lightDirection = lightDirection;
+		m_center = center;
+		m_radius = radius;
+		m_dirty = true;
+	}
+	return m_dirty;
+}
+
+TileView ShadowMap::begin()
+{
+	//the up vector must not be parallel to the light
+	glm::vec3 up = glm::abs(m_lightDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	m_lightView = glm::lookAt(m_center + m_lightDirection * m_radius, m_center, up);
+	m_lightProjection = glm::ortho(-m_radius, m_radius, -m_radius, m_radius, 0.0f, 2.0f * m_radius);
+
+	GLfloat clearDepth = 1.0f;
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glViewport(0, 0, m_resolution, m_resolution);
+	glClearNamedFramebufferfv(m_fbo, GL_DEPTH, 0, &clearDepth);
+	//slope scaled bias for the triangles, sprites and lines get the normal offset of the receivers
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+
+	TileView lightView;
+	lightView.view = m_lightView;
+	lightView.projection = m_lightProjection;
+	lightView.spriteViewport = m_resolution;
+	return lightView;
+}
+
+void ShadowMap::end()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	m_dirty = false;
+}
+
+void ShadowMap::bind(GLuint unit)
+{
+	glBindTextureUnit(unit, m_texture);
+}
+
+glm::mat4 ShadowMap::getShadowMatrix(glm::mat4 view)
+{
+	//clip space to texture coordinates and depth range
+	glm::mat4 bias = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f));
+	bias = glm::scale(bias, glm::vec3(0.5f));
+	return bias * m_lightProjection * m_lightView * glm::inverse(view);
+}
+
+float ShadowMap::getTexelSize()
+{
+	return 2.0f * m_radius / glm::max(m_resolution, 1);
+}
+
+void ShadowMap::create(int resolution)
+{
+	glDeleteFramebuffers(1, &m_fbo);
+	glDeleteTextures(1, &m_texture);
+	m_resolution = glm::max(resolution, 1);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+	glTextureStorage2D(m_texture, 1, GL_DEPTH_COMPONENT32F, m_resolution, m_resolution);
+	//linear filtering of a compared texture gives 2x2 percentage closer filtering in one lookup
+	glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(m_texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	//everything outside of the map is lit
+	const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(m_texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTextureParameterfv(m_texture, GL_TEXTURE_BORDER_COLOR, border);
+
+	glCreateFramebuffers(1, &m_fbo);
+	glNamedFramebufferTexture(m_fbo, GL_DEPTH_ATTACHMENT, m_texture, 0);
+	glNamedFramebufferDrawBuffer(m_fbo, GL_NONE);
+	glNamedFramebufferReadBuffer(m_fbo, GL_NONE);
+	m_dirty = true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "TiledRenderer.h"
+
+//parameters of the shadow window
+struct ShadowSettings
+{
+	bool enabled = true;
+	//direction towards the light in degrees, the default matches the former fixed light (1, 1, 1)
+	float lightAzimuth = 45.0f;
+	float lightElevation = 35.26f;
+	int resolution = 2048;
+	//receivers are moved along their normal by this many shadow map texels to avoid acne
+	float normalOffset = 1.5f;
+	// Returns the normalized world space direction towards the light
+	glm::vec3 getLightDirection() const;
+};
+
+// Directional shadow map of the sarcomere.
+// The light looks at the bounding sphere of the lattice with an orthographic projection, so the map
+// does not depend on the camera and is cached: it is only rendered again after invalidate() or when
+// the light or the bounds changed. The scene is drawn with the depth only variants of the structure
+// shaders, a static scene costs one hardware filtered lookup per fragment.
+class ShadowMap
+{
+public:
+	ShadowMap();
+	~ShadowMap();
+	// Marks the cached map as outdated, called when the lattice, the clipping or the structures change
+	void invalidate();
+	// Returns true if the map has to be rendered with begin() and end()
+	// * glm::vec3 center, float radius - world space bounding sphere of everything casting shadows
+	bool needsUpdate(const ShadowSettings& settings, glm::vec3 center, float radius);
+	// Binds the shadow framebuffer and returns the light camera to render the scene with
+	TileView begin();
+	void end();
+	// Binds the depth texture to the texture unit, the shaders read it as sampler2DShadow shadowMap
+	void bind(GLuint unit);
+	// Maps view space positions of a camera to shadow map coordinates and depth
+	glm::mat4 getShadowMatrix(glm::mat4 view);
+	// Returns the world space edge length of one shadow map texel
+	float getTexelSize();
+private:
+	void create(int resolution);
+	GLuint m_texture = 0;
+	GLuint m_fbo = 0;
+	int m_resolution = 0;
+	bool m_dirty = true;
+	glm::vec3 m_lightDirection = glm::vec3(0.0f);
+	glm::vec3 m_center = glm::vec3(0.0f);
+	float m_radius = 0.0f;
+	glm::mat4 m_lightView = glm::mat4(1.0f);
+	glm::mat4 m_lightProjection = glm::mat4(1.0f);
+};
@@ -0,0 +1,139 @@
+#include "SpriteSplatter.h"
+#include <algorithm>
+#include <iostream>
+
+SpriteSplatter::SpriteSplatter()
+{
+	//the closest splat is found with an atomic minimum on 64 bit values
+	m_supported = GLEW_ARB_gpu_shader_int64 && GLEW_NV_shader_atomic_int64;
+	if (!m_supported)
+	{
+		std::cout << "FAIL: 64 bit shader atomics are not supported, sub-pixel sprites are drawn as points" << std::endl;
+		return;
+	}
+	m_splatShader = std::make_unique<ShaderProgram>(SHADERS_PATH "/splatSprites.comp");
+	m_resolveShader = std::make_unique<ShaderProgram>(SHADERS_PATH "/splatResolve.vert", SHADERS_PATH "/splatResolve.frag");
+	glCreateVertexArrays(1, &m_vao);
+	m_colors.fill(glm::vec3(1.0f));
+}
+
+SpriteSplatter::~SpriteSplatter()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_pixelBuffer);
+}
+
+bool SpriteSplatter::isSupported()
+{
+	return m_supported;
+}
+
+void SpriteSplatter::setGroup(CullGroup group, const CullGroupDescription& description, glm::vec3 color)
+{
+	for (int i = 0; i < NUM_SPRITE_GROUPS; i++)
+	{
+		if (SPRITE_GROUPS[i] == group)
+		{
+			m_groups[i] = description;
+			m_colors[i] = color;
+		}
+	}
+}
+
+void SpriteSplatter::setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix)
+{
+	m_rotationMatrix = rotationMatrix;
+	m_secondHalfRotationMatrix = secondHalfRotationMatrix;
+}
+
+void SpriteSplatter::render(InstanceCuller& culler, glm::mat4 view, glm::mat4 projection, const std::vector<glm::vec4>& clipPlanes,
+	const std::array<int, 3>& scalarOffsets, float scalarMin, float scalarRange, GLuint transferFunctionUnit)
+{
+	if (!m_supported || !culler.isSplatting())
+	{
+		return;
+	}
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	resize(viewport[2], viewport[3]);
+	GLuint farthest[2] = { 0xFFFFFFFFu, 0xFFFFFFFFu };
+	glClearNamedBufferData(m_pixelBuffer, GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, farthest);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 30, m_pixelBuffer);
+
+	//splat pass, one thread per sub-pixel sprite of the culling pass
+	int numClipPlanes = std::min(static_cast<int>(clipPlanes.size()), InstanceCuller::MAX_CLIP_PLANES);
+	m_splatShader->use();
+	m_splatShader->updateUniform("viewProjectionMatrix", projection * view);
+	m_splatShader->updateUniform("rotationMatrix", m_rotationMatrix);
+	m_splatShader->updateUniform("secondHalfRotationMatrix", m_secondHalfRotationMatrix);
+	m_splatShader->updateUniform("clipPlanes", clipPlanes.data(), numClipPlanes);
+	m_splatShader->updateUniform("numClipPlanes", numClipPlanes);
+	m_splatShader->updateUniform("targetSize", glm::vec2(m_width, m_height));
+	bool splatted = false;
+	for (int i = 0; i < NUM_SPRITE_GROUPS; i++)
+	{
+		const CullGroupDescription& group = m_groups[i];
+		if (!group.enabled || group.numFilaments * group.numElements < 1)
+		{
+			continue;
+		}
+		//the same offsets as the culling pass, copied to its bindings
+		GLint filamentBuffer = 0;
+		GLint elementBuffer = 0;
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.filamentBinding, &filamentBuffer);
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, group.elementBinding, &elementBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, filamentBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, elementBuffer);
+
+		m_splatShader->updateUniform("numElements", group.numElements);
+		m_splatShader->updateUniform("axisCenter", (group.axisStart + group.axisEnd) * 0.5f);
+		m_splatShader->updateUniform("secondHalfStart", group.secondHalfStart);
+		m_splatShader->updateUniform("commandIndex", static_cast<int>(SPRITE_GROUPS[i]));
+		m_splatShader->updateUniform("splatGroup", i);
+		culler.dispatchSplats(SPRITE_GROUPS[i]);
+		splatted = true;
+	}
+	if (!splatted)
+	{
+		return;
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	//resolve pass, the depth test keeps the sprites and structures of the hardware in front
+	int last_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
+	m_resolveShader->use();
+	m_resolveShader->updateUniform("targetWidth", m_width);
+	std::array<glm::vec4, NUM_SPRITE_GROUPS> colors;
+	for (int i = 0; i < NUM_SPRITE_GROUPS; i++)
+	{
+		colors[i] = glm::vec4(m_colors[i], 1.0f);
+	}
+	m_resolveShader->updateUniform("groupColors", colors.data(), NUM_SPRITE_GROUPS);
+	std::array<int, NUM_SPRITE_GROUPS> numElements;
+	for (int i = 0; i < NUM_SPRITE_GROUPS; i++)
+	{
+		numElements[i] = std::max(m_groups[i].numElements, 1);
+	}
+	m_resolveShader->updateUniform("numElements", numElements.data(), NUM_SPRITE_GROUPS);
+	m_resolveShader->updateUniform("scalarOffsets", scalarOffsets.data(), NUM_SPRITE_GROUPS);
+	m_resolveShader->updateUniform("scalarMin", scalarMin);
+	m_resolveShader->updateUniform("scalarRange", scalarRange != 0.0f ? scalarRange : 1.0f);
+	m_resolveShader->updateUniform("transferFunction", static_cast<int>(transferFunctionUnit));
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(last_vao);
+}
+
+void SpriteSplatter::resize(int width, int height)
+{
+	if (width == m_width && height == m_height)
+	{
+		return;
+	}
+	m_width = width;
+	m_height = height;
+	glDeleteBuffers(1, &m_pixelBuffer);
+	glCreateBuffers(1, &m_pixelBuffer);
+	glNamedBufferStorage(m_pixelBuffer, static_cast<GLsizeiptr>(std::max(width * height, 1)) * sizeof(GLuint64), nullptr, 0);
+}
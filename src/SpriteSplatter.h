@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <memory>
+#include <vector>
+#include "InstanceCuller.h"
+#include "shaderProgram.h"
+
+// Draws the sprites that are smaller than a pixel with a compute pass instead of the point pipeline.
+// The culling pass moves the actin monomers, troponin and myosin heads that stay below a pixel into
+// splat lists (see LevelOfDetailSettings::splatSubPixel). Every splat projects its center and writes
+// its depth in the upper and its group and instance in the lower half of a 64 bit value into a buffer
+// of one value per pixel (binding 30) with an atomic minimum, so the closest splat of a pixel wins.
+// A full screen pass then shades the winners with the color of their group and writes their depth
+// and picking IDs, the depth test merges them with the structures drawn by the hardware.
+// Needs 64 bit integers and their atomics in shader storage, without them every sprite is drawn as a point.
+class SpriteSplatter
+{
+public:
+	SpriteSplatter();
+	~SpriteSplatter();
+	bool isSupported();
+	// Sets the instances and the color of a sprite group, the other groups are ignored
+	// * CullGroup group - ACTIN_MONOMERS, TROPONIN or MYOSIN_HEADS
+	void setGroup(CullGroup group, const CullGroupDescription& description, glm::vec3 color);
+	void setRotations(glm::mat4 rotationMatrix, glm::mat4 secondHalfRotationMatrix);
+	// Splats the sprites of the last culling pass into the bound framebuffer with the size of the viewport,
+	// expects the sarcomere ssbos, the mapped scalars (binding 20) and the transfer function to be bound
+	// * std::vector<glm::vec4> clipPlanes - world space planes, a splat is kept if its center is in front of all
+	// * int scalarOffsets - first instance of every sprite group in the mapped scalars, -1 = colored by its group
+	void render(InstanceCuller& culler, glm::mat4 view, glm::mat4 projection, const std::vector<glm::vec4>& clipPlanes,
+		const std::array<int, 3>& scalarOffsets, float scalarMin, float scalarRange, GLuint transferFunctionUnit);
+private:
+	static constexpr int NUM_SPRITE_GROUPS = 3;
+	static constexpr std::array<CullGroup, NUM_SPRITE_GROUPS> SPRITE_GROUPS = { CullGroup::ACTIN_MONOMERS, CullGroup::TROPONIN, CullGroup::MYOSIN_HEADS };
+	void resize(int width, int height);
+	bool m_supported = false;
+	std::unique_ptr<ShaderProgram> m_splatShader;
+	std::unique_ptr<ShaderProgram> m_resolveShader;
+	std::array<CullGroupDescription, NUM_SPRITE_GROUPS> m_groups;
+	std::array<glm::vec3, NUM_SPRITE_GROUPS> m_colors;
+	glm::mat4 m_rotationMatrix = glm::mat4(1.0f);
+	glm::mat4 m_secondHalfRotationMatrix = glm::mat4(1.0f);
+	GLuint m_vao = 0;
+	//closest splat of every pixel, depth and splat packed into 64 bits
+	GLuint m_pixelBuffer = 0;
+	int m_width = 0;
+	int m_height = 0;
+};
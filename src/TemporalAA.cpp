@@ -0,0 +1,125 @@
+#include "TemporalAA.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+//radical inverse of the halton sequence
+static float halton(int index, int base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f / base;
+	while (index > 0)
+	{
+		result += fraction * (index % base);
+		index /= base;
+		fraction /= base;
+	}
+	return result;
+}
+
+TemporalAA::TemporalAA() : m_resolveShader(SHADERS_PATH "/taaResolve.comp")
+{
+	m_history.fill(0);
+	m_historyFBO.fill(0);
+}
+
+TemporalAA::~TemporalAA()
+{
+	destroy();
+}
+
+glm::vec2 TemporalAA::nextJitter()
+{
+	//8 halton (2, 3) points cover the pixel evenly, index 0 would be the pixel corner
+	m_frame = (m_frame + 1) % 8;
+	return glm::vec2(halton(m_frame + 1, 2), halton(m_frame + 1, 3)) - 0.5f;
+}
+
+glm::mat4 TemporalAA::jitterProjection(glm::mat4 projection, glm::vec2 jitter, int width, int height)
+{
+	//a translation in ndc after the projection, so the jitter is the same in pixels at every depth
+	glm::vec2 ndcJitter = jitter * 2.0f / glm::vec2(width, height);
+	return glm::translate(glm::mat4(1.0f), glm::vec3(ndcJitter, 0.0f)) * projection;
+}
+
+void TemporalAA::resolve(GLuint colorTexture, GLuint depthTexture, int renderWidth, int renderHeight, int outputWidth, int outputHeight,
+	glm::mat4 viewProjection, glm::vec2 jitter, float feedback)
+{
+	if (outputWidth != m_width || outputHeight != m_height)
+	{
+		destroy();
+		create(outputWidth, outputHeight);
+	}
+	int previous = m_current;
+	m_current = 1 - m_current;
+
+	m_resolveShader.use();
+	m_resolveShader.updateUniform("reprojectionMatrix", m_previousViewProjection * glm::inverse(viewProjection));
+	m_resolveShader.updateUniform("jitter", jitter);
+	m_resolveShader.updateUniform("renderSize", glm::vec2(renderWidth, renderHeight));
+	m_resolveShader.updateUniform("outputSize", glm::vec2(outputWidth, outputHeight));
+	m_resolveShader.updateUniform("feedback", feedback);
+	m_resolveShader.updateUniform("historyValid", m_historyValid ? 1 : 0);
+	glBindTextureUnit(0, colorTexture);
+	glBindTextureUnit(1, depthTexture);
+	glBindTextureUnit(2, m_history[previous]);
+	glBindImageTexture(0, m_history[m_current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+	glBindTextureUnit(1, 0);
+	glBindTextureUnit(2, 0);
+
+	m_previousViewProjection = viewProjection;
+	m_historyValid = true;
+}
+
+void TemporalAA::reset()
+{
+	m_historyValid = false;
+}
+
+void TemporalAA::blitToScreen(int screenWidth, int screenHeight)
+{
+	glBlitNamedFramebuffer(m_historyFBO[m_current], 0, 0, 0, m_width, m_height, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, screenWidth, screenHeight);
+}
+
+GLuint TemporalAA::getOutputFBO()
+{
+	return m_historyFBO[m_current];
+}
+
+int TemporalAA::getOutputWidth()
+{
+	return m_width;
+}
+
+int TemporalAA::getOutputHeight()
+{
+	return m_height;
+}
+
+void TemporalAA::create(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	glCreateTextures(GL_TEXTURE_2D, 2, m_history.data());
+	glCreateFramebuffers(2, m_historyFBO.data());
+	for (int i = 0; i < 2; i++)
+	{
+		glTextureStorage2D(m_history[i], 1, GL_RGBA16F, width, height);
+		glTextureParameteri(m_history[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(m_history[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(m_history[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(m_history[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glNamedFramebufferTexture(m_historyFBO[i], GL_COLOR_ATTACHMENT0, m_history[i], 0);
+	}
+	m_historyValid = false;
+}
+
+void TemporalAA::destroy()
+{
+	glDeleteFramebuffers(2, m_historyFBO.data());
+	glDeleteTextures(2, m_history.data());
+	m_historyFBO.fill(0);
+	m_history.fill(0);
+}
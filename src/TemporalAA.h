@@ -0,0 +1,59 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <array>
+#include "shaderProgram.h"
+
+//parameters of the anti-aliasing window
+struct AntiAliasingSettings
+{
+	enum Mode { MSAA = 0, TAA = 1 };
+	int mode = MSAA;
+	int msaaSamples = 4;
+	//the scene is rendered at this fraction of the window resolution and upscaled by the taa resolve
+	float renderScale = 1.0f;
+	//weight of the history, higher values are smoother but react slower
+	float feedback = 0.9f;
+};
+
+// Temporal anti-aliasing with optional upscaling.
+// The scene is rendered single sampled with a sub-pixel jitter that changes every frame. The resolve
+// pass reprojects the history of the previous frames with the depth of the current frame and blends it
+// with the current color. The history is clamped to the color range of the current 3x3 neighbourhood,
+// which rejects disoccluded and changed pixels. The sarcomere has no per-instance animation, so
+// reprojecting the depth with the camera matrices yields the motion of every instance.
+class TemporalAA
+{
+public:
+	TemporalAA();
+	~TemporalAA();
+	// Returns the jitter of the next frame in render pixels, each component in [-0.5, 0.5]
+	glm::vec2 nextJitter();
+	// Moves the projection by the jitter
+	static glm::mat4 jitterProjection(glm::mat4 projection, glm::vec2 jitter, int width, int height);
+	// Blends the current frame into the history, the result is the output of the pass
+	// * GLuint colorTexture, depthTexture - single sampled scene rendered with the jittered projection
+	// * glm::mat4 viewProjection - unjittered matrix of the current frame
+	// * int outputWidth, outputHeight - resolution of the output, larger than the render size when upscaling
+	void resolve(GLuint colorTexture, GLuint depthTexture, int renderWidth, int renderHeight, int outputWidth, int outputHeight,
+		glm::mat4 viewProjection, glm::vec2 jitter, float feedback);
+	// Discards the history, the next resolve starts from the current frame only
+	void reset();
+	void blitToScreen(int screenWidth, int screenHeight);
+	GLuint getOutputFBO();
+	int getOutputWidth();
+	int getOutputHeight();
+private:
+	void create(int width, int height);
+	void destroy();
+	ShaderProgram m_resolveShader;
+	std::array<GLuint, 2> m_history;
+	std::array<GLuint, 2> m_historyFBO;
+	int m_current = 0;
+	int m_width = 0;
+	int m_height = 0;
+	int m_frame = 0;
+	bool m_historyValid = false;
+	glm::mat4 m_previousViewProjection = glm::mat4(1.0f);
+};
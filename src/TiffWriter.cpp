@@ -0,0 +1,144 @@
+#include "TiffWriter.h"
+#include <iostream>
+#include <algorithm>
+
+//tiff field types
+constexpr uint16_t TIFF_SHORT = 3;
+constexpr uint16_t TIFF_LONG = 4;
+constexpr uint16_t TIFF_RATIONAL = 5;
+
+TiffWriter::TiffWriter()
+{
+}
+
+TiffWriter::~TiffWriter()
+{
+	if (m_file.is_open())
+	{
+		close();
+	}
+}
+
+bool TiffWriter::open(const char* path, int width, int height, int rowsPerStrip, float dpi)
+{
+	m_width = width;
+	m_height = height;
+	m_writtenRows = 0;
+	const uint64_t rowBytes = static_cast<uint64_t>(width) * 3;
+	const uint32_t numStrips = static_cast<uint32_t>((height + rowsPerStrip - 1) / rowsPerStrip);
+	const uint16_t numEntries = 13;
+	//header, ifd, then the arrays that do not fit into an ifd entry, then the pixels
+	const uint32_t ifdOffset = 8;
+	const uint32_t bitsPerSampleOffset = ifdOffset + 2 + numEntries * 12 + 4;
+	const uint32_t resolutionOffset = bitsPerSampleOffset + 3 * 2;
+	const uint32_t stripOffsetsOffset = resolutionOffset + 2 * 8;
+	const uint32_t stripByteCountsOffset = stripOffsetsOffset + numStrips * 4;
+	const uint32_t dataOffset = stripByteCountsOffset + numStrips * 4;
+	if (dataOffset + rowBytes * height > UINT32_MAX)
+	{
+		std::cout << "FAIL: Image is too large for a tiff file (4 GB limit)." << std::endl;
+		return false;
+	}
+
+	m_file.open(path, std::ios::binary);
+	if (!m_file)
+	{
+		std::cout << "FAIL: Could not open " << path << std::endl;
+		return false;
+	}
+	//little endian header
+	m_file.write("II", 2);
+	writeShort(42);
+	writeLong(ifdOffset);
+
+	//entries have to be sorted by tag
+	writeShort(numEntries);
+	writeEntry(256, TIFF_LONG, 1, width);
+	writeEntry(257, TIFF_LONG, 1, height);
+	writeEntry(258, TIFF_SHORT, 3, bitsPerSampleOffset);
+	writeEntry(259, TIFF_SHORT, 1, 1);
+	writeEntry(262, TIFF_SHORT, 1, 2);
+	writeEntry(273, TIFF_LONG, numStrips, numStrips == 1 ? dataOffset : stripOffsetsOffset);
+	writeEntry(277, TIFF_SHORT, 1, 3);
+	writeEntry(278, TIFF_LONG, 1, rowsPerStrip);
+	writeEntry(279, TIFF_LONG, numStrips, numStrips == 1 ? static_cast<uint32_t>(rowBytes * height) : stripByteCountsOffset);
+	writeEntry(282, TIFF_RATIONAL, 1, resolutionOffset);
+	writeEntry(283, TIFF_RATIONAL, 1, resolutionOffset + 8);
+	writeEntry(284, TIFF_SHORT, 1, 1);
+	writeEntry(296, TIFF_SHORT, 1, 2);
+	writeLong(0);
+
+	//bits per sample
+	writeShort(8);
+	writeShort(8);
+	writeShort(8);
+	//x and y resolution in pixels per inch
+	const uint32_t dpiDenominator = 100;
+	writeLong(static_cast<uint32_t>(dpi * dpiDenominator));
+	writeLong(dpiDenominator);
+	writeLong(static_cast<uint32_t>(dpi * dpiDenominator));
+	writeLong(dpiDenominator);
+	//strip offsets and sizes, the last strip may be shorter
+	for (uint32_t i = 0; i < numStrips; i++)
+	{
+		writeLong(static_cast<uint32_t>(dataOffset + i * rowsPerStrip * rowBytes));
+	}
+	for (uint32_t i = 0; i < numStrips; i++)
+	{
+		int rows = std::min(rowsPerStrip, height - static_cast<int>(i) * rowsPerStrip);
+		writeLong(static_cast<uint32_t>(rows * rowBytes));
+	}
+	return m_file.good();
+}
+
+bool TiffWriter::writeRows(const unsigned char* data, int rows)
+{
+	if (!m_file.is_open() || m_writtenRows + rows > m_height)
+	{
+		return false;
+	}
+	m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(rows) * m_width * 3);
+	m_writtenRows += rows;
+	return m_file.good();
+}
+
+bool TiffWriter::close()
+{
+	bool complete = m_writtenRows == m_height && m_file.good();
+	m_file.close();
+	if (!complete)
+	{
+		std::cout << "FAIL: Tiff file is incomplete, " << m_writtenRows << " of " << m_height << " rows written." << std::endl;
+	}
+	return complete;
+}
+
+void TiffWriter::writeShort(uint16_t value)
+{
+	unsigned char bytes[2] = { static_cast<unsigned char>(value & 0xFF), static_cast<unsigned char>(value >> 8) };
+	m_file.write(reinterpret_cast<const char*>(bytes), 2);
+}
+
+void TiffWriter::writeLong(uint32_t value)
+{
+	unsigned char bytes[4] = { static_cast<unsigned char>(value & 0xFF), static_cast<unsigned char>((value >> 8) & 0xFF),
+		static_cast<unsigned char>((value >> 16) & 0xFF), static_cast<unsigned char>(value >> 24) };
+	m_file.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+void TiffWriter::writeEntry(uint16_t tag, uint16_t type, uint32_t count, uint32_t value)
+{
+	writeShort(tag);
+	writeShort(type);
+	writeLong(count);
+	//values shorter than four bytes are left aligned in the value field
+	if (type == TIFF_SHORT && count == 1)
+	{
+		writeShort(static_cast<uint16_t>(value));
+		writeShort(0);
+	}
+	else
+	{
+		writeLong(value);
+	}
+}
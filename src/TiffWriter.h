@@ -0,0 +1,29 @@
+#pragma once
+
+#include <fstream>
+#include <cstdint>
+
+// Streams an uncompressed 8 bit RGB baseline TIFF to disk.
+// All offsets are known in advance, so the header is written by open() and the pixel rows
+// follow in order. Only the rows passed to writeRows() have to be held in memory.
+class TiffWriter
+{
+public:
+	TiffWriter();
+	~TiffWriter();
+	// * int rowsPerStrip - rows per tiff strip, writeRows() may be called with any number of rows
+	// * float dpi - resolution stored in the file, used by layout programs to size the figure
+	bool open(const char* path, int width, int height, int rowsPerStrip, float dpi = 300.0f);
+	// Appends rows top to bottom, data holds rows * width * 3 bytes
+	bool writeRows(const unsigned char* data, int rows);
+	// Returns true if all rows have been written
+	bool close();
+private:
+	void writeShort(uint16_t value);
+	void writeLong(uint32_t value);
+	void writeEntry(uint16_t tag, uint16_t type, uint32_t count, uint32_t value);
+	std::ofstream m_file;
+	int m_width = 0;
+	int m_height = 0;
+	int m_writtenRows = 0;
+};
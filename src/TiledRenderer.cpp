@@ -0,0 +1,91 @@
+#include "TiledRenderer.h"
+#include "SceneFramebuffer.h"
+#include "TiffWriter.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+TiledRenderer::TiledRenderer(int tileSize, int guardBand, int samples)
+{
+	m_tileSize = tileSize;
+	m_guardBand = guardBand;
+	m_samples = samples;
+}
+
+bool TiledRenderer::render(const char* path, int width, int height, glm::mat4 view, glm::mat4 projection, int referenceViewport, float dpi,
+	InstanceCuller& culler, const std::function<void(const TileView&)>& renderScene)
+{
+	//the rendered tile including the guard band has to fit into a renderbuffer
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+	int guardBand = std::max(m_guardBand, 0);
+	int renderedSize = std::min(m_tileSize + 2 * guardBand, static_cast<int>(maxSize));
+	int tileSize = renderedSize - 2 * guardBand;
+	if (tileSize < 1 || width < 1 || height < 1)
+	{
+		std::cout << "FAIL: Invalid poster or tile size." << std::endl;
+		return false;
+	}
+
+	TiffWriter writer;
+	if (!writer.open(path, width, height, tileSize, dpi))
+	{
+		return false;
+	}
+	SceneFramebuffer tileFramebuffer(renderedSize, renderedSize, m_samples);
+	std::vector<unsigned char> strip(static_cast<size_t>(width) * tileSize * 3);
+	std::vector<unsigned char> tilePixels(static_cast<size_t>(tileSize) * tileSize * 3);
+	GLint lastPackAlignment;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &lastPackAlignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	//the sprite shaders scale points with viewportY * projection[1][1], the tile projection magnifies
+	//[1][1] by height / renderedSize, so viewportY shrinks by the same factor
+	int spriteViewport = static_cast<int>(std::lround(static_cast<double>(referenceViewport) * renderedSize / height));
+	int numColumns = (width + tileSize - 1) / tileSize;
+	int numRows = (height + tileSize - 1) / tileSize;
+	bool success = true;
+	//tiff rows run top to bottom, opengl rows bottom to top
+	for (int row = 0; row < numRows && success; row++)
+	{
+		int rowTop = row * tileSize;
+		int rows = std::min(tileSize, height - rowTop);
+		int y0 = height - rowTop - rows;
+		for (int column = 0; column < numColumns; column++)
+		{
+			int x0 = column * tileSize;
+			int columns = std::min(tileSize, width - x0);
+			//map the rendered pixel rectangle of the image to the whole clip space
+			float left = 2.0f * (x0 - guardBand) / width - 1.0f;
+			float right = 2.0f * (x0 - guardBand + renderedSize) / width - 1.0f;
+			float bottom = 2.0f * (y0 - guardBand) / height - 1.0f;
+			float top = 2.0f * (y0 - guardBand + renderedSize) / height - 1.0f;
+			glm::mat4 tileMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(-(right + left) / (right - left), -(top + bottom) / (top - bottom), 0.0f));
+			tileMatrix = glm::scale(tileMatrix, glm::vec3(2.0f / (right - left), 2.0f / (top - bottom), 1.0f));
+			TileView tileView;
+			tileView.view = view;
+			tileView.projection = tileMatrix * projection;
+			tileView.spriteViewport = spriteViewport;
+
+			culler.setCullFrustum(getFrustumPlanes(tileView.projection * tileView.view));
+			tileFramebuffer.bind();
+			tileFramebuffer.clear();
+			renderScene(tileView);
+			tileFramebuffer.resolve();
+			glGetTextureSubImage(tileFramebuffer.getColorTexture(), 0, guardBand, guardBand, 0, columns, rows, 1, GL_RGB, GL_UNSIGNED_BYTE,
+				static_cast<GLsizei>(tilePixels.size()), tilePixels.data());
+			for (int y = 0; y < rows; y++)
+			{
+				std::memcpy(&strip[(static_cast<size_t>(y) * width + x0) * 3], &tilePixels[static_cast<size_t>(rows - 1 - y) * columns * 3], static_cast<size_t>(columns) * 3);
+			}
+		}
+		success = writer.writeRows(strip.data(), rows);
+		std::cout << "Poster row " << row + 1 << " / " << numRows << std::endl;
+	}
+	culler.setCullFrustum(std::vector<glm::vec4>());
+	glPixelStorei(GL_PACK_ALIGNMENT, lastPackAlignment);
+	return writer.close() && success;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include "InstanceCuller.h"
+
+//camera of one poster tile
+struct TileView
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	//viewportY of the point sprite shaders, keeps the sprites at their size relative to the whole image
+	int spriteViewport;
+};
+
+//parameters of the poster window
+struct PosterSettings
+{
+	int width = 16384;
+	int height = 9216;
+	int tileSize = 2048;
+	int guardBand = 64;
+	float dpi = 300.0f;
+};
+
+// Renders images larger than any framebuffer by splitting the projection into sub-frusta.
+// Every tile is rendered into the same offscreen framebuffer and streamed into a tiff file one row
+// of tiles at a time, so only one row of tiles is held in memory. Tiles are rendered with a guard
+// band, point sprites whose center lies in a neighbouring tile are clipped by the GPU otherwise.
+// The culler only draws the instances inside the frustum of the current tile.
+class TiledRenderer
+{
+public:
+	// * int tileSize - edge length of the part of every tile that ends up in the image
+	// * int guardBand - pixels rendered around every tile, should cover the largest sprite radius
+	TiledRenderer(int tileSize = 2048, int guardBand = 64, int samples = 4);
+	// Renders the image and writes it to path, returns false if the file could not be written
+	// * glm::mat4 projection - projection of the whole image, its aspect has to match width / height
+	// * int referenceViewport - viewportY the sprite shaders would get for the untiled image
+	// * std::function renderScene - draws the scene into the bound framebuffer with the given tile camera
+	bool render(const char* path, int width, int height, glm::mat4 view, glm::mat4 projection, int referenceViewport, float dpi,
+		InstanceCuller& culler, const std::function<void(const TileView&)>& renderScene);
+private:
+	int m_tileSize;
+	int m_guardBand;
+	int m_samples;
+};
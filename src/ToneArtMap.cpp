@@ -0,0 +1,88 @@
+#include "ToneArtMap.h"
+#include <stbImage\stb_image.h>
+#include <glm/glm.hpp>
+#include <iostream>
+
+ToneArtMap::ToneArtMap(const std::filesystem::path& directory, const std::string& prefix)
+{
+	//tones are numbered from light to dark, the first one is blank paper
+	std::vector<std::vector<unsigned char>> tones;
+	int width = 0;
+	int height = 0;
+	for (int i = 0; ; i++)
+	{
+		std::filesystem::path path;
+		for (const char* extension : { ".png", ".jpg" })
+		{
+			std::filesystem::path candidate = directory / (prefix + "_" + std::to_string(i) + extension);
+			if (std::filesystem::exists(candidate))
+			{
+				path = candidate;
+			}
+		}
+		if (path.empty())
+		{
+			break;
+		}
+		int imageWidth, imageHeight;
+		unsigned char* image = stbi_load(path.string().c_str(), &imageWidth, &imageHeight, NULL, STBI_grey);
+		if (!image || (!tones.empty() && (imageWidth != width || imageHeight != height)))
+		{
+			std::cout << "FAIL: Could not load tone " << path.string() << ", all tones need the same size." << std::endl;
+			stbi_image_free(image);
+			break;
+		}
+		if (tones.empty())
+		{
+			width = imageWidth;
+			height = imageHeight;
+			tones.push_back(std::vector<unsigned char>(static_cast<size_t>(width) * height, 255));
+		}
+		tones.push_back(std::vector<unsigned char>(image, image + static_cast<size_t>(width) * height));
+		stbi_image_free(image);
+	}
+	if (tones.size() < 2)
+	{
+		std::cout << "FAIL: No tones found for " << prefix << std::endl;
+		return;
+	}
+
+	//interleave neighbouring tones
+	m_numLayers = static_cast<int>(tones.size()) - 1;
+	std::vector<unsigned char> layer(static_cast<size_t>(width) * height * 2);
+	int levels = 1 + static_cast<int>(glm::floor(glm::log2(static_cast<float>(glm::max(width, height)))));
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_texture);
+	glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(m_texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTextureStorage3D(m_texture, levels, GL_RG8, width, height, m_numLayers);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i = 0; i < m_numLayers; i++)
+	{
+		for (size_t p = 0; p < tones[i].size(); p++)
+		{
+			layer[p * 2] = tones[i][p];
+			layer[p * 2 + 1] = tones[i + 1][p];
+		}
+		glTextureSubImage3D(m_texture, 0, 0, 0, i, width, height, 1, GL_RG, GL_UNSIGNED_BYTE, layer.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	//coarser levels average the strokes into gray, which keeps the tone of distant structures
+	glGenerateTextureMipmap(m_texture);
+}
+
+ToneArtMap::~ToneArtMap()
+{
+	glDeleteTextures(1, &m_texture);
+}
+
+void ToneArtMap::bind(GLuint unit)
+{
+	glBindTextureUnit(unit, m_texture);
+}
+
+int ToneArtMap::getNumLayers()
+{
+	return m_numLayers;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//parameters of the shading window
+struct ShadingSettings
+{
+	enum Mode { PHONG = 0, HATCHING = 1, STIPPLING = 2 };
+	enum ToneSpace { SCREEN = 0, OBJECT = 1 };
+	int mode = PHONG;
+	int toneSpace = OBJECT;
+	//screen space size of one tone texture repeat in pixels
+	float toneScale = 128.0f;
+};
+
+// Tonal art map for hatching and stippling.
+// The tones are stored in a mipmapped 2D texture array, layer i holds tone i in red and tone i + 1
+// in green, so a fragment blends the two tones around its intensity with a single lookup.
+// Tone 0 is blank paper, the loaded images follow from light to dark.
+class ToneArtMap
+{
+public:
+	// * const std::string& prefix - loads prefix_0, prefix_1, ... from the directory, e.g. "hatch" or "stipple"
+	ToneArtMap(const std::filesystem::path& directory, const std::string& prefix);
+	~ToneArtMap();
+	// Binds the texture array to the texture unit, the shaders read it as sampler2DArray toneArtMap
+	void bind(GLuint unit);
+	// Returns the number of array layers, 0 if no tone could be loaded
+	int getNumLayers();
+private:
+	GLuint m_texture = 0;
+	int m_numLayers = 0;
+};
@@ -0,0 +1,289 @@
+#include "VideoCapture.h"
+#include "TiffWriter.h"
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <csignal>
+
+#ifdef _WIN32
+#define openPipe(command) _popen(command, "wb")
+#define closePipe(pipe) _pclose(pipe)
+#else
+#define openPipe(command) popen(command, "w")
+#define closePipe(pipe) pclose(pipe)
+#endif
+
+//quotes a path for the shell that runs the encoder, returns false if it cannot be quoted
+static bool quotePath(const std::string& path, std::string& quoted)
+{
+#ifdef _WIN32
+	//cmd has no escape for quotes, but windows file names cannot contain them either
+	if (path.find('"') != std::string::npos)
+	{
+		return false;
+	}
+	quoted = "\"" + path + "\"";
+#else
+	//nothing is expanded within single quotes, a single quote itself ends the quoting and is escaped
+	quoted = "'";
+	for (char c : path)
+	{
+		quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+	}
+	quoted += "'";
+#endif
+	return true;
+}
+
+VideoCapture::VideoCapture()
+{
+	m_pbos.fill(0);
+	m_mappedPixels.fill(nullptr);
+	m_fences.fill(nullptr);
+	for (std::atomic<SlotState>& state : m_slotStates)
+	{
+		state = SlotState::FREE;
+	}
+}
+
+VideoCapture::~VideoCapture()
+{
+	stop();
+	glDeleteBuffers(RING_SIZE, m_pbos.data());
+}
+
+bool VideoCapture::start(const char* path, CaptureOutput output, int width, int height, int fps)
+{
+	stop();
+	if (width < 1 || height < 1 || fps < 1)
+	{
+		std::cout << "FAIL: Invalid capture size or frame rate." << std::endl;
+		return false;
+	}
+	//the buffers stay mapped for the whole recording, the writer thread reads them directly
+	GLsizeiptr frameSize = static_cast<GLsizeiptr>(width) * height * 4;
+	if (frameSize != m_frameSize)
+	{
+		glDeleteBuffers(RING_SIZE, m_pbos.data());
+		glCreateBuffers(RING_SIZE, m_pbos.data());
+		GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		for (int i = 0; i < RING_SIZE; i++)
+		{
+			glNamedBufferStorage(m_pbos[i], frameSize, nullptr, mapFlags | GL_CLIENT_STORAGE_BIT);
+			m_mappedPixels[i] = static_cast<unsigned char*>(glMapNamedBufferRange(m_pbos[i], 0, frameSize, mapFlags));
+		}
+		m_frameSize = frameSize;
+	}
+
+	m_output = output;
+	m_path = path;
+	m_width = width;
+	m_height = height;
+	if (m_output == CaptureOutput::ENCODER)
+	{
+		std::string quotedPath;
+		if (!quotePath(m_path, quotedPath))
+		{
+			std::cout << "FAIL: The video path cannot be passed to the encoder: " << m_path << std::endl;
+			return false;
+		}
+		//opengl rows run bottom to top, the encoder flips them
+		std::stringstream command;
+		command << "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s " << width << "x" << height << " -r " << fps
+			<< " -i - -vf vflip -c:v libx264 -preset fast -crf 18 -pix_fmt yuv420p " << quotedPath;
+#ifndef _WIN32
+		//an encoder that exits early would kill the application with SIGPIPE on the next write,
+		//ignored the write fails with EPIPE instead
+		m_pipeHandler = signal(SIGPIPE, SIG_IGN);
+#endif
+		m_encoder = openPipe(command.str().c_str());
+		if (!m_encoder)
+		{
+#ifndef _WIN32
+			signal(SIGPIPE, m_pipeHandler);
+#endif
+			std::cout << "FAIL: Could not start the encoder: " << command.str() << std::endl;
+			return false;
+		}
+	}
+	m_frameDuration = 1.0 / fps;
+	m_nextFrameTime = 0.0;
+	m_writtenFrames = 0;
+	m_droppedFrames = 0;
+	m_failed = false;
+	m_stopWriter = false;
+	m_writer = std::thread(&VideoCapture::writeFrames, this);
+	m_recording = true;
+	return true;
+}
+
+void VideoCapture::stop()
+{
+	if (!m_recording)
+	{
+		return;
+	}
+	//the readbacks in flight still belong to the recording
+	while (m_slotStates[m_readIndex] == SlotState::READBACK)
+	{
+		glClientWaitSync(m_fences[m_readIndex], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		update();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_stopWriter = true;
+	}
+	m_queueCondition.notify_one();
+	m_writer.join();
+	if (m_encoder)
+	{
+		closePipe(m_encoder);
+		m_encoder = nullptr;
+#ifndef _WIN32
+		signal(SIGPIPE, m_pipeHandler);
+#endif
+	}
+	m_recording = false;
+	std::cout << "Capture finished, " << m_writtenFrames << " frames written, " << m_droppedFrames << " dropped." << std::endl;
+}
+
+void VideoCapture::captureFrame(GLuint fbo, int width, int height, double time)
+{
+	//the writer thread cannot stop the recording itself, the buffers belong to this thread
+	if (m_recording && m_failed)
+	{
+		stop();
+		return;
+	}
+	if (!m_recording || time < m_nextFrameTime)
+	{
+		return;
+	}
+	//keep the cadence, but do not try to catch up after a long frame
+	m_nextFrameTime = m_nextFrameTime + m_frameDuration < time ? time + m_frameDuration : m_nextFrameTime + m_frameDuration;
+	//ring is full or the window has been resized, drop the frame instead of waiting
+	if (width != m_width || height != m_height || m_slotStates[m_writeIndex] != SlotState::FREE)
+	{
+		m_droppedFrames++;
+		return;
+	}
+	GLint lastReadFBO;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastReadFBO);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[m_writeIndex]);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(0));
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, lastReadFBO);
+
+	m_fences[m_writeIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_slotStates[m_writeIndex] = SlotState::READBACK;
+	m_writeIndex = (m_writeIndex + 1) % RING_SIZE;
+}
+
+void VideoCapture::update()
+{
+	while (m_slotStates[m_readIndex] == SlotState::READBACK)
+	{
+		GLenum status = glClientWaitSync(m_fences[m_readIndex], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		glDeleteSync(m_fences[m_readIndex]);
+		m_fences[m_readIndex] = nullptr;
+		m_slotStates[m_readIndex] = SlotState::WRITING;
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_queue.push_back(m_readIndex);
+		}
+		m_queueCondition.notify_one();
+		m_readIndex = (m_readIndex + 1) % RING_SIZE;
+	}
+}
+
+bool VideoCapture::isRecording()
+{
+	return m_recording;
+}
+
+int VideoCapture::getWrittenFrames()
+{
+	return m_writtenFrames;
+}
+
+int VideoCapture::getDroppedFrames()
+{
+	return m_droppedFrames;
+}
+
+void VideoCapture::writeFrames()
+{
+	while (true)
+	{
+		int slot;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueCondition.wait(lock, [this] { return !m_queue.empty() || m_stopWriter; });
+			//only leave once every queued frame has been written
+			if (m_queue.empty())
+			{
+				return;
+			}
+			slot = m_queue.front();
+			m_queue.pop_front();
+		}
+		//after a failure the remaining frames are only returned to the ring
+		if (!m_failed && !writeFrame(m_mappedPixels[slot]))
+		{
+			m_failed = true;
+		}
+		m_slotStates[slot] = SlotState::FREE;
+	}
+}
+
+bool VideoCapture::writeFrame(const unsigned char* pixels)
+{
+	if (m_output == CaptureOutput::ENCODER)
+	{
+		if (fwrite(pixels, 1, m_frameSize, m_encoder) != static_cast<size_t>(m_frameSize))
+		{
+			std::cout << "FAIL: The encoder stopped accepting frames, the recording is stopped." << std::endl;
+			return false;
+		}
+		m_writtenFrames++;
+		return true;
+	}
+	std::filesystem::path path = m_path;
+	std::stringstream fileName;
+	fileName << path.stem().string() << "_" << std::setw(5) << std::setfill('0') << m_writtenFrames << ".tif";
+	path.replace_filename(fileName.str());
+
+	//flip the rows and drop alpha
+	TiffWriter writer;
+	if (!writer.open(path.string().c_str(), m_width, m_height, m_height))
+	{
+		return false;
+	}
+	std::vector<unsigned char> row(static_cast<size_t>(m_width) * 3);
+	for (int y = m_height - 1; y >= 0; y--)
+	{
+		const unsigned char* source = pixels + static_cast<size_t>(y) * m_width * 4;
+		for (int x = 0; x < m_width; x++)
+		{
+			row[x * 3 + 0] = source[x * 4 + 0];
+			row[x * 3 + 1] = source[x * 4 + 1];
+			row[x * 3 + 2] = source[x * 4 + 2];
+		}
+		writer.writeRows(row.data(), 1);
+	}
+	if (!writer.close())
+	{
+		std::cout << "FAIL: Could not write " << path.string() << ", the recording is stopped." << std::endl;
+		return false;
+	}
+	m_writtenFrames++;
+	return true;
+}
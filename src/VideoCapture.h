@@ -0,0 +1,93 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class CaptureOutput
+{
+	//raw frames are piped into an ffmpeg process which has to be on the PATH
+	ENCODER = 0,
+	//every frame is written as a numbered tiff file
+	IMAGE_SEQUENCE = 1
+};
+
+//parameters of the capture window
+struct CaptureSettings
+{
+	int output = static_cast<int>(CaptureOutput::ENCODER);
+	int fps = 60;
+};
+
+// Records the scene framebuffer without stalling the render loop.
+// Every captured frame is copied into one pixel buffer object of a ring and fenced. Once the fence
+// has been signaled the buffer is handed to a writer thread, which reads the persistently mapped
+// memory directly and returns the buffer to the ring afterwards. If the writer falls behind the
+// ring runs full and frames are dropped instead of waiting for it.
+// A frame that cannot be written, e.g. because the encoder exited, ends the recording.
+class VideoCapture
+{
+public:
+	VideoCapture();
+	~VideoCapture();
+	// Starts a recording with a fixed frame size, returns false if the output could not be opened
+	// * const char* path - video file for the encoder, base name of the files for an image sequence
+	// * int fps - frame rate of the video, frames are taken from the render loop at this rate
+	bool start(const char* path, CaptureOutput output, int width, int height, int fps);
+	// Writes the queued frames and closes the output, blocks until the writer thread is done
+	void stop();
+	// Queues a readback of color attachment 0 of fbo if the next video frame is due,
+	// stops the recording instead if the writer thread failed
+	// * double time - current time in seconds, used to pace the captured frames
+	void captureFrame(GLuint fbo, int width, int height, double time);
+	// Hands the frames whose readback has finished to the writer thread, call once per frame
+	void update();
+	bool isRecording();
+	int getWrittenFrames();
+	int getDroppedFrames();
+private:
+	static constexpr int RING_SIZE = 6;
+	enum class SlotState
+	{
+		FREE,
+		READBACK,
+		WRITING
+	};
+	void writeFrames();
+	// Returns false if the frame could not be written
+	bool writeFrame(const unsigned char* pixels);
+	std::array<GLuint, RING_SIZE> m_pbos;
+	std::array<unsigned char*, RING_SIZE> m_mappedPixels;
+	std::array<GLsync, RING_SIZE> m_fences;
+	std::array<std::atomic<SlotState>, RING_SIZE> m_slotStates;
+	int m_writeIndex = 0;
+	int m_readIndex = 0;
+	GLsizeiptr m_frameSize = 0;
+
+	bool m_recording = false;
+	CaptureOutput m_output = CaptureOutput::ENCODER;
+	std::string m_path;
+	int m_width = 0;
+	int m_height = 0;
+	double m_frameDuration = 0.0;
+	double m_nextFrameTime = 0.0;
+	FILE* m_encoder = nullptr;
+	//handler of SIGPIPE before the encoder was started, the signal is ignored while the pipe is open
+	void (*m_pipeHandler)(int) = nullptr;
+	std::atomic<bool> m_failed{ false };
+	std::atomic<int> m_writtenFrames{ 0 };
+	std::atomic<int> m_droppedFrames{ 0 };
+
+	//frames handed to the writer thread, in capture order
+	std::thread m_writer;
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueCondition;
+	std::deque<int> m_queue;
+	bool m_stopWriter = false;
+};
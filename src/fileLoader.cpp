@@ -1,4 +1,5 @@
 #include "fileLoader.h"
+#include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include<stbImage\stb_image.h>
 
@@ -142,21 +143,41 @@ QuadMesh FileLoader::quadMeshLoader(const std::filesystem::path &path)
 	return QuadMesh();
 }
 
-Material FileLoader::loadImage(const std::filesystem::path & path, int width, int height)
+Material FileLoader::loadImage(const std::filesystem::path & path, int width, int height, GLuint* texture)
 {
 	Material mat;
 	GLuint textureHandle;
+	if (texture)
+	{
+		*texture = 0;
+	}
 	unsigned char* image = stbi_load(path.string().c_str(), &width, &height, NULL, STBI_rgb);
+	if (!image)
+	{
+		std::cout << "FAIL: Could not load " << path.string() << std::endl;
+		return mat;
+	}
+	//hatching and stippling textures alias badly without mipmaps
+	int levels = 1 + static_cast<int>(glm::floor(glm::log2(static_cast<float>(glm::max(width, height)))));
 	glCreateTextures(GL_TEXTURE_2D, 1, &textureHandle);
 	glTextureParameteri(textureHandle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTextureParameteri(textureHandle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(textureHandle, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTextureParameteri(textureHandle, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTextureParameteri(textureHandle, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTextureStorage2D(textureHandle, 1, GL_RGB8, width, height);
+	glTextureStorage2D(textureHandle, levels, GL_RGB8, width, height);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glTextureSubImage2D(textureHandle, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateTextureMipmap(textureHandle);
+	stbi_image_free(image);
+	//the handle freezes the texture state, so it is created after all parameters are set
 	mat.textureAddress = glGetTextureHandleARB(textureHandle);
 	glMakeTextureHandleResidentARB(mat.textureAddress);
 	mat.color = glm::vec3(1.0, 1.0, 1.0);
+	if (texture)
+	{
+		*texture = textureHandle;
+	}
 	return mat;
 }
 
@@ -19,7 +19,9 @@ public:
 	FileLoader();
 	static TriangleMesh triangleMeshLoader(const std::filesystem::path &path);
 	static QuadMesh quadMeshLoader(const std::filesystem::path &path);
-	static Material loadImage(const std::filesystem::path &path, int width, int height);
+	// Loads the image as a mipmapped texture and returns a material with its resident bindless handle
+	// * GLuint* texture - receives the texture name if not null, 0 if the image could not be loaded
+	static Material loadImage(const std::filesystem::path &path, int width, int height, GLuint* texture = nullptr);
 	~FileLoader();
 private:
 };
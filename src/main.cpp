@@ -18,6 +18,27 @@
 #include <src/iconfont/IconsMaterialDesignIcons.h>
 #include <src/tinyfiledialogs.h>
 #include "Sarcomere.h"
+#include "SceneFramebuffer.h"
+#include "Picker.h"
+#include "InstanceCuller.h"
+#include "TiledRenderer.h"
+#include "VideoCapture.h"
+#include "ToneArtMap.h"
+#include "TemporalAA.h"
+#include "DynamicResolution.h"
+#include "FrameScheduler.h"
+#include "ShadowMap.h"
+#include "AmbientOcclusion.h"
+#include "OverdrawMeter.h"
+#include "ColorMapping.h"
+#include "SelectionMask.h"
+#include "ProgressiveRefinement.h"
+#include "RibbonCache.h"
+#include "CrossSectionView.h"
+#include "SpriteSplatter.h"
+#include "RayTracer.h"
+#include "FilamentImpostors.h"
+#include "LatticeTiles.h"
 #include<filesystem>
 
 #define WIDTH 1920
@@ -31,6 +52,634 @@ void updateFramerate(double currentTime, double lastTime, double frames, GLFWwin
 	glfwSetWindowTitle(window, title.c_str());
 }
 
+/*****************************************Inspector*****************************************/
+void drawInspector(const PickResult& hovered, const PickResult& selected, Sarcomere* sarcomere, const LatticeTiles& latticeTiles)
+{
+	ImGui::Begin("Inspector");
+	if (hovered.hit)
+	{
+		ImGui::Text("Hovered: %s %d / %d", getStructureName(hovered.type), hovered.filamentID, hovered.elementID);
+	}
+	else
+	{
+		ImGui::Text("Hovered: -");
+	}
+	ImGui::Separator();
+	if (!selected.hit || !sarcomere)
+	{
+		ImGui::Text("Left click an element to inspect it.");
+		ImGui::End();
+		return;
+	}
+	ImGui::Text("Selected: %s", getStructureName(selected.type));
+	ImGui::Text("filament index = %d", selected.filamentID);
+	ImGui::Text("element index = %d", selected.elementID);
+	ImGui::Text("position = (%f, %f, %f)", selected.position.x, selected.position.y, selected.position.z);
+	glm::vec4 filamentOffset;
+	switch (selected.type)
+	{
+	case StructureType::ACTIN_ROD:
+		if (selected.filamentID < sarcomere->getNumActin())
+		{
+			filamentOffset = sarcomere->getActinRod(selected.filamentID);
+			ImGui::Text("lattice position = (%f, %f)", filamentOffset.x, filamentOffset.z);
+			ImGui::Text("half sarcomere = %d", selected.filamentID < sarcomere->getNumActin() / 2 ? 1 : 2);
+		}
+		ImGui::Text("actin radius = %f", sarcomere->actinRadius);
+		ImGui::Text("actin length = %f", sarcomere->actinLength);
+		break;
+	case StructureType::ACTIN_MONOMER:
+	case StructureType::TROPOMYOSIN:
+	case StructureType::TROPONIN:
+		if (selected.filamentID < sarcomere->getNumActin())
+		{
+			filamentOffset = sarcomere->getActinRod(selected.filamentID);
+			ImGui::Text("lattice position = (%f, %f)", filamentOffset.x, filamentOffset.z);
+		}
+		ImGui::Text("actin radius = %f", sarcomere->actinRadius);
+		if (selected.type == StructureType::ACTIN_MONOMER)
+		{
+			ImGui::Text("monomers per filament = %d", sarcomere->getNumActinParticles());
+		}
+		if (selected.type == StructureType::TROPOMYOSIN)
+		{
+			ImGui::Text("segments per filament = %d", sarcomere->getNumLineSegments());
+		}
+		if (selected.type == StructureType::TROPONIN)
+		{
+			ImGui::Text("troponin per filament = %d", sarcomere->getNumTroponinParticles());
+		}
+		break;
+	case StructureType::MYOSIN_ROD:
+	case StructureType::LMM:
+	case StructureType::HMM:
+	case StructureType::MYOSIN_HEAD:
+		if (selected.filamentID < sarcomere->getNumMyosin())
+		{
+			filamentOffset = sarcomere->getMyosinRod(selected.filamentID);
+			ImGui::Text("lattice position = (%f, %f)", filamentOffset.x, filamentOffset.z);
+		}
+		ImGui::Text("myosin radius = %f", sarcomere->myosinRadius);
+		ImGui::Text("myosin length = %f", sarcomere->myosinLength);
+		if (selected.type == StructureType::LMM)
+		{
+			ImGui::Text("segments per filament = %d", sarcomere->getNumLMMOffsetPositionsPerRod());
+		}
+		if (selected.type == StructureType::HMM)
+		{
+			ImGui::Text("segments per filament = %d", sarcomere->getNumHMMOffsetPositionsPerRod());
+		}
+		if (selected.type == StructureType::MYOSIN_HEAD)
+		{
+			ImGui::Text("myosin head radius = %f", sarcomere->myosinHeadRadius);
+			ImGui::Text("heads per filament = %d", sarcomere->getNumMyosinHeads());
+		}
+		break;
+	case StructureType::Z_DISC:
+		ImGui::Text("sarcomere radius = %f", sarcomere->getRadius());
+		ImGui::Text("sarcomere length = %f", sarcomere->sarcomereLength);
+		break;
+	default:
+		break;
+	}
+	//the tile the culler and the ray tracer test the filament with
+	int tileKind = -1;
+	switch (selected.type)
+	{
+	case StructureType::ACTIN_ROD:
+	case StructureType::ACTIN_MONOMER:
+	case StructureType::TROPOMYOSIN:
+	case StructureType::TROPONIN:
+		tileKind = 0;
+		break;
+	case StructureType::MYOSIN_ROD:
+	case StructureType::LMM:
+	case StructureType::HMM:
+	case StructureType::MYOSIN_HEAD:
+		tileKind = 1;
+		break;
+	default:
+		break;
+	}
+	int tile = tileKind >= 0 ? latticeTiles.getTile(tileKind, selected.filamentID) : -1;
+	if (tile >= 0)
+	{
+		glm::ivec2 hex = latticeTiles.getTiles()[tile].hex;
+		ImGui::Text("lattice tile = (%d, %d)", hex.x, hex.y);
+	}
+	ImGui::End();
+}
+
+/*****************************************Clipping*****************************************/
+void drawClippingWindow(ClipSettings& clipSettings, LatticeTileSettings& latticeTileSettings, const LatticeTiles& latticeTiles)
+{
+	ImGui::Begin("Clipping");
+	const char* clipModes[] = { "Off", "Slab", "Planes" };
+	ImGui::Combo("Mode", &clipSettings.mode, clipModes, IM_ARRAYSIZE(clipModes));
+	if (clipSettings.mode == ClipSettings::SLAB)
+	{
+		//the filaments run along the x axis after the rod rotation
+		if (ImGui::Button("Cross Section (M-Line)"))
+		{
+			clipSettings.slabNormal = glm::vec3(1.0f, 0.0f, 0.0f);
+			clipSettings.slabCenter = 0.0f;
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Longitudinal"))
+		{
+			clipSettings.slabNormal = glm::vec3(0.0f, 0.0f, 1.0f);
+			clipSettings.slabCenter = 0.0f;
+		}
+		ImGui::DragFloat3("Slab Normal", &clipSettings.slabNormal.x, 0.01f, -1.0f, 1.0f);
+		ImGui::DragFloat("Slab Center", &clipSettings.slabCenter, 0.001f);
+		ImGui::DragFloat("Slab Thickness", &clipSettings.slabThickness, 0.001f, 0.001f, 10.0f);
+	}
+	else if (clipSettings.mode == ClipSettings::PLANES)
+	{
+		for (int i = 0; i < InstanceCuller::MAX_CLIP_PLANES; i++)
+		{
+			ImGui::PushID(i);
+			ImGui::Checkbox("Plane", &clipSettings.planeEnabled[i]);
+			if (clipSettings.planeEnabled[i])
+			{
+				ImGui::DragFloat3("Normal", &clipSettings.planeNormals[i].x, 0.01f, -1.0f, 1.0f);
+				ImGui::DragFloat("Offset", &clipSettings.planeOffsets[i], 0.001f);
+			}
+			ImGui::PopID();
+		}
+	}
+	ImGui::Separator();
+	//hexagonal columns of filaments, the culler tests them before their instances
+	ImGui::Checkbox("Lattice Tiles", &latticeTileSettings.enabled);
+	if (latticeTileSettings.enabled)
+	{
+		ImGui::SliderInt("Tile Size (unit cells)", &latticeTileSettings.cellsPerTile, 1, 16);
+		ImGui::Text("tiles = %d", static_cast<int>(latticeTiles.getTiles().size()));
+	}
+	ImGui::End();
+}
+
+/*****************************************Poster*****************************************/
+//returns true if the poster should be rendered to posterPath
+bool drawPosterWindow(PosterSettings& posterSettings, std::string& posterPath)
+{
+	bool renderPoster = false;
+	ImGui::Begin("Poster");
+	ImGui::InputInt("Width", &posterSettings.width);
+	ImGui::InputInt("Height", &posterSettings.height);
+	ImGui::InputInt("Tile Size", &posterSettings.tileSize);
+	ImGui::InputInt("Guard Band", &posterSettings.guardBand);
+	ImGui::InputFloat("DPI", &posterSettings.dpi);
+	posterSettings.width = glm::max(posterSettings.width, 1);
+	posterSettings.height = glm::max(posterSettings.height, 1);
+	posterSettings.tileSize = glm::max(posterSettings.tileSize, 64);
+	posterSettings.guardBand = glm::max(posterSettings.guardBand, 0);
+	if (ImGui::Button(ICON_MDI_CONTENT_SAVE " Render Poster"))
+	{
+		const char* fileEnding = "*.tif";
+		const char* filePath = tinyfd_saveFileDialog("Render Poster", nullptr, 1, &fileEnding, "TIFF-Files");
+		if (filePath)
+		{
+			std::filesystem::path path = filePath;
+			if (path.extension() != ".tif" && path.extension() != ".tiff")
+			{
+				path = path.string() + ".tif";
+			}
+			posterPath = path.string();
+			renderPoster = true;
+		}
+	}
+	ImGui::End();
+	return renderPoster;
+}
+
+/*****************************************Video Capture*****************************************/
+void drawCaptureWindow(VideoCapture& videoCapture, CaptureSettings& captureSettings, int width, int height)
+{
+	ImGui::Begin("Capture");
+	if (videoCapture.isRecording())
+	{
+		ImGui::Text("Recording %dx%d", width, height);
+		ImGui::Text("%d frames written, %d dropped", videoCapture.getWrittenFrames(), videoCapture.getDroppedFrames());
+		if (ImGui::Button("Stop Recording"))
+		{
+			videoCapture.stop();
+		}
+	}
+	else
+	{
+		const char* captureOutputs[] = { "Video (ffmpeg)", "Image Sequence" };
+		ImGui::Combo("Output", &captureSettings.output, captureOutputs, IM_ARRAYSIZE(captureOutputs));
+		ImGui::InputInt("FPS", &captureSettings.fps);
+		captureSettings.fps = glm::clamp(captureSettings.fps, 1, 240);
+		if (ImGui::Button("Start Recording"))
+		{
+			bool imageSequence = captureSettings.output == static_cast<int>(CaptureOutput::IMAGE_SEQUENCE);
+			const char* fileEnding = imageSequence ? "*.tif" : "*.mp4";
+			const char* filePath = tinyfd_saveFileDialog("Record", nullptr, 1, &fileEnding, imageSequence ? "TIFF-Files" : "MP4-Files");
+			if (filePath)
+			{
+				std::filesystem::path path = filePath;
+				if (!path.has_extension())
+				{
+					path = path.string() + (imageSequence ? ".tif" : ".mp4");
+				}
+				videoCapture.start(path.string().c_str(), static_cast<CaptureOutput>(captureSettings.output), width, height, captureSettings.fps);
+			}
+		}
+	}
+	ImGui::End();
+}
+
+/*****************************************Meshes*****************************************/
+bool drawMeshWindow(Renderer& meshRenderer, std::vector<std::unique_ptr<Object>>& meshes, int& meshMaterial)
+{
+	ImGui::Begin("Meshes");
+	std::vector<std::string> materialNames = meshRenderer.getMaterialNames();
+	bool b_imported = false;
+	if (!materialNames.empty())
+	{
+		meshMaterial = glm::clamp(meshMaterial, 0, static_cast<int>(materialNames.size()) - 1);
+		if (ImGui::BeginCombo("Material", materialNames[meshMaterial].c_str()))
+		{
+			for (int i = 0; i < static_cast<int>(materialNames.size()); i++)
+			{
+				if (ImGui::Selectable(materialNames[i].c_str(), i == meshMaterial))
+				{
+					meshMaterial = i;
+				}
+			}
+			ImGui::EndCombo();
+		}
+	}
+	if (ImGui::Button(ICON_MDI_FOLDER " Import Mesh"))
+	{
+		const char* fileEndings[] = { "*.obj", "*.off" };
+		const char* filePath = tinyfd_openFileDialog("Import Mesh", nullptr, 2, fileEndings, "Meshes", false);
+		if (filePath)
+		{
+			//the textures are only loaded once the first mesh needs them
+			if (materialNames.empty())
+			{
+				meshMaterial = glm::max(meshRenderer.loadTextures(RESOURCES_PATH), 0);
+			}
+			meshes.push_back(std::make_unique<Object>(MeshType::Triangle, filePath));
+			meshRenderer.addObject(*meshes.back(), meshMaterial);
+			b_imported = true;
+		}
+	}
+	ImGui::Text("%d meshes, %d material(s), 1 draw call", meshRenderer.getNumObjects(), static_cast<int>(materialNames.size()));
+	ImGui::End();
+	return b_imported;
+}
+
+/*****************************************Shading*****************************************/
+void drawShadingWindow(ShadingSettings& shadingSettings)
+{
+	ImGui::Begin("Shading");
+	const char* shadingModes[] = { "Phong", "Hatching", "Stippling" };
+	ImGui::Combo("Mode", &shadingSettings.mode, shadingModes, IM_ARRAYSIZE(shadingModes));
+	if (shadingSettings.mode != ShadingSettings::PHONG)
+	{
+		const char* toneSpaces[] = { "Screen", "Object" };
+		ImGui::Combo("Tone Space", &shadingSettings.toneSpace, toneSpaces, IM_ARRAYSIZE(toneSpaces));
+		if (shadingSettings.toneSpace == ShadingSettings::SCREEN)
+		{
+			ImGui::DragFloat("Tone Scale", &shadingSettings.toneScale, 1.0f, 8.0f, 1024.0f);
+		}
+	}
+	ImGui::End();
+}
+
+/*****************************************Shadows*****************************************/
+bool drawShadowWindow(ShadowSettings& shadowSettings)
+{
+	ImGui::Begin("Shadows");
+	ImGui::Checkbox("Enabled", &shadowSettings.enabled);
+	bool b_lightChanged = ImGui::SliderFloat("Light Azimuth", &shadowSettings.lightAzimuth, -180.0f, 180.0f);
+	b_lightChanged = ImGui::SliderFloat("Light Elevation", &shadowSettings.lightElevation, -89.0f, 89.0f) || b_lightChanged;
+	const char* resolutions[] = { "1024", "2048", "4096" };
+	int resolutionIndex = shadowSettings.resolution <= 1024 ? 0 : (shadowSettings.resolution <= 2048 ? 1 : 2);
+	if (ImGui::Combo("Resolution", &resolutionIndex, resolutions, IM_ARRAYSIZE(resolutions)))
+	{
+		shadowSettings.resolution = 1024 << resolutionIndex;
+	}
+	ImGui::SliderFloat("Normal Offset (texels)", &shadowSettings.normalOffset, 0.0f, 4.0f);
+	ImGui::End();
+	return b_lightChanged;
+}
+
+/*****************************************Ambient Occlusion*****************************************/
+void drawAmbientOcclusionWindow(AmbientOcclusionSettings& ambientOcclusionSettings, AmbientOcclusion& ambientOcclusion)
+{
+	ImGui::Begin("Ambient Occlusion");
+	ImGui::Checkbox("Enabled", &ambientOcclusionSettings.enabled);
+	ImGui::SliderFloat("Range (d10)", &ambientOcclusionSettings.range, 0.5f, 4.0f);
+	ImGui::SliderFloat("Strength", &ambientOcclusionSettings.strength, 0.5f, 8.0f);
+	ImGui::Text("%s", ambientOcclusion.isComplete() ? "baked" : "baking...");
+	ImGui::End();
+}
+
+/*****************************************Anti-Aliasing*****************************************/
+void drawAntiAliasingWindow(AntiAliasingSettings& antiAliasingSettings, int renderWidth, int renderHeight)
+{
+	ImGui::Begin("Anti-Aliasing");
+	const char* antiAliasingModes[] = { "MSAA", "TAA" };
+	ImGui::Combo("Mode", &antiAliasingSettings.mode, antiAliasingModes, IM_ARRAYSIZE(antiAliasingModes));
+	if (antiAliasingSettings.mode == AntiAliasingSettings::MSAA)
+	{
+		const char* sampleCounts[] = { "1", "2", "4", "8" };
+		int sampleIndex = glm::clamp(static_cast<int>(glm::log2(static_cast<float>(antiAliasingSettings.msaaSamples))), 0, 3);
+		if (ImGui::Combo("Samples", &sampleIndex, sampleCounts, IM_ARRAYSIZE(sampleCounts)))
+		{
+			antiAliasingSettings.msaaSamples = 1 << sampleIndex;
+		}
+	}
+	else
+	{
+		ImGui::SliderFloat("Render Scale", &antiAliasingSettings.renderScale, 0.5f, 1.0f);
+		ImGui::SliderFloat("Feedback", &antiAliasingSettings.feedback, 0.5f, 0.97f);
+	}
+	ImGui::Text("render resolution %dx%d", renderWidth, renderHeight);
+	ImGui::End();
+}
+
+/*****************************************Dynamic Resolution*****************************************/
+void drawDynamicResolutionWindow(DynamicResolutionSettings& dynamicResolutionSettings, DynamicResolution& dynamicResolution)
+{
+	ImGui::Begin("Dynamic Resolution");
+	ImGui::Checkbox("Enabled", &dynamicResolutionSettings.enabled);
+	ImGui::DragFloat("Target Frame Time (ms)", &dynamicResolutionSettings.targetFrameTime, 0.1f, 1.0f, 100.0f);
+	ImGui::SliderFloat("Minimum Scale", &dynamicResolutionSettings.minScale, 0.25f, 1.0f);
+	ImGui::Text("scene gpu time = %.2f ms", dynamicResolution.getGPUTime());
+	ImGui::Text("scale = %.2f", dynamicResolution.getScale());
+	ImGui::End();
+}
+
+/*****************************************Render On Demand*****************************************/
+void drawRenderOnDemandWindow(RenderOnDemandSettings& renderOnDemandSettings)
+{
+	ImGui::Begin("Render On Demand");
+	ImGui::Checkbox("Enabled", &renderOnDemandSettings.enabled);
+	ImGui::SliderFloat("Max FPS", &renderOnDemandSettings.maxFPS, 10.0f, 240.0f);
+	ImGui::End();
+}
+
+/*****************************************Overdraw*****************************************/
+void drawOverdrawWindow(OverdrawSettings& overdrawSettings, OverdrawMeter& overdrawMeter)
+{
+	ImGui::Begin("Overdraw");
+	ImGui::Checkbox("Sprite Depth Pre-Pass", &overdrawSettings.depthPrePass);
+	ImGui::Checkbox("Front To Back", &overdrawSettings.frontToBack);
+	ImGui::Checkbox("Heatmap", &overdrawSettings.showHeatmap);
+	float shadedFragments = overdrawMeter.getShadedFragmentsPerPixel();
+	if (shadedFragments < 0.0f)
+	{
+		ImGui::Text("fragment shader invocations not available");
+	}
+	else
+	{
+		ImGui::Text("shaded fragments per pixel = %.2f", shadedFragments);
+	}
+	ImGui::End();
+}
+
+/*****************************************Color Mapping*****************************************/
+void drawColorMappingWindow(ColorMappingSettings& colorMappingSettings, ColorMapping& colorMapping, int& userDataGroup)
+{
+	ImGui::Begin("Color Mapping");
+	const char* quantities[] = { "None", "Radial Distance (d10)", "Distance to M-Line", "Nearest Actin (d10)", "Filament Index", "User Data" };
+	ImGui::Combo("Quantity", &colorMappingSettings.quantity, quantities, IM_ARRAYSIZE(quantities));
+	if (colorMappingSettings.quantity == ColorMappingSettings::USER_DATA)
+	{
+		//in the order of CullGroup
+		const char* structures[] = { "Actin Rods", "Myosin Rods", "Actin Monomers", "Troponin", "Tropomyosin", "LMM", "HMM", "Myosin Heads" };
+		ImGui::Combo("Structure", &userDataGroup, structures, IM_ARRAYSIZE(structures));
+		if (ImGui::Button(ICON_MDI_FOLDER " Load Values"))
+		{
+			const char* fileEndings[] = { "*.txt", "*.csv" };
+			const char* filePath = tinyfd_openFileDialog("Load Values", nullptr, 2, fileEndings, "One value per instance", false);
+			if (filePath)
+			{
+				colorMapping.loadUserData(static_cast<CullGroup>(userDataGroup), filePath);
+			}
+		}
+	}
+	ImGui::Checkbox("Auto Range", &colorMappingSettings.autoRange);
+	if (colorMappingSettings.autoRange)
+	{
+		ImGui::Text("range %.3f to %.3f", colorMapping.getRangeMin(), colorMapping.getRangeMax());
+		colorMappingSettings.rangeMin = colorMapping.getRangeMin();
+		colorMappingSettings.rangeMax = colorMapping.getRangeMax();
+	}
+	else
+	{
+		ImGui::DragFloat("Minimum", &colorMappingSettings.rangeMin, 0.01f);
+		ImGui::DragFloat("Maximum", &colorMappingSettings.rangeMax, 0.01f);
+	}
+	//control points of the transfer function
+	std::vector<TransferPoint>& points = colorMappingSettings.transferFunction;
+	for (int i = 0; i < static_cast<int>(points.size()); i++)
+	{
+		ImGui::PushID(i);
+		ImGui::ColorEdit3("##color", &points[i].color.x, ImGuiColorEditFlags_NoInputs);
+		ImGui::SameLine();
+		ImGui::SliderFloat("##position", &points[i].position, 0.0f, 1.0f);
+		ImGui::SameLine();
+		if (ImGui::Button(ICON_MDI_DELETE) && points.size() > 1)
+		{
+			points.erase(points.begin() + i);
+		}
+		ImGui::PopID();
+	}
+	if (ImGui::Button(ICON_MDI_PLUS " Add Point"))
+	{
+		points.push_back({ 1.0f, glm::vec3(1.0f) });
+	}
+	ImGui::End();
+}
+
+/*****************************************Selection*****************************************/
+void drawSelectionWindow(SelectionSettings& selectionSettings, const PickResult& selectedElement, int& filamentIDInput)
+{
+	ImGui::Begin("Selection");
+	const char* modes[] = { "Off", "Isolate", "Hide" };
+	ImGui::Combo("Mode", &selectionSettings.mode, modes, IM_ARRAYSIZE(modes));
+	//in the order of CullGroup
+	const char* structures[] = { "Actin Rods", "Myosin Rods", "Actin Monomers", "Troponin", "Tropomyosin", "LMM", "HMM", "Myosin Heads" };
+	for (int i = 0; i < IM_ARRAYSIZE(structures); i++)
+	{
+		ImGui::Checkbox(structures[i], &selectionSettings.structures[i]);
+		if (i % 2 == 0)
+		{
+			ImGui::SameLine(150.0f);
+		}
+	}
+	const char* halves[] = { "Both Halves", "First Half", "Second Half" };
+	ImGui::Combo("Half", &selectionSettings.half, halves, IM_ARRAYSIZE(halves));
+	ImGui::Checkbox("##useRadius", &selectionSettings.useRadius);
+	ImGui::SameLine();
+	ImGui::DragFloat("Radius (d10)", &selectionSettings.radius, 0.05f, 0.0f, 100.0f);
+	ImGui::Checkbox("##useRings", &selectionSettings.useRings);
+	ImGui::SameLine();
+	ImGui::DragIntRange2("Rings", &selectionSettings.ringMin, &selectionSettings.ringMax, 0.1f, 0, 100);
+	ImGui::Checkbox("##usePicked", &selectionSettings.usePicked);
+	ImGui::SameLine();
+	ImGui::DragFloat("Around Picked (d10)", &selectionSettings.pickedRadius, 0.05f, 0.0f, 100.0f);
+	if (selectionSettings.usePicked && !selectedElement.hit)
+	{
+		ImGui::Text("click an element to pick it");
+	}
+	//explicit filament indices, shared by all structures of the same filaments
+	ImGui::Checkbox("Filament IDs", &selectionSettings.useFilamentIDs);
+	ImGui::InputInt("##filamentID", &filamentIDInput);
+	ImGui::SameLine();
+	if (ImGui::Button(ICON_MDI_PLUS " Add") && filamentIDInput >= 0)
+	{
+		selectionSettings.filamentIDs.push_back(filamentIDInput);
+	}
+	if (ImGui::Button(ICON_MDI_PLUS " Add Picked") && selectedElement.hit)
+	{
+		selectionSettings.filamentIDs.push_back(selectedElement.filamentID);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button(ICON_MDI_DELETE " Clear"))
+	{
+		selectionSettings.filamentIDs.clear();
+	}
+	std::stringstream ids;
+	for (int id : selectionSettings.filamentIDs)
+	{
+		ids << id << " ";
+	}
+	ImGui::TextWrapped("%s", ids.str().c_str());
+	ImGui::End();
+}
+
+/*****************************************Progressive Refinement*****************************************/
+void drawProgressiveWindow(ProgressiveSettings& progressiveSettings, ProgressiveRefinement& refinement)
+{
+	ImGui::Begin("Progressive Refinement");
+	ImGui::Checkbox("Proxy While Dragging", &progressiveSettings.enabled);
+	ImGui::SliderFloat("Proxy Render Scale", &progressiveSettings.proxyScale, 0.25f, 1.0f);
+	ImGui::Text("%s", refinement.isProxy() ? "refining..." : "full detail");
+	ImGui::End();
+}
+
+/*****************************************Ribbon Cache*****************************************/
+void drawRibbonCacheWindow(RibbonCacheSettings& ribbonCacheSettings, RibbonCache& ribbonCache)
+{
+	ImGui::Begin("Ribbon Cache");
+	ImGui::Checkbox("Cache Helix Points", &ribbonCacheSettings.enabled);
+	ImGui::SliderInt("Budget (MB)", &ribbonCacheSettings.budgetMB, 16, 2048);
+	ImGui::Text("%.1f MB in use", ribbonCache.getMemoryUsage() / (1024.0f * 1024.0f));
+	const char* slotNames[] = { "LMM first helix", "LMM second helix", "HMM first helix", "HMM second helix", "tropomyosin" };
+	for (int i = 0; i < static_cast<int>(RibbonSlot::COUNT); i++)
+	{
+		RibbonSlot slot = static_cast<RibbonSlot>(i);
+		ImGui::Text("%s: %s", slotNames[i], ribbonCache.isOverBudget(slot) ? "over budget" : (ribbonCache.isCached(slot) ? "cached" : "expanded"));
+	}
+	ImGui::End();
+}
+
+/*****************************************Cross Section*****************************************/
+void drawCrossSectionWindow(CrossSectionSettings& crossSectionSettings, CrossSectionView& crossSection, Sarcomere* sarcomere)
+{
+	ImGui::Begin("Cross Section");
+	ImGui::Checkbox("Show Cross Section", &crossSectionSettings.enabled);
+	if (!sarcomere)
+	{
+		ImGui::End();
+		return;
+	}
+	float halfLength = sarcomere->sarcomereLength / 2.0f;
+	ImGui::SliderFloat("Distance from M-line", &crossSectionSettings.slicePosition, -halfLength, halfLength);
+	ImGui::DragFloat2("Center (d10)", glm::value_ptr(crossSectionSettings.center), 0.05f);
+	ImGui::SliderFloat("Visible Height (d10)", &crossSectionSettings.zoom, 1.0f, 10000.0f, "%.1f", 4.0f);
+	if (ImGui::Button("Reset View"))
+	{
+		crossSectionSettings.center = glm::vec2(0.0f);
+		crossSectionSettings.zoom = 12.0f;
+	}
+	ImGui::Checkbox("Unit Cells", &crossSectionSettings.showUnitCells);
+	ImGui::SameLine();
+	ImGui::Checkbox("Spacings", &crossSectionSettings.showSpacings);
+	const char* sarcomereTypes[] = { "2:1", "3:1", "5:1", "6:1" };
+	ImGui::Text("actin : myosin = %s", sarcomereTypes[static_cast<int>(sarcomere->getSarcomereType())]);
+	ImGui::Text("d10 = %f (rows), d11 = %f (columns)", sarcomere->d10, sarcomere->d10 / glm::sqrt(3.0f));
+	ImGui::Text("%d filaments", crossSection.getNumFilaments());
+	ImGui::Text("Left drag pans, right drag zooms.");
+	ImGui::End();
+}
+
+/*****************************************Level of Detail*****************************************/
+void drawLevelOfDetailWindow(LevelOfDetailSettings& lodSettings, SpriteSplatter& spriteSplatter, FilamentImpostors& filamentImpostors)
+{
+	ImGui::Begin("Level of Detail");
+	ImGui::Checkbox("Stochastic Sprites", &lodSettings.enabled);
+	ImGui::SliderFloat("Target Size (px)", &lodSettings.targetPixels, 1.0f, 16.0f);
+	ImGui::SliderFloat("Min Fraction", &lodSettings.minFraction, 0.01f, 1.0f);
+	ImGui::SliderFloat("Fade Width", &lodSettings.fadeWidth, 0.01f, 1.0f);
+	if (spriteSplatter.isSupported())
+	{
+		ImGui::Checkbox("Splat Sub-Pixel Sprites", &lodSettings.splatSubPixel);
+	}
+	else
+	{
+		ImGui::Text("Splatting needs 64 bit shader atomics.");
+	}
+	ImGui::Checkbox("Filament Impostors", &lodSettings.impostors);
+	ImGui::SliderFloat("Impostor Size (px)", &lodSettings.impostorPixels, 4.0f, 128.0f);
+	if (lodSettings.impostors)
+	{
+		ImGui::Text("Impostor atlases: %.1f MB", filamentImpostors.getMemoryUsage() / (1024.0f * 1024.0f));
+	}
+	ImGui::End();
+}
+
+/*****************************************Ray Tracing*****************************************/
+//returns true if the image should be ray traced to rayTracedPath
+bool drawRayTracerWindow(RayTracerSettings& rayTracerSettings, std::string& rayTracedPath, RayTracer& rayTracer)
+{
+	bool renderRayTraced = false;
+	ImGui::Begin("Ray Tracing");
+	ImGui::InputInt("Width", &rayTracerSettings.width);
+	ImGui::InputInt("Height", &rayTracerSettings.height);
+	ImGui::InputInt("Samples per Pixel", &rayTracerSettings.samplesPerPixel);
+	ImGui::InputInt("Occlusion Rays", &rayTracerSettings.occlusionRays);
+	ImGui::SliderFloat("Occlusion Distance (d10)", &rayTracerSettings.occlusionDistance, 0.0f, 4.0f);
+	ImGui::SliderFloat("Light Angle", &rayTracerSettings.lightAngle, 0.0f, 20.0f);
+	ImGui::SliderFloat("Aperture (d10)", &rayTracerSettings.aperture, 0.0f, 2.0f);
+	ImGui::SliderFloat("Focus Distance (d10)", &rayTracerSettings.focusDistance, 0.1f, 200.0f);
+	ImGui::InputFloat("DPI", &rayTracerSettings.dpi);
+	rayTracerSettings.width = glm::max(rayTracerSettings.width, 1);
+	rayTracerSettings.height = glm::max(rayTracerSettings.height, 1);
+	rayTracerSettings.samplesPerPixel = glm::max(rayTracerSettings.samplesPerPixel, 1);
+	rayTracerSettings.occlusionRays = glm::max(rayTracerSettings.occlusionRays, 0);
+	if (ImGui::Button(ICON_MDI_CONTENT_SAVE " Ray Trace"))
+	{
+		const char* fileEnding = "*.tif";
+		const char* filePath = tinyfd_saveFileDialog("Ray Trace", nullptr, 1, &fileEnding, "TIFF-Files");
+		if (filePath)
+		{
+			std::filesystem::path path = filePath;
+			if (path.extension() != ".tif" && path.extension() != ".tiff")
+			{
+				path = path.string() + ".tif";
+			}
+			rayTracedPath = path.string();
+			renderRayTraced = true;
+		}
+	}
+	if (rayTracer.getNumInstances() > 0)
+	{
+		ImGui::Text("Last image: %d instances, %d primitives, %.1f MB", rayTracer.getNumInstances(), rayTracer.getNumPrimitives(),
+			rayTracer.getMemoryUsage() / (1024.0f * 1024.0f));
+	}
+	ImGui::End();
+	return renderRayTraced;
+}
+
 /*****************************************Key Callbacks*****************************************/
 static void key_callback(GLFWwindow * window, int key, int scancode, int action, int mods)
 {
@@ -56,7 +705,7 @@ int main() {
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);*/
 	/*glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);*/
-	glfwWindowHint(GLFW_SAMPLES, 4);
+	//the scene is rendered into a multisampled offscreen framebuffer, the window itself needs no samples
 	window = glfwCreateWindow(WIDTH, HEIGHT, "OpenGL Framework", 0, 0);
 	glfwSetWindowPos(window, 0, 0);
 	glfwMakeContextCurrent(window);
@@ -78,6 +727,96 @@ int main() {
 
 	Camera camera(WIDTH, HEIGHT, glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 60.0f, 0.0001f, 10.0f);
 
+	/*****************************************Scene Framebuffer and Picking*****************************************/
+	SceneFramebuffer sceneFramebuffer(WIDTH, HEIGHT, 4);
+	Picker picker;
+	PickResult hoveredElement;
+	PickResult selectedElement;
+	int framebufferWidth = WIDTH;
+	int framebufferHeight = HEIGHT;
+
+	/*****************************************Anti-Aliasing*****************************************/
+	TemporalAA temporalAA;
+	AntiAliasingSettings antiAliasingSettings;
+	DynamicResolution dynamicResolution;
+	DynamicResolutionSettings dynamicResolutionSettings;
+	FrameScheduler frameScheduler;
+	RenderOnDemandSettings renderOnDemandSettings;
+
+	/*****************************************Instance Culling and Clipping*****************************************/
+	InstanceCuller instanceCuller;
+	ClipSettings clipSettings;
+	std::vector<glm::vec4> viewClipPlanes;
+	LatticeTiles latticeTiles;
+	LatticeTileSettings latticeTileSettings;
+
+	/*****************************************Poster Rendering*****************************************/
+	PosterSettings posterSettings;
+	std::string posterPath;
+	bool b_renderPoster = false;
+
+	/*****************************************Video Capture*****************************************/
+	VideoCapture videoCapture;
+	CaptureSettings captureSettings;
+
+	/*****************************************Imported Meshes*****************************************/
+	Renderer meshRenderer;
+	std::vector<std::unique_ptr<Object>> meshes;
+	int meshMaterial = 0;
+
+	/*****************************************Illustrative Shading*****************************************/
+	ToneArtMap hatchingTones(RESOURCES_PATH, "hatch");
+	ToneArtMap stipplingTones(RESOURCES_PATH, "stipple");
+	ShadingSettings shadingSettings;
+
+	/*****************************************Shadows*****************************************/
+	ShadowMap shadowMap;
+	ShadowSettings shadowSettings;
+	//the shown structures and clipping planes the cached map was rendered with
+	std::vector<bool> shadowStructures;
+	std::vector<glm::vec4> shadowClipPlanes;
+
+	/*****************************************Ambient Occlusion*****************************************/
+	AmbientOcclusion ambientOcclusion;
+	AmbientOcclusionSettings ambientOcclusionSettings;
+
+	/*****************************************Overdraw*****************************************/
+	OverdrawMeter overdrawMeter;
+	OverdrawSettings overdrawSettings;
+
+	/*****************************************Color Mapping*****************************************/
+	ColorMapping colorMapping;
+	ColorMappingSettings colorMappingSettings;
+	int userDataGroup = 0;
+
+	/*****************************************Selection*****************************************/
+	SelectionMask selectionMask;
+	SelectionSettings selectionSettings;
+	int filamentIDInput = 0;
+
+	/*****************************************Progressive Refinement*****************************************/
+	ProgressiveRefinement refinement;
+	ProgressiveSettings progressiveSettings;
+
+	/*****************************************Ribbon Cache*****************************************/
+	RibbonCache ribbonCache;
+	RibbonCacheSettings ribbonCacheSettings;
+
+	/*****************************************Cross Section*****************************************/
+	CrossSectionView crossSection;
+	CrossSectionSettings crossSectionSettings;
+
+	/*****************************************Level of Detail*****************************************/
+	LevelOfDetailSettings lodSettings;
+	SpriteSplatter spriteSplatter;
+	FilamentImpostors filamentImpostors;
+
+	/*****************************************Ray Tracing*****************************************/
+	RayTracer rayTracer;
+	RayTracerSettings rayTracerSettings;
+	std::string rayTracedPath;
+	bool b_renderRayTraced = false;
+
 	/*****************************************Imgui Init***************************************************/
 	gui = std::make_unique<ImGui::ImGui>(window, false);
 	glfwSetKeyCallback(window, key_callback);
@@ -157,6 +896,21 @@ int main() {
 
 	ShaderProgram troponinShader = ShaderProgram(SHADERS_PATH "/troponinSpheres.vert", SHADERS_PATH "/troponinSpheres.frag");
 
+	ShaderProgram meshShader = ShaderProgram(SHADERS_PATH "/mesh.vert", SHADERS_PATH "/mesh.frag");
+
+	ShaderProgram impostorShader = ShaderProgram(SHADERS_PATH "/impostor.vert", SHADERS_PATH "/impostor.frag");
+
+	//depth only variants for the shadow map, the sprites cut out their disk
+	for (ShaderProgram* shader : { &zBandShader, &aRodShader, &mRodShader, &tropomyosinShader, &LMMShader, &HMMShader, &meshShader })
+	{
+		shader->addDepthVariant(SHADERS_PATH "/shadowDepth.frag");
+	}
+	//the sprites compute their depth like the full shaders, they also serve the depth pre-pass
+	aSphereShader.addDepthVariant(SHADERS_PATH "/sphereDepth.frag");
+	troponinShader.addDepthVariant(SHADERS_PATH "/sphereDepth.frag");
+	myosinHeadShader.addDepthVariant(SHADERS_PATH "/headDepth.frag");
+	impostorShader.addDepthVariant(SHADERS_PATH "/impostorDepth.frag");
+
 	//imgui checkbox parameter
 	bool b_konserveVolume = false;
 	bool b_highResActin = false;
@@ -175,10 +929,70 @@ int main() {
 	bool b_fieldLoaded = false;
 	GLuint vao;
 	glGenVertexArrays(1, &vao);
+	//the caches built from the instances are outdated once the lattice or its proxy changed
+	auto invalidateLattice = [&]()
+	{
+		shadowMap.invalidate();
+		ambientOcclusion.invalidate();
+		colorMapping.invalidate();
+		selectionMask.invalidate();
+		ribbonCache.invalidate();
+	};
+	//regenerate the detail structures, postponed while a parameter is dragged
+	auto regenerateActinDetail = [&]()
+	{
+		invalidateLattice();
+		if (refinement.defer(RefinementStep::ACTIN_DETAIL))
+		{
+			return;
+		}
+		sarcomere->generateDoubleHelixOffsetPositions();
+		tropomyosinShader.updateUniform("numLineSegments", sarcomere->getNumLineSegments());
+	};
+	auto regenerateMyosinDetail = [&]()
+	{
+		invalidateLattice();
+		if (refinement.defer(RefinementStep::MYOSIN_DETAIL))
+		{
+			return;
+		}
+		sarcomere->genLMM();
+		LMMShader.updateUniform("numLineSegments", sarcomere->getNumLMMOffsetPositionsPerRod());
+		HMMShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
+	};
+	auto regenerateHMMDetail = [&]()
+	{
+		invalidateLattice();
+		if (refinement.defer(RefinementStep::HMM_DETAIL))
+		{
+			return;
+		}
+		sarcomere->genHMMOffsetPositions(HMMAngleScale);
+		sarcomere->genMyosinHeads();
+	};
 	/*****************************************Render Loop***************************************************/
 	while (!glfwWindowShouldClose(window))
 	{
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		//taa renders single sampled and optionally below the window resolution
+		bool b_temporalAA = antiAliasingSettings.mode == AntiAliasingSettings::TAA && framebufferWidth > 0 && framebufferHeight > 0;
+		//a held gui item of the previous frame means the user is still dragging
+		refinement.beginFrame(progressiveSettings, ImGui::IsAnyItemActive());
+		if (framebufferWidth > 0 && framebufferHeight > 0)
+		{
+			//the capture reads the output at the size it was started with, so a recording keeps the full resolution
+			//(taa always upscales its output to the window)
+			float adaptiveScale = videoCapture.isRecording() ? 1.0f : dynamicResolution.getScale() * refinement.getRenderScale();
+			float renderScale = (b_temporalAA ? antiAliasingSettings.renderScale : 1.0f) * adaptiveScale;
+			sceneFramebuffer.setSamples(b_temporalAA ? 0 : antiAliasingSettings.msaaSamples);
+			sceneFramebuffer.resize(glm::max(static_cast<int>(framebufferWidth * renderScale), 1), glm::max(static_cast<int>(framebufferHeight * renderScale), 1));
+		}
+		if (!b_temporalAA)
+		{
+			temporalAA.reset();
+		}
+		//taa needs a few frames after every change until the history has converged
+		int settleFrames = b_temporalAA ? 8 : 1;
 		currentTime = glfwGetTime();
 		dt = currentTime - lastTime;
 		accumulator += dt;
@@ -191,6 +1005,49 @@ int main() {
 		/*****************************************Update Imgui Parameters*****************************************/
 		gui->newFrame();
 
+		//fetch the hovered element of a previous frame, picking never waits for the gpu
+		picker.poll(hoveredElement);
+		if (ImGui::IsMouseClicked(0) && !ImGui::GetIO().WantCaptureMouse)
+		{
+			selectedElement = hoveredElement;
+		}
+		drawInspector(hoveredElement, selectedElement, sarcomere.get(), latticeTiles);
+		drawClippingWindow(clipSettings, latticeTileSettings, latticeTiles);
+		b_renderPoster = drawPosterWindow(posterSettings, posterPath) || b_renderPoster;
+		drawCaptureWindow(videoCapture, captureSettings, framebufferWidth, framebufferHeight);
+		//imported meshes and a moved light change the shadows
+		if (drawMeshWindow(meshRenderer, meshes, meshMaterial))
+		{
+			shadowMap.invalidate();
+		}
+		drawShadingWindow(shadingSettings);
+		if (drawShadowWindow(shadowSettings))
+		{
+			shadowMap.invalidate();
+		}
+		drawAmbientOcclusionWindow(ambientOcclusionSettings, ambientOcclusion);
+		drawAntiAliasingWindow(antiAliasingSettings, sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight());
+		drawDynamicResolutionWindow(dynamicResolutionSettings, dynamicResolution);
+		drawRenderOnDemandWindow(renderOnDemandSettings);
+		drawOverdrawWindow(overdrawSettings, overdrawMeter);
+		drawColorMappingWindow(colorMappingSettings, colorMapping, userDataGroup);
+		drawSelectionWindow(selectionSettings, selectedElement, filamentIDInput);
+		drawProgressiveWindow(progressiveSettings, refinement);
+		drawRibbonCacheWindow(ribbonCacheSettings, ribbonCache);
+		drawCrossSectionWindow(crossSectionSettings, crossSection, sarcomere.get());
+		drawLevelOfDetailWindow(lodSettings, spriteSplatter, filamentImpostors);
+		b_renderRayTraced = drawRayTracerWindow(rayTracerSettings, rayTracedPath, rayTracer) || b_renderRayTraced;
+		//edited parameters can move the instances, cull again while the gui changes anything
+		if (ImGui::IsAnyItemActive())
+		{
+			instanceCuller.invalidate();
+		}
+		//clicks and releases cover buttons and checkboxes, which are never active for more than one frame
+		if (ImGui::IsAnyItemActive() || ImGui::IsMouseClicked(0) || ImGui::IsMouseReleased(0) || videoCapture.isRecording() || b_renderPoster || b_renderRayTraced)
+		{
+			frameScheduler.invalidate(settleFrames);
+		}
+
 		{
 			float guiClearColor[3] = { 1.0,0.0,0.0 };
 			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -266,6 +1123,8 @@ int main() {
 					b_myosinHeads = sarcomere->myosinHeads;
 					b_halfHelix = sarcomere->halfHelix;
 					b_structureIsGenerated = false;
+					instanceCuller.invalidate();
+					invalidateLattice();
 				}
 			}
 			ImGui::BeginVertical(1, ImVec2(0, 85));
@@ -414,7 +1273,6 @@ int main() {
 					aSphereShader.updateUniform("projectionMatrix", camera.projection());
 					aSphereShader.updateUniform("rotationMatrix", rodRotationMatrix);
 					aSphereShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
-					aSphereShader.updateUniform("numParticles", sarcomere->numParticles);
 					aSphereShader.updateUniform("basePointSize", sarcomere->actinRadius / 2.0f);
 					aSphereShader.updateUniform("viewportY", yViewport);
 
@@ -432,7 +1290,6 @@ int main() {
 					troponinShader.updateUniform("projectionMatrix", camera.projection());
 					troponinShader.updateUniform("rotationMatrix", rodRotationMatrix);
 					troponinShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
-					troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
 					troponinShader.updateUniform("basePointSize", sarcomere->actinRadius / 4.0f);
 					troponinShader.updateUniform("viewportY", yViewport);
 					troponinShader.updateUniform("diffColor", troponinColor);
@@ -472,8 +1329,6 @@ int main() {
 					myosinHeadShader.updateUniform("projectionMatrix", camera.projection());
 					myosinHeadShader.updateUniform("rotationMatrix", rodRotationMatrix);
 					myosinHeadShader.updateUniform("scaleWidthMatrix", scaleMyosinWidthMatrix);
-					myosinHeadShader.updateUniform("numParticles", sarcomere->getNumMyosinHeads());
-					myosinHeadShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
 					myosinHeadShader.updateUniform("basePointSize", sarcomere->myosinHeadRadius);
 					myosinHeadShader.updateUniform("viewportY", yViewport);
 					myosinHeadShader.updateUniform("diffColor", myosinHeadColor);
@@ -486,6 +1341,10 @@ int main() {
 				zBandShader.updateUniform("sarcomereRadius", scaleSarcomereRadiusMatrix);
 
 				b_structureIsGenerated = true;
+				instanceCuller.invalidate();
+				invalidateLattice();
+				crossSection.invalidate();
+				filamentImpostors.invalidate();
 			}
 
 			if (sarcomere)
@@ -568,25 +1427,18 @@ int main() {
 					if (sarcomere->actinLength != sarcomere->oldActinLength)
 					{
 						scaleActinLengthMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, sarcomere->actinLength, 1.0f));
+						invalidateLattice();
 						if (b_highResActin)
 						{
-							sarcomere->generateDoubleHelixOffsetPositions();
-
-							aSphereShader.updateUniform("numParticles", sarcomere->numParticles);
+							regenerateActinDetail();
 
 							if (b_tropomyosin)
 							{
 								tropomyosinShader.updateUniform("numLineSegments", sarcomere->getNumLineSegments());
 							}
-							if (b_troponin)
-							{
-								troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
-							}
-						}
-						else
-						{
-							aRodShader.updateUniform("scaleHeightMatrix", scaleActinLengthMatrix);
 						}
+						//the rods also stand in for the double helices while a drag is refined
+						aRodShader.updateUniform("scaleHeightMatrix", scaleActinLengthMatrix);
 						sarcomere->actinLengthScalePercentage = sarcomere->actinLength / sarcomere->sarcomereLength;
 						sarcomere->oldActinLength = sarcomere->actinLength;
 					}
@@ -595,13 +1447,13 @@ int main() {
 					if (sarcomere->actinRadius != sarcomere->oldActinRadius)
 					{
 						scaleActinWidthMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(sarcomere->actinRadius, 1.0f, sarcomere->actinRadius));
+						invalidateLattice();
 
 						if (b_highResActin)
 						{
-							sarcomere->generateDoubleHelixOffsetPositions();
+							regenerateActinDetail();
 
 							aSphereShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
-							aSphereShader.updateUniform("numParticles", sarcomere->numParticles);
 							aSphereShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
 							aSphereShader.updateUniform("basePointSize", sarcomere->actinRadius / 2.0f);
 							if (b_tropomyosin)
@@ -615,15 +1467,10 @@ int main() {
 							if (b_troponin)
 							{
 								troponinShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
-								troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
-								troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
 								troponinShader.updateUniform("basePointSize", sarcomere->actinRadius / 4.0f);
 							}
 						}
-						else
-						{
-							aRodShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
-						}
+						aRodShader.updateUniform("scaleWidthMatrix", scaleActinWidthMatrix);
 						sarcomere->actinRadiusScalePercentage = sarcomere->actinRadius / sarcomere->d10;
 						sarcomere->oldActinRadius = sarcomere->actinRadius;
 					}
@@ -634,12 +1481,13 @@ int main() {
 					if (sarcomere->myosinLength != sarcomere->oldMyosinLength)
 					{
 						scaleMyosinLengthMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, sarcomere->myosinLength, 1.0f));
+						invalidateLattice();
 						mRodShader.updateUniform("scaleHeightMatrix", scaleMyosinLengthMatrix);
 						mRodShader.updateUniform("myosinLength", sarcomere->myosinLength);
 
 						if (b_highResMyosin)
 						{
-							sarcomere->genLMM();
+							regenerateMyosinDetail();
 							if (b_LMM)
 							{
 								LMMShader.updateUniform("numLineSegments", sarcomere->getNumLMMOffsetPositionsPerRod());
@@ -648,32 +1496,27 @@ int main() {
 							{
 								HMMShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
 							}
-							if (b_myosinHeads)
-							{
-								myosinHeadShader.updateUniform("numParticles", sarcomere->getNumMyosinHeads());
-							}
 						}
 						sarcomere->myosinLengthScalePercentage = sarcomere->myosinLength / sarcomere->sarcomereLength;
 						sarcomere->oldMyosinLength = sarcomere->myosinLength;
 					}
 					if (ImGui::DragFloat("Scale HMM Angle", &HMMAngleScale, 0.01f, 0.00f, 1.00f))
 					{
-						sarcomere->genHMMOffsetPositions(HMMAngleScale);
-						sarcomere->genMyosinHeads();
+						regenerateHMMDetail();
 					}
 					ImGui::DragFloat("scaleMyosinWidth", &sarcomere->myosinRadius, 0.0001f, 0.0001f, 0.0001f);
 					if (sarcomere->myosinRadius != sarcomere->oldMyosinRadius)
 					{
 						sarcomere->myosinTrunkRadius = sarcomere->myosinRadius / 3.0f;
+						invalidateLattice();
 						scaleMyosinTrunkWidthMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(sarcomere->myosinTrunkRadius, 1.0f, sarcomere->myosinTrunkRadius));
 						scaleMyosinWidthMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(sarcomere->myosinRadius, 1.0f, sarcomere->myosinRadius));
 						if (b_highResMyosin)
 						{
 							mRodShader.updateUniform("scaleWidthMatrix", scaleMyosinTrunkWidthMatrix);
 							sarcomere->updateHMMAngle();
-							sarcomere->genLMM();
-							sarcomere->genHMMOffsetPositions(HMMAngleScale);
-							sarcomere->genMyosinHeads();
+							regenerateMyosinDetail();
+							regenerateHMMDetail();
 							myosinHeadShader.updateUniform("basePointSize", sarcomere->myosinRadius / 6.0f);
 							if (b_LMM)
 							{
@@ -710,8 +1553,7 @@ int main() {
 						{
 							sarcomere->updateHMMLength();
 						}
-						sarcomere->genHMMOffsetPositions(HMMAngleScale);
-						sarcomere->genMyosinHeads();
+						regenerateHMMDetail();
 					}
 					else
 					{
@@ -722,21 +1564,16 @@ int main() {
 					aSphereShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 					tropomyosinShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 					aRodShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
-					sarcomere->generateDoubleHelixOffsetPositions();
+					regenerateActinDetail();
 					if (b_actin)
 					{
 						if (b_highResActin)
 						{
 
-							aSphereShader.updateUniform("numParticles", sarcomere->numParticles);
 							if (b_tropomyosin)
 							{
 								tropomyosinShader.updateUniform("numLineSegments", sarcomere->getNumLineSegments());
 							}
-							if (b_troponin)
-							{
-								troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
-							}
 						}
 					}
 					if (b_myosin)
@@ -744,9 +1581,8 @@ int main() {
 						mRodShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 						if (b_highResMyosin)
 						{
-							sarcomere->genLMM();
-							sarcomere->genHMMOffsetPositions(HMMAngleScale);
-							sarcomere->genMyosinHeads();
+							regenerateMyosinDetail();
+							regenerateHMMDetail();
 
 							if (b_LMM)
 							{
@@ -756,11 +1592,6 @@ int main() {
 							{
 								HMMShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
 							}
-							if (b_myosinHeads)
-							{
-								myosinHeadShader.updateUniform("numParticles", sarcomere->getNumMyosinHeads());
-								myosinHeadShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
-							}
 						}
 					}
 					sarcomere->oldSarcomereLength = sarcomere->sarcomereLength;
@@ -773,7 +1604,7 @@ int main() {
 						//derive new sarcomere length based on a fixed sarcomere volume and the new d10 value
 						sarcomere->updateLength();
 						sarcomere->oldSarcomereLength = sarcomere->sarcomereLength;
-						sarcomere->generateDoubleHelixOffsetPositions();
+						regenerateActinDetail();
 						aSphereShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 						tropomyosinShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 						aRodShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
@@ -782,15 +1613,10 @@ int main() {
 							if (b_highResActin)
 							{
 
-								aSphereShader.updateUniform("numParticles", sarcomere->numParticles);
 								if (b_tropomyosin)
 								{
 									tropomyosinShader.updateUniform("numLineSegments", sarcomere->getNumLineSegments());
 								}
-								if (b_troponin)
-								{
-									troponinShader.updateUniform("numParticles", sarcomere->getNumTroponinParticles());
-								}
 							}
 						}
 						if (b_myosin)
@@ -798,7 +1624,7 @@ int main() {
 							mRodShader.updateUniform("sarcomereLength", sarcomere->sarcomereLength);
 							if (b_highResMyosin)
 							{
-								sarcomere->genLMM();
+								regenerateMyosinDetail();
 
 								if (b_LMM)
 								{
@@ -808,11 +1634,6 @@ int main() {
 								{
 									HMMShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
 								}
-								if (b_myosinHeads)
-								{
-									myosinHeadShader.updateUniform("numParticles", sarcomere->getNumMyosinHeads());
-									myosinHeadShader.updateUniform("numLineSegments", sarcomere->getNumHMMOffsetPositionsPerRod());
-								}
 							}
 						}
 						if (HMMAngleScale == 1)
@@ -827,8 +1648,7 @@ int main() {
 					}
 					sarcomere->updateOffsetBuffers();
 					scaleSarcomereRadiusMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(sarcomere->getRadius(), 1.0f, sarcomere->getRadius()));
-					sarcomere->genHMMOffsetPositions(HMMAngleScale);
-					sarcomere->genMyosinHeads();
+					regenerateHMMDetail();
 					zBandShader.updateUniform("sarcomereRadius", scaleSarcomereRadiusMatrix);
 					sarcomere->oldD10 = sarcomere->d10;
 				}
@@ -856,117 +1676,642 @@ int main() {
 			}
 		}
 
-		camera.update(window);
+		//refine one postponed structure per frame once the input settled
+		RefinementStep refinementStep = refinement.nextStep();
+		if (sarcomere && refinementStep != RefinementStep::COUNT)
+		{
+			if (refinementStep == RefinementStep::ACTIN_DETAIL)
+			{
+				regenerateActinDetail();
+			}
+			else if (refinementStep == RefinementStep::MYOSIN_DETAIL)
+			{
+				regenerateMyosinDetail();
+			}
+			else
+			{
+				regenerateHMMDetail();
+			}
+			instanceCuller.invalidate();
+			filamentImpostors.invalidate();
+		}
+		if (refinementStep != RefinementStep::COUNT || refinement.isProxy())
+		{
+			frameScheduler.invalidate(settleFrames);
+		}
+
+		//the cross section is panned and zoomed with the mouse instead of the camera
+		if (crossSectionSettings.enabled)
+		{
+			if (crossSection.handleInput(window, crossSectionSettings, ImGui::GetIO().WantCaptureMouse))
+			{
+				frameScheduler.invalidate();
+			}
+		}
+		else
+		{
+			camera.update(window);
+		}
 
-		if (sarcomere)
+		//without changes the resolved frame of the last drawn frame is shown again
+		bool b_renderScene = frameScheduler.beginFrame(renderOnDemandSettings, camera.projection() * camera.view(),
+			sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight(), settleFrames);
+		glm::vec2 jitter = glm::vec2(0.0f);
+		if (b_renderScene)
+		{
+			if (b_temporalAA)
+			{
+				jitter = temporalAA.nextJitter();
+			}
+			sceneFramebuffer.bind();
+			sceneFramebuffer.clear();
+			//measures the scene from here up to the taa resolve, the gui is drawn at native resolution afterwards
+			dynamicResolution.beginFrame();
+		}
+
+		if (sarcomere && b_renderScene)
 		{
 			//rebind ssbos
 			sarcomere->bindBuffers();
-			//render data
-			//render zDiscs
-			zBandShader.use();
-			zBandShader.updateUniform("viewMatrix", camera.view());
-			zDiscs->render(sarcomere->getNumZdiscs());
-			//bind empty vao because otherwise it binds a wrong one
-			glBindVertexArray(vao);
-
-			//render Myosin
-			if (b_myosin)
+			//cull instances against the clipping planes, only reruns if something changed
+			glm::vec3 sarcomereCenter = glm::vec3(rodRotationMatrix * glm::vec4(glm::vec3(sarcomere->getMidPoint()), 1.0f));
+			instanceCuller.setClipPlanes(clipSettings.getPlanes(sarcomereCenter));
+			instanceCuller.setRotations(rodRotationMatrix, secondHalfRotationMatrix);
+			//the culler keeps its old ranges unless it is told that the tiles were built again
+			if (latticeTiles.update(*sarcomere, latticeTileSettings, secondHalfRotationMatrix))
 			{
-				mRodShader.use();
-				if (b_highResMyosin)
+				instanceCuller.invalidate();
+			}
+			instanceCuller.setTiles(&latticeTiles);
+			glm::vec3 midPoint = glm::vec3(sarcomere->getMidPoint());
+			//the proxy of a drag draws the filament rods in place of the postponed detail structures
+			bool b_actinDetail = b_highResActin && !refinement.isProxy();
+			bool b_myosinDetail = b_highResMyosin && !refinement.isProxy();
+			{
+				//actin rods are cones from the midpoint along y, scaled and moved by half a sarcomere length
+				CullGroupDescription actinRodGroup;
+				actinRodGroup.enabled = b_actin && !b_actinDetail;
+				actinRodGroup.filamentBinding = 3;
+				actinRodGroup.numFilaments = sarcomere->getNumActin();
+				actinRodGroup.axisStart = midPoint * glm::vec3(sarcomere->actinRadius, sarcomere->actinLength, sarcomere->actinRadius) + glm::vec3(0.0f, -sarcomere->sarcomereLength / 2.0f, 0.0f);
+				actinRodGroup.axisEnd = actinRodGroup.axisStart + glm::vec3(0.0f, sarcomere->actinLength, 0.0f);
+				actinRodGroup.boundingRadius = sarcomere->actinRadius;
+				actinRodGroup.secondHalfStart = sarcomere->getNumActin() / 2;
+				actinRodGroup.vertexCount = actinRods->getNumIndices();
+				instanceCuller.setGroup(CullGroup::ACTIN_RODS, actinRodGroup);
+
+				float myosinWidth = b_myosinDetail ? sarcomere->myosinTrunkRadius : sarcomere->myosinRadius;
+				CullGroupDescription myosinRodGroup;
+				myosinRodGroup.enabled = b_myosin;
+				myosinRodGroup.filamentBinding = 2;
+				myosinRodGroup.numFilaments = sarcomere->getNumMyosin();
+				myosinRodGroup.axisStart = midPoint * glm::vec3(myosinWidth, sarcomere->myosinLength, myosinWidth) + glm::vec3(0.0f, -sarcomere->myosinLength / 2.0f, 0.0f);
+				myosinRodGroup.axisEnd = myosinRodGroup.axisStart + glm::vec3(0.0f, sarcomere->myosinLength, 0.0f);
+				myosinRodGroup.boundingRadius = myosinWidth;
+				myosinRodGroup.vertexCount = myosinRods->getNumIndices();
+				instanceCuller.setGroup(CullGroup::MYOSIN_RODS, myosinRodGroup);
+
+				CullGroupDescription actinMonomerGroup;
+				actinMonomerGroup.enabled = b_actin && b_actinDetail;
+				actinMonomerGroup.filamentBinding = 3;
+				actinMonomerGroup.elementBinding = 4;
+				actinMonomerGroup.numFilaments = sarcomere->getNumActin() / 2;
+				actinMonomerGroup.numElements = sarcomere->numParticles;
+				actinMonomerGroup.boundingRadius = sarcomere->actinRadius / 2.0f;
+				actinMonomerGroup.vertexCount = 1;
+				actinMonomerGroup.perFilamentDraws = true;
+				actinMonomerGroup.lodPointSize = sarcomere->actinRadius / 2.0f;
+				instanceCuller.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup);
+
+				CullGroupDescription troponinGroup = actinMonomerGroup;
+				troponinGroup.enabled = b_actin && b_actinDetail && b_troponin;
+				troponinGroup.elementBinding = 6;
+				troponinGroup.numElements = sarcomere->getNumTroponinParticles();
+				troponinGroup.boundingRadius = sarcomere->actinRadius / 4.0f;
+				troponinGroup.lodPointSize = sarcomere->actinRadius / 4.0f;
+				instanceCuller.setGroup(CullGroup::TROPONIN, troponinGroup);
+
+				//one strand per filament half, the culler drops or keeps a whole half
+				glm::vec3 tropomyosinStart, tropomyosinEnd;
+				float tropomyosinRadius;
+				sarcomere->getTropomyosinBounds(tropomyosinStart, tropomyosinEnd, tropomyosinRadius);
+				CullGroupDescription tropomyosinGroup = actinMonomerGroup;
+				tropomyosinGroup.enabled = b_actin && b_actinDetail && b_tropomyosin;
+				tropomyosinGroup.elementBinding = 5;
+				tropomyosinGroup.numElements = 2;
+				tropomyosinGroup.elementSpacing = 0.0f;
+				tropomyosinGroup.axisStart = tropomyosinStart;
+				tropomyosinGroup.axisEnd = tropomyosinEnd;
+				tropomyosinGroup.boundingRadius = tropomyosinRadius + sarcomere->actinRadius / 8.0f;
+				tropomyosinGroup.vertexCount = sarcomere->getNumPointsPerTropomyosinStrand();
+				tropomyosinGroup.lodPointSize = 0.0f;
+				instanceCuller.setGroup(CullGroup::TROPOMYOSIN, tropomyosinGroup);
+				//the selection and the color mapping work per molecule of seven monomers, the strands read their bits
+				//and scalars in the vertex shader
+				CullGroupDescription tropomyosinMoleculeGroup = tropomyosinGroup;
+				tropomyosinMoleculeGroup.numElements = sarcomere->getNumLineSegments();
+				tropomyosinMoleculeGroup.elementSpacing = 7.0f * sarcomere->actinRadius;
+				tropomyosinMoleculeGroup.axisStart = tropomyosinStart + glm::vec3(0.0f, 3.5f * sarcomere->actinRadius, 0.0f);
+				tropomyosinMoleculeGroup.axisEnd = tropomyosinMoleculeGroup.axisStart;
+
+				CullGroupDescription LMMGroup;
+				LMMGroup.enabled = b_myosin && b_myosinDetail && b_LMM;
+				LMMGroup.filamentBinding = 2;
+				LMMGroup.elementBinding = 7;
+				LMMGroup.numFilaments = sarcomere->getNumMyosin();
+				LMMGroup.numElements = sarcomere->getNumLMMOffsetPositionsPerRod();
+				LMMGroup.boundingRadius = sarcomere->getLMMBoundingRadius() + sarcomere->myosinTrunkRadius / 20.0f;
+				LMMGroup.vertexCount = sarcomere->getNumPointsPerLMMHelix();
+				LMMGroup.perFilamentDraws = true;
+				instanceCuller.setGroup(CullGroup::LMM, LMMGroup);
+
+				CullGroupDescription HMMGroup = LMMGroup;
+				HMMGroup.enabled = b_myosin && b_myosinDetail && b_HMM;
+				HMMGroup.elementBinding = 8;
+				HMMGroup.numElements = sarcomere->getNumHMMOffsetPositionsPerRod();
+				HMMGroup.boundingRadius = sarcomere->getHMMBoundingRadius() + sarcomere->myosinTrunkRadius / 20.0f;
+				HMMGroup.vertexCount = sarcomere->getNumPointsPerHMMHelix();
+				instanceCuller.setGroup(CullGroup::HMM, HMMGroup);
+
+				//heads are clipped by their center, so they need no radius
+				CullGroupDescription myosinHeadGroup = LMMGroup;
+				myosinHeadGroup.enabled = b_myosin && b_myosinDetail && b_myosinHeads;
+				myosinHeadGroup.elementBinding = 12;
+				myosinHeadGroup.numElements = sarcomere->getNumMyosinHeads();
+				myosinHeadGroup.boundingRadius = 0.0f;
+				myosinHeadGroup.vertexCount = 1;
+				//the head sprites are ten times their base point size
+				myosinHeadGroup.lodPointSize = sarcomere->myosinHeadRadius * 10.0f;
+				instanceCuller.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup);
+
+				//far segments of the filaments swap their detail for impostors baked from it, the selection and the
+				//color mapping treat them like the other instances
+				filamentImpostors.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup, actinColor);
+				filamentImpostors.setGroup(CullGroup::TROPONIN, troponinGroup, troponinColor);
+				filamentImpostors.setGroup(CullGroup::TROPOMYOSIN, tropomyosinGroup, tropomyosinColor);
+				filamentImpostors.setGroup(CullGroup::LMM, LMMGroup, LMMColor);
+				filamentImpostors.setGroup(CullGroup::HMM, HMMGroup, HMMColor);
+				filamentImpostors.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup, myosinHeadColor);
+				filamentImpostors.setHelices(!b_halfHelix);
+				if (lodSettings.impostors)
 				{
-					mRodShader.updateUniform("scaleWidthMatrix", scaleMyosinTrunkWidthMatrix);
+					filamentImpostors.update(*sarcomere);
 				}
-				else
+				CullGroupDescription actinImpostorGroup = filamentImpostors.getDescription(CullGroup::ACTIN_IMPOSTORS);
+				actinImpostorGroup.enabled = actinImpostorGroup.enabled && lodSettings.impostors;
+				CullGroupDescription myosinImpostorGroup = filamentImpostors.getDescription(CullGroup::MYOSIN_IMPOSTORS);
+				myosinImpostorGroup.enabled = myosinImpostorGroup.enabled && lodSettings.impostors;
+				instanceCuller.setGroup(CullGroup::ACTIN_IMPOSTORS, actinImpostorGroup);
+				instanceCuller.setGroup(CullGroup::MYOSIN_IMPOSTORS, myosinImpostorGroup);
+				instanceCuller.setImpostors(CullGroup::ACTIN_IMPOSTORS, actinImpostorGroup.enabled ? filamentImpostors.getLayout(CullGroup::ACTIN_IMPOSTORS) : ImpostorLayout());
+				instanceCuller.setImpostors(CullGroup::MYOSIN_IMPOSTORS, myosinImpostorGroup.enabled ? filamentImpostors.getLayout(CullGroup::MYOSIN_IMPOSTORS) : ImpostorLayout());
+
+				//bake the occlusion of the instances by the filaments, a few thousand instances per frame
+				CullGroupDescription actinOccluder = actinRodGroup;
+				actinOccluder.enabled = b_actin;
+				CullGroupDescription myosinOccluder = myosinRodGroup;
+				ambientOcclusion.setOccluders(actinOccluder, myosinOccluder, secondHalfRotationMatrix);
+				ambientOcclusion.setGroup(CullGroup::ACTIN_RODS, actinRodGroup);
+				ambientOcclusion.setGroup(CullGroup::MYOSIN_RODS, myosinRodGroup);
+				ambientOcclusion.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup);
+				ambientOcclusion.setGroup(CullGroup::TROPONIN, troponinGroup);
+				ambientOcclusion.update(ambientOcclusionSettings, sarcomere->d10);
+				if (!ambientOcclusion.isComplete())
 				{
-					mRodShader.updateUniform("scaleWidthMatrix", scaleMyosinWidthMatrix);
+					frameScheduler.invalidate();
 				}
-				mRodShader.updateUniform("viewMatrix", camera.view());
-				myosinRods->render(sarcomere->getNumMyosin());
-				if (b_highResMyosin)
+
+				//scalars of every structure for the color mapping
+				colorMapping.setLattice(actinOccluder, secondHalfRotationMatrix, midPoint, sarcomere->d10, sarcomere->sarcomereLength / 2.0f);
+				colorMapping.setGroup(CullGroup::ACTIN_RODS, actinRodGroup);
+				colorMapping.setGroup(CullGroup::MYOSIN_RODS, myosinRodGroup);
+				colorMapping.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup);
+				colorMapping.setGroup(CullGroup::TROPONIN, troponinGroup);
+				colorMapping.setGroup(CullGroup::TROPOMYOSIN, tropomyosinMoleculeGroup);
+				colorMapping.setGroup(CullGroup::LMM, LMMGroup);
+				colorMapping.setGroup(CullGroup::HMM, HMMGroup);
+				colorMapping.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup);
+				colorMapping.setGroup(CullGroup::ACTIN_IMPOSTORS, actinImpostorGroup);
+				colorMapping.setGroup(CullGroup::MYOSIN_IMPOSTORS, myosinImpostorGroup);
+				colorMapping.update(colorMappingSettings);
+
+				//visibility bits of the selected subsets, the culler drops the cleared ones
+				selectionMask.setLattice(secondHalfRotationMatrix, midPoint, sarcomere->d10);
+				selectionMask.setPicked(selectedElement.hit, glm::vec3(glm::inverse(rodRotationMatrix) * glm::vec4(selectedElement.position, 1.0f)));
+				selectionMask.setGroup(CullGroup::ACTIN_RODS, actinRodGroup);
+				selectionMask.setGroup(CullGroup::MYOSIN_RODS, myosinRodGroup);
+				selectionMask.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup);
+				selectionMask.setGroup(CullGroup::TROPONIN, troponinGroup);
+				selectionMask.setGroup(CullGroup::TROPOMYOSIN, tropomyosinMoleculeGroup);
+				selectionMask.setGroup(CullGroup::LMM, LMMGroup);
+				selectionMask.setGroup(CullGroup::HMM, HMMGroup);
+				selectionMask.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup);
+				selectionMask.setGroup(CullGroup::ACTIN_IMPOSTORS, actinImpostorGroup);
+				selectionMask.setGroup(CullGroup::MYOSIN_IMPOSTORS, myosinImpostorGroup);
+				//an impostor keeps one bit per baked structure, the hidden structures are cut out of it
+				for (CullGroup impostorGroup : { CullGroup::ACTIN_IMPOSTORS, CullGroup::MYOSIN_IMPOSTORS })
 				{
-					if (b_LMM)
-					{
-						//render first LMM Helix
-						LMMShader.use();
-						LMMShader.updateUniform("viewMatrix", camera.view());
-						sarcomere->bindLMM1Buffer();
-						glDrawArraysInstanced(GL_LINE_STRIP_ADJACENCY, 0, sarcomere->getNumPointsPerLMMHelix(), sarcomere->getNumLMMOffsetPositionsPerRod() * sarcomere->getNumMyosin());
+					const auto& slots = filamentImpostors.getSlots(impostorGroup);
+					selectionMask.setSlots(impostorGroup, std::vector<CullGroup>(slots.begin(), slots.end()));
+				}
+				if (selectionMask.update(selectionSettings))
+				{
+					instanceCuller.invalidate();
+					shadowMap.invalidate();
+				}
+				std::array<int, static_cast<int>(CullGroup::COUNT)> selectionOffsets;
+				std::array<int, static_cast<int>(CullGroup::COUNT)> selectionSlots;
+				for (int i = 0; i < static_cast<int>(CullGroup::COUNT); i++)
+				{
+					selectionOffsets[i] = selectionMask.getOffset(static_cast<CullGroup>(i));
+					selectionSlots[i] = selectionMask.getNumSlots(static_cast<CullGroup>(i));
+				}
+				//a strand spans many molecules, its vertex shader tests the bits of the molecules
+				selectionOffsets[static_cast<int>(CullGroup::TROPOMYOSIN)] = -1;
+				instanceCuller.setSelection(selectionMask.getBuffer(), selectionOffsets, selectionSlots);
+
+				//thin out the sprites by their size in window pixels, seen from the camera in every pass
+				float lodPixelScale = framebufferHeight * 0.7f * camera.projection()[1][1];
+				float lodTolerance = 0.05f * glm::length(camera.position - sarcomereCenter);
+				//the culler only splats if the splatter can draw them
+				LevelOfDetailSettings cullLodSettings = lodSettings;
+				cullLodSettings.splatSubPixel = lodSettings.splatSubPixel && spriteSplatter.isSupported();
+				instanceCuller.setLevelOfDetail(cullLodSettings, camera.position, lodPixelScale, lodTolerance);
+				spriteSplatter.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup, actinColor);
+				spriteSplatter.setGroup(CullGroup::TROPONIN, troponinGroup, troponinColor);
+				spriteSplatter.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup, myosinHeadColor);
+				spriteSplatter.setRotations(rodRotationMatrix, secondHalfRotationMatrix);
+				std::pair<ShaderProgram*, const CullGroupDescription*> lodSprites[] = { { &aSphereShader, &actinMonomerGroup },
+					{ &troponinShader, &troponinGroup }, { &myosinHeadShader, &myosinHeadGroup } };
+				for (auto& sprite : lodSprites)
+				{
+					sprite.first->updateUniform("lodPointSize", lodSettings.enabled ? sprite.second->lodPointSize : 0.0f);
+					sprite.first->updateUniform("lodEye", camera.position);
+					sprite.first->updateUniform("lodPixelScale", lodPixelScale);
+					sprite.first->updateUniform("lodTargetPixels", lodSettings.targetPixels);
+					sprite.first->updateUniform("lodMinFraction", lodSettings.minFraction);
+					sprite.first->updateUniform("lodFadeWidth", lodSettings.fadeWidth);
+				}
+				//the tropomyosin strands leave their pieces in the far segments to the actin impostors, measured from the
+				//eye of the culling pass which chose the impostors
+				ImpostorLayout actinImpostorLayout = filamentImpostors.getLayout(CullGroup::ACTIN_IMPOSTORS);
+				tropomyosinShader.updateUniform("impostorSegments", actinImpostorGroup.enabled ? actinImpostorLayout.numSegments : 0);
+				tropomyosinShader.updateUniform("impostorStart", actinImpostorLayout.start);
+				tropomyosinShader.updateUniform("impostorLength", actinImpostorLayout.length);
+				tropomyosinShader.updateUniform("impostorAxis", actinImpostorLayout.axis);
+				tropomyosinShader.updateUniform("impostorSize", actinImpostorLayout.size);
+				tropomyosinShader.updateUniform("impostorPixels", lodSettings.impostorPixels);
+				tropomyosinShader.updateUniform("lodEye", instanceCuller.getLevelOfDetailEye());
+				tropomyosinShader.updateUniform("lodPixelScale", lodPixelScale);
+
+				//world space points of the helices, stored once per culling pass
+				CullGroupDescription secondLMMGroup = LMMGroup;
+				secondLMMGroup.enabled = LMMGroup.enabled && !b_halfHelix;
+				CullGroupDescription secondHMMGroup = HMMGroup;
+				secondHMMGroup.enabled = HMMGroup.enabled && !b_halfHelix;
+				ribbonCache.setSlot(RibbonSlot::LMM_FIRST, LMMGroup);
+				ribbonCache.setSlot(RibbonSlot::LMM_SECOND, secondLMMGroup);
+				ribbonCache.setSlot(RibbonSlot::HMM_FIRST, HMMGroup);
+				ribbonCache.setSlot(RibbonSlot::HMM_SECOND, secondHMMGroup);
+				ribbonCache.setSlot(RibbonSlot::TROPOMYOSIN, tropomyosinGroup);
+				ribbonCache.update(ribbonCacheSettings);
+
+				//the ray tracer reads the cpu arrays of the sarcomere, built only when an image is requested
+				if (b_renderRayTraced)
+				{
+					rayTracer.setGroup(CullGroup::ACTIN_RODS, actinRodGroup);
+					rayTracer.setGroup(CullGroup::MYOSIN_RODS, myosinRodGroup);
+					rayTracer.setGroup(CullGroup::ACTIN_MONOMERS, actinMonomerGroup);
+					rayTracer.setGroup(CullGroup::TROPONIN, troponinGroup);
+					rayTracer.setGroup(CullGroup::TROPOMYOSIN, tropomyosinGroup);
+					rayTracer.setGroup(CullGroup::LMM, LMMGroup);
+					rayTracer.setGroup(CullGroup::HMM, HMMGroup);
+					rayTracer.setGroup(CullGroup::MYOSIN_HEADS, myosinHeadGroup);
+					rayTracer.setRotations(rodRotationMatrix, secondHalfRotationMatrix);
+				}
+			}
+			float sceneRadius = 1.1f * glm::length(glm::vec2(sarcomere->getRadius(), sarcomere->sarcomereLength / 2.0f));
+			//draws the sarcomere with the camera of the window or of a poster tile
+			auto renderScene = [&](const TileView& tileView)
+			{
+				instanceCuller.setSortView(overdrawSettings.frontToBack, tileView.view, sarcomereCenter, sceneRadius);
+				instanceCuller.update();
+				ribbonCache.setCullGeneration(instanceCuller.getGeneration());
+
+				//the shaders clip the straddling instances in view space
+				viewClipPlanes.clear();
+				glm::mat4 planeTransform = glm::transpose(glm::inverse(tileView.view));
+				for (const glm::vec4& plane : instanceCuller.getClipPlanes())
+				{
+					viewClipPlanes.push_back(planeTransform * plane);
+				}
+				int numClipPlanes = static_cast<int>(viewClipPlanes.size());
+				for (int i = 0; i < numClipPlanes; i++)
+				{
+					glEnable(GL_CLIP_DISTANCE0 + i);
+				}
+				for (ShaderProgram* shader : { &zBandShader, &aRodShader, &aSphereShader, &mRodShader, &tropomyosinShader, &LMMShader, &HMMShader, &myosinHeadShader, &troponinShader, &meshShader, &impostorShader })
+				{
+					shader->updateUniform("clipPlanes", viewClipPlanes.data(), numClipPlanes);
+					shader->updateUniform("numClipPlanes", numClipPlanes);
+					shader->updateUniform("projectionMatrix", tileView.projection);
+				}
+				for (ShaderProgram* shader : { &aSphereShader, &myosinHeadShader, &troponinShader })
+				{
+					shader->updateUniform("viewportY", tileView.spriteViewport);
+				}
+				//the tone art map of hatching or stippling stays bound on unit 0 for the whole scene
+				ToneArtMap& toneArtMap = shadingSettings.mode == ShadingSettings::STIPPLING ? stipplingTones : hatchingTones;
+				int shadingMode = shadingSettings.mode != ShadingSettings::PHONG && toneArtMap.getNumLayers() > 0 ? 1 : 0;
+				toneArtMap.bind(0);
+				for (ShaderProgram* shader : { &zBandShader, &aRodShader, &aSphereShader, &mRodShader, &tropomyosinShader, &LMMShader, &HMMShader, &troponinShader, &meshShader, &impostorShader })
+				{
+					shader->updateUniform("shadingMode", shadingMode);
+					shader->updateUniform("toneArtMap", 0);
+					shader->updateUniform("numToneLayers", toneArtMap.getNumLayers());
+					shader->updateUniform("toneScale", shadingSettings.toneScale);
+					shader->updateUniform("toneSpace", shadingSettings.toneSpace);
+				}
+				//the baked occlusion is read per instance
+				ambientOcclusion.bind();
+				aRodShader.updateUniform("occlusionOffset", ambientOcclusion.getOffset(CullGroup::ACTIN_RODS));
+				mRodShader.updateUniform("occlusionOffset", ambientOcclusion.getOffset(CullGroup::MYOSIN_RODS));
+				aSphereShader.updateUniform("occlusionOffset", ambientOcclusion.getOffset(CullGroup::ACTIN_MONOMERS));
+				troponinShader.updateUniform("occlusionOffset", ambientOcclusion.getOffset(CullGroup::TROPONIN));
+				//the transfer function stays bound on unit 2, structures without mapped scalars keep their color
+				colorMapping.bind(2);
+				float scalarRange = colorMapping.getRangeMax() - colorMapping.getRangeMin();
+				const std::array<std::pair<ShaderProgram*, CullGroup>, 8> mappedShaders = { {
+					{ &aRodShader, CullGroup::ACTIN_RODS }, { &mRodShader, CullGroup::MYOSIN_RODS }, { &aSphereShader, CullGroup::ACTIN_MONOMERS },
+					{ &troponinShader, CullGroup::TROPONIN }, { &tropomyosinShader, CullGroup::TROPOMYOSIN }, { &LMMShader, CullGroup::LMM },
+					{ &HMMShader, CullGroup::HMM }, { &myosinHeadShader, CullGroup::MYOSIN_HEADS } } };
+				for (const auto& mappedShader : mappedShaders)
+				{
+					mappedShader.first->updateUniform("scalarOffset", colorMapping.getOffset(mappedShader.second));
+					mappedShader.first->updateUniform("scalarMin", colorMapping.getRangeMin());
+					mappedShader.first->updateUniform("scalarRange", scalarRange != 0.0f ? scalarRange : 1.0f);
+					mappedShader.first->updateUniform("transferFunction", 2);
+				}
+				//the impostors and the tropomyosin strands read the bits of the selection mask themselves
+				if (selectionMask.getBuffer() != 0)
+				{
+					selectionMask.bind();
+				}
+				tropomyosinShader.updateUniform("selectionOffset", selectionMask.getBuffer() != 0 ? selectionMask.getOffset(CullGroup::TROPOMYOSIN) : -1);
+				//the impostors of both filaments share a shader, their offsets are set when they are drawn
+				impostorShader.updateUniform("scalarMin", colorMapping.getRangeMin());
+				impostorShader.updateUniform("scalarRange", scalarRange != 0.0f ? scalarRange : 1.0f);
+				impostorShader.updateUniform("transferFunction", 2);
+				//the cached shadow map stays bound on unit 1, the light is fixed in world space
+				shadowMap.bind(1);
+				glm::mat4 shadowMatrix = shadowMap.getShadowMatrix(tileView.view);
+				glm::vec3 lightDirection = glm::normalize(glm::mat3(tileView.view) * shadowSettings.getLightDirection());
+				for (ShaderProgram* shader : { &zBandShader, &aRodShader, &aSphereShader, &mRodShader, &tropomyosinShader, &LMMShader, &HMMShader, &troponinShader, &meshShader, &impostorShader })
+				{
+					shader->updateUniform("lightDirection", lightDirection);
+					shader->updateUniform("shadowMap", 1);
+					shader->updateUniform("shadowMatrix", shadowMatrix);
+					shader->updateUniform("shadowsEnabled", shadowSettings.enabled ? 1 : 0);
+					shader->updateUniform("shadowNormalOffset", shadowSettings.normalOffset * shadowMap.getTexelSize());
+				}
 
-						//render second LMM Helix
-						if (!b_halfHelix)
+				//the sprites of the actin monomers, troponin and myosin heads discard and write their depth, which
+				//makes them the most expensive fragments, they are drawn after everything else
+				auto drawSprites = [&]()
+				{
+					if (b_myosin && b_myosinDetail && b_myosinHeads)
+					{
+						//render myosin heads
+						myosinHeadShader.use();
+						myosinHeadShader.updateUniform("viewMatrix", tileView.view);
+						instanceCuller.drawArrays(CullGroup::MYOSIN_HEADS, GL_POINTS);
+					}
+					if (b_actin && b_actinDetail)
+					{
+						//render actin monomers
+						aSphereShader.use();
+						aSphereShader.updateUniform("viewMatrix", tileView.view);
+						instanceCuller.drawArrays(CullGroup::ACTIN_MONOMERS, GL_POINTS);
+						if (b_troponin)
 						{
-							LMMShader.use();
-							LMMShader.updateUniform("viewMatrix", camera.view());
-							sarcomere->bindLMM2Buffer();
-							glDrawArraysInstanced(GL_LINE_STRIP_ADJACENCY, 0, sarcomere->getNumPointsPerLMMHelix(), sarcomere->getNumLMMOffsetPositionsPerRod() * sarcomere->getNumMyosin());
+							//render troponin
+							troponinShader.use();
+							troponinShader.updateUniform("viewMatrix", tileView.view);
+							instanceCuller.drawArrays(CullGroup::TROPONIN, GL_POINTS);
 						}
 					}
-					if (b_HMM)
+				};
+				//depth only pre-pass of the sprites, the depth variants compute the same depth as the full shaders,
+				//so the color pass only shades the front most sprite fragment of each pixel
+				bool b_spritePrePass = overdrawSettings.depthPrePass && !ShaderProgram::isDepthPass();
+				if (b_spritePrePass)
+				{
+					ShaderProgram::setDepthPass(true);
+					glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+					//the heatmap only counts the shaded fragments
+					glStencilMask(0x00);
+					glBindVertexArray(vao);
+					drawSprites();
+					glStencilMask(0xFF);
+					glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+					ShaderProgram::setDepthPass(false);
+				}
+
+				//render data
+				//render zDiscs
+				zBandShader.use();
+				zBandShader.updateUniform("viewMatrix", tileView.view);
+				zDiscs->render(sarcomere->getNumZdiscs());
+				//bind empty vao because otherwise it binds a wrong one
+				glBindVertexArray(vao);
+
+				//render all imported meshes with one draw call
+				meshShader.use();
+				meshShader.updateUniform("viewMatrix", tileView.view);
+				meshRenderer.render();
+
+				//render Myosin
+				if (b_myosin)
+				{
+					mRodShader.use();
+					if (b_myosinDetail)
+					{
+						mRodShader.updateUniform("scaleWidthMatrix", scaleMyosinTrunkWidthMatrix);
+					}
+					else
+					{
+						mRodShader.updateUniform("scaleWidthMatrix", scaleMyosinWidthMatrix);
+					}
+					mRodShader.updateUniform("viewMatrix", tileView.view);
+					instanceCuller.drawElements(CullGroup::MYOSIN_RODS, myosinRods->getVAO());
+					if (b_myosinDetail)
 					{
-						//render first HMM Helix
-						HMMShader.use();
-						HMMShader.updateUniform("viewMatrix", camera.view());
-						sarcomere->bindHMM1Buffer();
-						glDrawArraysInstanced(GL_LINE_STRIP_ADJACENCY, 0, sarcomere->getNumPointsPerHMMHelix(), sarcomere->getNumHMMOffsetPositionsPerRod() * sarcomere->getNumMyosin());
+						if (b_LMM)
+						{
+							//render first LMM Helix
+							LMMShader.use();
+							LMMShader.updateUniform("viewMatrix", tileView.view);
+							sarcomere->bindLMM1Buffer();
+							ribbonCache.bind(RibbonSlot::LMM_FIRST, LMMShader);
+							instanceCuller.drawArrays(CullGroup::LMM, GL_LINE_STRIP_ADJACENCY);
 
-						//render second HMM Helix
-						if (!b_halfHelix)
+							//render second LMM Helix
+							if (!b_halfHelix)
+							{
+								LMMShader.use();
+								LMMShader.updateUniform("viewMatrix", tileView.view);
+								sarcomere->bindLMM2Buffer();
+								ribbonCache.bind(RibbonSlot::LMM_SECOND, LMMShader);
+								instanceCuller.drawArrays(CullGroup::LMM, GL_LINE_STRIP_ADJACENCY);
+							}
+						}
+						if (b_HMM)
 						{
+							//render first HMM Helix
 							HMMShader.use();
-							HMMShader.updateUniform("viewMatrix", camera.view());
-							sarcomere->bindHMM2Buffer();
-							glDrawArraysInstanced(GL_LINE_STRIP_ADJACENCY, 0, sarcomere->getNumPointsPerHMMHelix(), sarcomere->getNumHMMOffsetPositionsPerRod() * sarcomere->getNumMyosin());
+							HMMShader.updateUniform("viewMatrix", tileView.view);
+							sarcomere->bindHMM1Buffer();
+							ribbonCache.bind(RibbonSlot::HMM_FIRST, HMMShader);
+							instanceCuller.drawArrays(CullGroup::HMM, GL_LINE_STRIP_ADJACENCY);
+
+							//render second HMM Helix
+							if (!b_halfHelix)
+							{
+								HMMShader.use();
+								HMMShader.updateUniform("viewMatrix", tileView.view);
+								sarcomere->bindHMM2Buffer();
+								ribbonCache.bind(RibbonSlot::HMM_SECOND, HMMShader);
+								instanceCuller.drawArrays(CullGroup::HMM, GL_LINE_STRIP_ADJACENCY);
+							}
 						}
 					}
-					if (b_myosinHeads)
+
+				}
+				//render actin
+				if (b_actin)
+				{
+					//if high res render double helix actin structure
+					if (b_actinDetail)
 					{
-						//render myosin heads
-						myosinHeadShader.use();
-						myosinHeadShader.updateUniform("viewMatrix", camera.view());
-						glDrawArraysInstanced(GL_POINTS, 0, 1, sarcomere->getNumMyosin() * sarcomere->getNumMyosinHeads());
+						if (b_tropomyosin)
+						{
+							//render tropomyosin
+							tropomyosinShader.use();
+							tropomyosinShader.updateUniform("viewMatrix", tileView.view);
+							sarcomere->bindTropomyosinBuffer();
+							ribbonCache.bind(RibbonSlot::TROPOMYOSIN, tropomyosinShader);
+							instanceCuller.drawArrays(CullGroup::TROPOMYOSIN, GL_LINE_STRIP_ADJACENCY);
+						}
+					}
+					//if no high res render simple actin rod structure
+					else
+					{
+						//render actin rods
+						aRodShader.use();
+						aRodShader.updateUniform("viewMatrix", tileView.view);
+						instanceCuller.drawElements(CullGroup::ACTIN_RODS, actinRods->getVAO());
 					}
-				}
 
-			}
-			//render actin
-			if (b_actin)
-			{
-				//if high res render double helix actin structure
-				if (b_highResActin)
+				}
+				//impostors of the far filament segments, texture unit 3 holds the atlas
+				for (CullGroup impostorGroup : { CullGroup::ACTIN_IMPOSTORS, CullGroup::MYOSIN_IMPOSTORS })
 				{
-					//render actin monomers
-					aSphereShader.use();
-					aSphereShader.updateUniform("viewMatrix", camera.view());
-					glDrawArraysInstanced(GL_POINTS, 0, 1, (sarcomere->getNumActin() * sarcomere->getNumActinParticles()) / 2);
-					if (b_troponin)
+					if (filamentImpostors.bind(impostorGroup, impostorShader, 3))
 					{
-						//render troponin
-						troponinShader.use();
-						troponinShader.updateUniform("viewMatrix", camera.view());
-						glDrawArraysInstanced(GL_POINTS, 0, 1, (sarcomere->getNumActin() / 2) * sarcomere->getNumTroponinParticles());
+						impostorShader.use();
+						impostorShader.updateUniform("viewMatrix", tileView.view);
+						impostorShader.updateUniform("scalarOffset", colorMapping.getOffset(impostorGroup));
+						impostorShader.updateUniform("selectionOffset", selectionMask.getBuffer() != 0 ? selectionMask.getOffset(impostorGroup) : -1);
+						impostorShader.updateUniform("selectionSlots", selectionMask.getNumSlots(impostorGroup));
+						impostorShader.updateUniform("rotationMatrix", rodRotationMatrix);
+						impostorShader.updateUniform("secondHalfRotationMatrix", secondHalfRotationMatrix);
+						glBindVertexArray(vao);
+						instanceCuller.drawArrays(impostorGroup, GL_TRIANGLE_STRIP);
 					}
-					if (b_tropomyosin)
+				}
+				if (b_spritePrePass)
+				{
+					glDepthFunc(GL_LEQUAL);
+					glDepthMask(GL_FALSE);
+				}
+				drawSprites();
+				glDepthFunc(GL_LESS);
+				glDepthMask(GL_TRUE);
+				//the sprites the culler classified as smaller than a pixel
+				spriteSplatter.render(instanceCuller, tileView.view, tileView.projection, instanceCuller.getClipPlanes(),
+					{ colorMapping.getOffset(CullGroup::ACTIN_MONOMERS), colorMapping.getOffset(CullGroup::TROPONIN),
+					colorMapping.getOffset(CullGroup::MYOSIN_HEADS) }, colorMapping.getRangeMin(), scalarRange, 2);
+				for (int i = 0; i < numClipPlanes; i++)
+				{
+					glDisable(GL_CLIP_DISTANCE0 + i);
+				}
+			};
+			if (crossSectionSettings.enabled)
+			{
+				//the grid is only built while the section is shown
+				crossSection.setDimensions(midPoint, sarcomere->d10, sarcomere->sarcomereLength, sarcomere->actinLength, sarcomere->myosinLength,
+					sarcomere->actinRadius, sarcomere->myosinRadius);
+				if (crossSection.needsFilaments())
+				{
+					crossSection.setFilaments(sarcomere->getActinRods(), sarcomere->getMyosinRods(), secondHalfRotationMatrix);
+				}
+				crossSection.render(crossSectionSettings, sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight(), actinColor, myosinColor);
+			}
+			else
+			{
+				//hidden structures and moved clipping planes change the casters
+				std::vector<bool> shownStructures = { b_actin, b_actinDetail, b_troponin, b_tropomyosin, b_myosin, b_myosinDetail,
+					b_LMM, b_HMM, b_halfHelix, b_myosinHeads, lodSettings.impostors };
+				if (shownStructures != shadowStructures || instanceCuller.getClipPlanes() != shadowClipPlanes)
+				{
+					shadowStructures = shownStructures;
+					shadowClipPlanes = instanceCuller.getClipPlanes();
+					shadowMap.invalidate();
+				}
+				//render the shadow map from the light if the cached one is outdated
+				if (shadowSettings.enabled && shadowMap.needsUpdate(shadowSettings, sarcomereCenter, sceneRadius))
+				{
+					ShaderProgram::setDepthPass(true);
+					renderScene(shadowMap.begin());
+					ShaderProgram::setDepthPass(false);
+					shadowMap.end();
+					sceneFramebuffer.bind();
+				}
+				overdrawMeter.begin(overdrawSettings);
+				renderScene({ camera.view(), TemporalAA::jitterProjection(camera.projection(), jitter, sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight()), sceneFramebuffer.getWidth() });
+				overdrawMeter.end(overdrawSettings, sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight());
+
+				if (b_renderPoster)
+				{
+					b_renderPoster = false;
+					//a poster keeps the vertical field of view of the camera and widens or narrows it horizontally
+					glm::mat4 posterProjection = camera.projection();
+					posterProjection[0][0] = posterProjection[1][1] * posterSettings.height / posterSettings.width;
+					TiledRenderer tiledRenderer(posterSettings.tileSize, posterSettings.guardBand);
+					if (tiledRenderer.render(posterPath.c_str(), posterSettings.width, posterSettings.height, camera.view(), posterProjection,
+						posterSettings.width, posterSettings.dpi, instanceCuller, renderScene))
 					{
-						//render tropomyosin
-						tropomyosinShader.use();
-						tropomyosinShader.updateUniform("viewMatrix", camera.view());
-						sarcomere->bindTropomyosinBuffer();
-						int test = (static_cast<int>(sarcomere->getNumActinParticles() / 2 / 7) / 2) * 2;
-						glDrawArraysInstanced(GL_LINE_STRIP_ADJACENCY, 0, 9, (sarcomere->getNumActin() / 2) * sarcomere->getNumLineSegments());
+						std::cout << "Poster saved to " << posterPath << std::endl;
 					}
+					sceneFramebuffer.bind();
 				}
-				//if no high res render simple actin rod structure
-				else
+
+				if (b_renderRayTraced)
 				{
-					//render actin rods
-					aRodShader.use();
-					aRodShader.updateUniform("viewMatrix", camera.view());
-					actinRods->render(sarcomere->getNumActin());
+					b_renderRayTraced = false;
+					//same camera and clipping as the rasterized image, the field of view follows the poster
+					glm::mat4 rayTracedProjection = camera.projection();
+					rayTracedProjection[0][0] = rayTracedProjection[1][1] * rayTracerSettings.height / rayTracerSettings.width;
+					rayTracer.setClipPlanes(instanceCuller.getClipPlanes());
+					rayTracer.setTiles(&latticeTiles);
+					rayTracer.build(*sarcomere, !b_halfHelix);
+					if (rayTracer.render(rayTracedPath.c_str(), rayTracerSettings, camera.view(), rayTracedProjection, shadowSettings.getLightDirection(), glm::vec3(1.0f)))
+					{
+						std::cout << "Ray traced image saved to " << rayTracedPath << std::endl;
+					}
 				}
-
 			}
+			ribbonCache.endFrame();
 		}
 		/*if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS)
 		{
@@ -980,9 +2325,54 @@ int main() {
 			myosinHeadShader.reload(1);
 			troponinShader.reload(1);	
 		}*/
+		//resolve the scene, queue the readback of the element below the cursor and show the frame
+		if (b_renderScene)
+		{
+			sceneFramebuffer.resolve();
+			if (b_temporalAA)
+			{
+				temporalAA.resolve(sceneFramebuffer.getColorTexture(), sceneFramebuffer.getDepthTexture(), sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight(),
+					framebufferWidth, framebufferHeight, camera.projection() * camera.view(), jitter, antiAliasingSettings.feedback);
+			}
+			dynamicResolution.endFrame(dynamicResolutionSettings);
+		}
+		GLuint outputFBO = sceneFramebuffer.getResolvedFBO();
+		int outputWidth = sceneFramebuffer.getWidth();
+		int outputHeight = sceneFramebuffer.getHeight();
+		if (b_temporalAA)
+		{
+			outputFBO = temporalAA.getOutputFBO();
+			outputWidth = temporalAA.getOutputWidth();
+			outputHeight = temporalAA.getOutputHeight();
+		}
+		//record the scene without the gui, the readback finishes a few frames later
+		videoCapture.captureFrame(outputFBO, outputWidth, outputHeight, glfwGetTime());
+		videoCapture.update();
+		if (!ImGui::GetIO().WantCaptureMouse)
+		{
+			double cursorX, cursorY;
+			int windowWidth, windowHeight;
+			glfwGetCursorPos(window, &cursorX, &cursorY);
+			glfwGetWindowSize(window, &windowWidth, &windowHeight);
+			int pickX = static_cast<int>(cursorX * sceneFramebuffer.getWidth() / glm::max(windowWidth, 1));
+			int pickY = sceneFramebuffer.getHeight() - 1 - static_cast<int>(cursorY * sceneFramebuffer.getHeight() / glm::max(windowHeight, 1));
+			picker.requestPick(sceneFramebuffer.getResolvedFBO(), pickX, pickY, sceneFramebuffer.getWidth(), sceneFramebuffer.getHeight(), camera.projection() * camera.view());
+		}
+		else
+		{
+			hoveredElement = PickResult();
+		}
+		if (b_temporalAA)
+		{
+			temporalAA.blitToScreen(framebufferWidth, framebufferHeight);
+		}
+		else
+		{
+			sceneFramebuffer.blitToScreen(framebufferWidth, framebufferHeight);
+		}
 		gui->render();
-		glfwPollEvents();
 		glfwSwapBuffers(window);
+		frameScheduler.waitForNextFrame(renderOnDemandSettings);
 	}
 	glfwDestroyWindow(window);
 }
\ No newline at end of file
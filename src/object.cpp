@@ -94,5 +94,7 @@ void Object::setModelMatrix(glm::mat4 modelMatrix)
 void Object::render()
 {
 	Renderer renderer;
-	renderer.createObjectBuffers(*this);
+	int materialIndex = renderer.addMaterials(&m_materials);
+	renderer.addObject(*this, materialIndex);
+	renderer.render();
 }
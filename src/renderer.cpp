@@ -1,4 +1,5 @@
 #include "renderer.h"
+#include <algorithm>
 
 Renderer::Renderer()
 {
@@ -6,111 +7,202 @@ Renderer::Renderer()
 
 Renderer::~Renderer()
 {
+	deleteObjectBuffers();
+	glDeleteBuffers(1, &m_ssbo_material_handel);
+	for (const Material& material : m_materials)
+	{
+		if (material.textureAddress != 0)
+		{
+			glMakeTextureHandleNonResidentARB(material.textureAddress);
+		}
+	}
+	glDeleteTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
 }
 
-void Renderer::createObjectBuffers(Object object)
+void Renderer::addObject(Object& object, int materialIndex)
 {
+	DrawCommand command;
+	command.first = static_cast<GLuint>(m_indices.size());
+	command.baseVertex = static_cast<GLint>(m_vertices.size());
+	command.instanceCount = 1;
+	//the draw index is also stored as base instance for drivers without gl_DrawID
+	command.baseInstance = static_cast<GLuint>(m_commands.size());
 	if (object.getMeshType() == MeshType::Triangle)
 	{
-		m_points = object.getTriangleMesh().vertices.size();
-		m_indices = object.getTriangleMesh().indices.size();
-
-		glGenBuffers(1, &m_vertexbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(Vertex), &object.getTriangleMesh().vertices[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_normalbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(glm::vec3), &object.getTriangleMesh().normals[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_uvbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(glm::vec2), &object.getTriangleMesh().uvcoords[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_indexlist);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexlist);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices * sizeof(unsigned int), &object.getTriangleMesh().indices[0], GL_STATIC_DRAW);
-
-		glGenVertexArrays(1, &m_vao);
-		glBindVertexArray(m_vao);
-
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
-
-		glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
-
-		glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), 0);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexlist);
-
-		glBindVertexArray(0);
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
+		TriangleMesh mesh = object.getTriangleMesh();
+		for (int i = 0; i < static_cast<int>(mesh.vertices.size()); i++)
+		{
+			RenderVertex vertex;
+			vertex.position = glm::vec4(mesh.vertices[i].position, 1.0f);
+			vertex.normal = glm::vec4(glm::vec3(mesh.normals[i]), 0.0f);
+			vertex.uv = mesh.uvcoords[i];
+			vertex.padding = glm::vec2(0.0f);
+			m_vertices.push_back(vertex);
+		}
+		m_indices.insert(m_indices.end(), mesh.indices.begin(), mesh.indices.end());
+		command.count = static_cast<GLuint>(mesh.indices.size());
 	}
 	else if (object.getMeshType() == MeshType::Quad)
 	{
-		m_points = object.getQuadMesh().vertices.size();
-		m_indices = object.getQuadMesh().indices.size();
-
-		glGenBuffers(1, &m_vertexbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(glm::vec4), &object.getQuadMesh().vertices[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_normalbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(glm::vec4), &object.getQuadMesh().normals[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_uvbuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-		glBufferData(GL_ARRAY_BUFFER, m_points * sizeof(glm::vec2), &object.getQuadMesh().uvcoords[0], GL_STATIC_DRAW);
-
-		glGenBuffers(1, &m_indexlist);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexlist);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices * sizeof(unsigned int), &object.getQuadMesh().indices[0], GL_STATIC_DRAW);
+		QuadMesh mesh = object.getQuadMesh();
+		for (int i = 0; i < static_cast<int>(mesh.vertices.size()); i++)
+		{
+			RenderVertex vertex;
+			vertex.position = mesh.vertices[i];
+			vertex.normal = glm::vec4(glm::vec3(mesh.normals[i]), 0.0f);
+			vertex.uv = mesh.uvcoords[i];
+			vertex.padding = glm::vec2(0.0f);
+			m_vertices.push_back(vertex);
+		}
+		//split every quad along its first diagonal
+		for (int i = 0; i + 3 < static_cast<int>(mesh.indices.size()); i += 4)
+		{
+			m_indices.insert(m_indices.end(), { mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2], mesh.indices[i], mesh.indices[i + 2], mesh.indices[i + 3] });
+		}
+		command.count = static_cast<GLuint>(mesh.indices.size() / 4 * 6);
+	}
+	if (command.count == 0)
+	{
+		return;
+	}
+	m_commands.push_back(command);
+	DrawRecord record;
+	record.modelMatrix = object.getModelMatrix();
+	record.materialIndex = materialIndex;
+	m_drawRecords.push_back(record);
+	m_objectsChanged = true;
+}
 
-		glGenVertexArrays(1, &m_vao);
-		glBindVertexArray(m_vao);
+int Renderer::addMaterials(std::vector<Material>* materials)
+{
+	int first = static_cast<int>(m_materials.size());
+	m_materials.insert(m_materials.end(), materials->begin(), materials->end());
+	m_materialNames.resize(m_materials.size());
+	m_materialsChanged = true;
+	return first;
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexbuffer);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+int Renderer::loadTextures(const std::filesystem::path& directory)
+{
+	int first = static_cast<int>(m_materials.size());
+	std::vector<std::filesystem::path> paths;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (entry.path().extension() == ".png" || entry.path().extension() == ".jpg")
+		{
+			paths.push_back(entry.path());
+		}
+	}
+	//sorted, so the material indices do not depend on the file system
+	std::sort(paths.begin(), paths.end());
+	for (const std::filesystem::path& path : paths)
+	{
+		GLuint texture = 0;
+		Material material = FileLoader::loadImage(path, 0, 0, &texture);
+		if (texture == 0)
+		{
+			continue;
+		}
+		m_textures.push_back(texture);
+		m_materials.push_back(material);
+		m_materialNames.push_back(path.stem().string());
+	}
+	m_materialsChanged = true;
+	return first;
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_normalbuffer);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+int Renderer::getMaterialIndex(const std::string& name)
+{
+	auto it = std::find(m_materialNames.begin(), m_materialNames.end(), name);
+	return it == m_materialNames.end() ? -1 : static_cast<int>(it - m_materialNames.begin());
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_uvbuffer);
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, 0);
+std::vector<std::string> Renderer::getMaterialNames()
+{
+	return m_materialNames;
+}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexlist);
+int Renderer::getNumObjects()
+{
+	return static_cast<int>(m_commands.size());
+}
 
-		glBindVertexArray(0);
+void Renderer::createObjectBuffers()
+{
+	deleteObjectBuffers();
+	glCreateBuffers(1, &m_vertexbuffer);
+	glNamedBufferStorage(m_vertexbuffer, m_vertices.size() * sizeof(RenderVertex), m_vertices.data(), 0);
+	glCreateBuffers(1, &m_indexlist);
+	glNamedBufferStorage(m_indexlist, m_indices.size() * sizeof(unsigned int), m_indices.data(), 0);
+	glCreateBuffers(1, &m_drawRecordBuffer);
+	glNamedBufferStorage(m_drawRecordBuffer, m_drawRecords.size() * sizeof(DrawRecord), m_drawRecords.data(), 0);
+	glCreateBuffers(1, &m_commandBuffer);
+	glNamedBufferStorage(m_commandBuffer, m_commands.size() * sizeof(DrawCommand), m_commands.data(), 0);
+
+	glCreateVertexArrays(1, &m_vao);
+	glVertexArrayVertexBuffer(m_vao, 0, m_vertexbuffer, 0, sizeof(RenderVertex));
+	glVertexArrayElementBuffer(m_vao, m_indexlist);
+	glEnableVertexArrayAttrib(m_vao, 0);
+	glVertexArrayAttribFormat(m_vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(RenderVertex, position));
+	glVertexArrayAttribBinding(m_vao, 0, 0);
+	glEnableVertexArrayAttrib(m_vao, 1);
+	glVertexArrayAttribFormat(m_vao, 1, 4, GL_FLOAT, GL_FALSE, offsetof(RenderVertex, normal));
+	glVertexArrayAttribBinding(m_vao, 1, 0);
+	glEnableVertexArrayAttrib(m_vao, 2);
+	glVertexArrayAttribFormat(m_vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(RenderVertex, uv));
+	glVertexArrayAttribBinding(m_vao, 2, 0);
+	m_objectsChanged = false;
+}
 
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
+void Renderer::createMaterialBuffer()
+{
+	glDeleteBuffers(1, &m_ssbo_material_handel);
+	//draw records may index a material that has not been added yet, keep at least the default one
+	std::vector<Material> materials = m_materials;
+	if (materials.empty())
+	{
+		materials.push_back(Material());
 	}
-
+	glCreateBuffers(1, &m_ssbo_material_handel);
+	glNamedBufferStorage(m_ssbo_material_handel, sizeof(Material) * materials.size(), materials.data(), 0);
+	m_materialsChanged = false;
 }
 
-void Renderer::createMaterialBuffer(std::vector<Material>* materials)
+void Renderer::deleteObjectBuffers()
 {
-	glCreateBuffers(1, &m_ssbo_material_handel);
-	glNamedBufferStorage(m_ssbo_material_handel, sizeof(Material) * materials->size(), &materials->at(0), NULL);
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vertexbuffer);
+	glDeleteBuffers(1, &m_indexlist);
+	glDeleteBuffers(1, &m_drawRecordBuffer);
+	glDeleteBuffers(1, &m_commandBuffer);
+	m_vao = 0;
+	m_vertexbuffer = 0;
+	m_indexlist = 0;
+	m_drawRecordBuffer = 0;
+	m_commandBuffer = 0;
 }
 
-void Renderer::render(Object object)
+void Renderer::render()
 {
+	if (m_commands.empty())
+	{
+		return;
+	}
+	if (m_objectsChanged)
+	{
+		createObjectBuffers();
+	}
+	if (m_materialsChanged || m_ssbo_material_handel == 0)
+	{
+		createMaterialBuffer();
+	}
+	int last_vao = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
 	glBindVertexArray(m_vao);
-	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_ssbo_material_handel);
-	glDrawElements(GL_TRIANGLES, m_indices, GL_UNSIGNED_INT, 0);
-	//glDrawArrays(GL_TRIANGLES, 0, 24);
-	//glDrawElements(GL_TRIANGLES, m_indices, GL_UNSIGNED_INT, &m_indices);
+	//the sarcomere binds its buffers only once per frame, so the meshes must not overwrite any of them
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 18, m_ssbo_material_handel);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, m_drawRecordBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_commands.size()), 0);
+	glBindVertexArray(last_vao);
 }
@@ -2,24 +2,74 @@
 
 #include "definitions.h"
 #include "fileLoader.h"
+#include <string>
 
+//interleaved vertex of the merged mesh buffer
+struct RenderVertex
+{
+	glm::vec4 position;
+	glm::vec4 normal;
+	glm::vec2 uv;
+	glm::vec2 padding;
+};
+
+//per draw data, indexed with gl_DrawID, matches the std430 layout of the mesh shader
+struct DrawRecord
+{
+	glm::mat4 modelMatrix;
+	int materialIndex;
+	int padding[3];
+};
+
+// Draws every added object with a single multi draw call.
+// All meshes share one vertex and one index buffer, all materials one ssbo (binding 18) whose
+// textures are resident bindless handles, so neither the number of objects nor the number of
+// textures adds draw calls or texture binds. The draw records (binding 19) hold the model matrix
+// and material index of every object.
 class Renderer
 {
 public:
 	Renderer();
 	~Renderer();
-	void createObjectBuffers(Object object);
-	void createMaterialBuffer(std::vector<Material>* materials);
-	void render(Object object);
+	// Appends the mesh of the object, quads are split into two triangles
+	// * int materialIndex - index into the material buffer, see addMaterials() and loadTextures()
+	void addObject(Object& object, int materialIndex);
+	// Appends materials and returns the index of the first one
+	int addMaterials(std::vector<Material>* materials);
+	// Loads every png and jpg of the directory as a textured material, returns the index of the first one
+	int loadTextures(const std::filesystem::path& directory);
+	// Returns the material index of a texture loaded by loadTextures(), -1 if there is none
+	// * const std::string& name - file name without extension, e.g. "hatch_0"
+	int getMaterialIndex(const std::string& name);
+	std::vector<std::string> getMaterialNames();
+	int getNumObjects();
+	// Uploads the added objects and materials if anything changed and draws all objects
+	void render();
 private:
-	GLuint m_vao;
-	GLuint m_tex;
-	GLuint m_ssbo_material_handel;
-	GLuint m_vertexbuffer;
-	GLuint m_positionBuffer;
-	GLuint m_normalbuffer;
-	GLuint m_uvbuffer;
-	GLuint m_indexlist;
-	int m_points;
-	int m_indices;
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+	void createObjectBuffers();
+	void createMaterialBuffer();
+	void deleteObjectBuffers();
+	GLuint m_vao = 0;
+	GLuint m_ssbo_material_handel = 0;
+	GLuint m_vertexbuffer = 0;
+	GLuint m_indexlist = 0;
+	GLuint m_drawRecordBuffer = 0;
+	GLuint m_commandBuffer = 0;
+	std::vector<RenderVertex> m_vertices;
+	std::vector<unsigned int> m_indices;
+	std::vector<DrawRecord> m_drawRecords;
+	std::vector<DrawCommand> m_commands;
+	std::vector<Material> m_materials;
+	std::vector<std::string> m_materialNames;
+	std::vector<GLuint> m_textures;
+	bool m_objectsChanged = false;
+	bool m_materialsChanged = false;
 };
@@ -1,5 +1,7 @@
 #include "ShaderProgram.h"
 
+bool ShaderProgram::s_depthPass = false;
+
 ShaderProgram::ShaderProgram(const char* vertexpath, const char* fragmentpath)
 {
 	GLuint vertexShader = createShader(vertexpath, GL_VERTEX_SHADER);
@@ -48,11 +50,42 @@ ShaderProgram::~ShaderProgram()
 {
 	glUseProgram(0);
 	glDeleteProgram(m_program);
+	glDeleteProgram(m_depthProgram);
 }
 
 void ShaderProgram::use()
 {
-	glUseProgram(m_program);
+	glUseProgram(s_depthPass && m_depthProgram != 0 ? m_depthProgram : m_program);
+}
+
+void ShaderProgram::addDepthVariant(const char* fragmentpath)
+{
+	glDeleteProgram(m_depthProgram);
+	GLuint vertexShader = createShader(m_vertexPath, GL_VERTEX_SHADER);
+	GLuint fragmentShader = createShader(fragmentpath, GL_FRAGMENT_SHADER);
+	GLuint geometryShader = m_geometryPath ? createShader(m_geometryPath, GL_GEOMETRY_SHADER) : 0;
+	m_depthProgram = glCreateProgram();
+	glAttachShader(m_depthProgram, vertexShader);
+	glAttachShader(m_depthProgram, fragmentShader);
+	if (geometryShader != 0)
+	{
+		glAttachShader(m_depthProgram, geometryShader);
+	}
+	glLinkProgram(m_depthProgram);
+	checkProgramStatus(m_depthProgram);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	glDeleteShader(geometryShader);
+}
+
+void ShaderProgram::setDepthPass(bool depthPass)
+{
+	s_depthPass = depthPass;
+}
+
+bool ShaderProgram::isDepthPass()
+{
+	return s_depthPass;
 }
 
 GLuint ShaderProgram::getProgram()
@@ -109,37 +142,90 @@ void ShaderProgram::loadFromSource(const char* path, GLuint shaderID) {
 
 void ShaderProgram::updateUniform(const GLchar* name, glm::mat4 m)
 {
-	GLint loc = findUniform(name);
-	glUseProgram(m_program);
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(m));
+	glProgramUniformMatrix4fv(m_program, findUniform(name), 1, GL_FALSE, glm::value_ptr(m));
+	if (m_depthProgram != 0)
+	{
+		glProgramUniformMatrix4fv(m_depthProgram, findDepthUniform(name), 1, GL_FALSE, glm::value_ptr(m));
+	}
+	use();
 }
 
 void ShaderProgram::updateUniform(const GLchar* name, glm::vec4 v)
 {
-	GLint loc = findUniform(name);
-	glUseProgram(m_program);
-	glUniform4fv(loc, 1, glm::value_ptr(v));
+	glProgramUniform4fv(m_program, findUniform(name), 1, glm::value_ptr(v));
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform4fv(m_depthProgram, findDepthUniform(name), 1, glm::value_ptr(v));
+	}
+	use();
 }
 
 void ShaderProgram::updateUniform(const GLchar* name, glm::vec3 v)
 {
-	GLint loc = findUniform(name);
-	glUseProgram(m_program);
-	glUniform3fv(loc, 1, glm::value_ptr(v));
+	glProgramUniform3fv(m_program, findUniform(name), 1, glm::value_ptr(v));
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform3fv(m_depthProgram, findDepthUniform(name), 1, glm::value_ptr(v));
+	}
+	use();
+}
+
+void ShaderProgram::updateUniform(const GLchar* name, glm::vec2 v)
+{
+	glProgramUniform2fv(m_program, findUniform(name), 1, glm::value_ptr(v));
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform2fv(m_depthProgram, findDepthUniform(name), 1, glm::value_ptr(v));
+	}
+	use();
 }
 
 void ShaderProgram::updateUniform(const GLchar* name, float f)
 {
-	GLint loc = findUniform(name);
-	glUseProgram(m_program);
-	glUniform1f(loc, f);
+	glProgramUniform1f(m_program, findUniform(name), f);
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform1f(m_depthProgram, findDepthUniform(name), f);
+	}
+	use();
 }
 
 void ShaderProgram::updateUniform(const GLchar* name, int i)
 {
-	GLint loc = findUniform(name);
-	glUseProgram(m_program);
-	glUniform1i(loc, i);
+	glProgramUniform1i(m_program, findUniform(name), i);
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform1i(m_depthProgram, findDepthUniform(name), i);
+	}
+	use();
+}
+
+void ShaderProgram::updateUniform(const GLchar* name, const glm::vec4* v, int count)
+{
+	if (count < 1)
+	{
+		return;
+	}
+	glProgramUniform4fv(m_program, findUniform(name), count, glm::value_ptr(*v));
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform4fv(m_depthProgram, findDepthUniform(name), count, glm::value_ptr(*v));
+	}
+	use();
+}
+
+void ShaderProgram::updateUniform(const GLchar* name, const int* v, int count)
+{
+	if (count < 1)
+	{
+		return;
+	}
+	glProgramUniform1iv(m_program, findUniform(name), count, v);
+	if (m_depthProgram != 0)
+	{
+		glProgramUniform1iv(m_depthProgram, findDepthUniform(name), count, v);
+	}
+	use();
 }
 
 GLint ShaderProgram::findUniform(const GLchar* name)
@@ -151,6 +237,11 @@ GLint ShaderProgram::findUniform(const GLchar* name)
 	return loc;
 }
 
+GLint ShaderProgram::findDepthUniform(const GLchar* name)
+{
+	return glGetUniformLocation(m_depthProgram, name);
+}
+
 void ShaderProgram::checkShaderStatus(GLuint shaderID)
 {
 	GLint status;
@@ -11,27 +11,41 @@ public:
 	ShaderProgram(const char* comutepath);
 	~ShaderProgram();
 
+	// Binds the program, or its depth only variant during a depth pass
 	void use();
 	GLuint getProgram();
 	void reload(int type);
+	// Links a second program from the same vertex and geometry shader with a depth only fragment shader.
+	// Uniforms are updated on both programs, so the variant always matches the state of the full program.
+	void addDepthVariant(const char* fragmentpath);
+	// While set, use() binds the depth only variants of the programs which have one
+	static void setDepthPass(bool depthPass);
+	static bool isDepthPass();
 	void updateUniform(const GLchar * name, glm::mat4 m);
 	void updateUniform(const GLchar * name, glm::vec4 v);
 	void updateUniform(const GLchar* name, glm::vec3 v);
+	void updateUniform(const GLchar* name, glm::vec2 v);
 	void updateUniform(const GLchar * name, float f);
 	void updateUniform(const GLchar * name, int i);
+	void updateUniform(const GLchar * name, const glm::vec4* v, int count);
+	void updateUniform(const GLchar * name, const int* v, int count);
 
 private:
 	GLuint createShader(const char* path, GLenum type);
 	void loadFromSource(const char* path, GLuint shaderID);
 
 	GLint findUniform(const GLchar * name);
+	//depth only variants lack the uniforms of the full fragment shader, so missing ones are not reported
+	GLint findDepthUniform(const GLchar* name);
 
 	void checkShaderStatus(GLuint shaderID);
 
 	void checkProgramStatus(GLuint programID);
 
 	GLuint m_program;
-	const char* m_vertexPath;
-	const char* m_fragmentPath;
-	const char* m_geometryPath;
+	GLuint m_depthProgram = 0;
+	const char* m_vertexPath = nullptr;
+	const char* m_fragmentPath = nullptr;
+	const char* m_geometryPath = nullptr;
+	static bool s_depthPass;
 };
\ No newline at end of file